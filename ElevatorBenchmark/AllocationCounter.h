@@ -0,0 +1,6 @@
+#pragma once
+#include <cstddef>
+
+//Counts every allocation made through the global operator new, which AllocationCounter.cpp replaces.
+//Only linked into the benchmark, so the simulation itself does not pay for the count.
+size_t getAllocationCount();
@@ -0,0 +1,22 @@
+#include "stdafx.h"
+#include "BenchmarkTimer.h"
+#include "AllocationCounter.h"
+
+
+BenchmarkTimer::BenchmarkTimer() :
+	elapsedTime(0),
+	startAllocationCount(0),
+	allocationCount(0),
+	bytesProcessed(0)
+{
+}
+
+void BenchmarkTimer::start() {
+	startAllocationCount = ::getAllocationCount();
+	startTime = std::chrono::steady_clock::now();
+}
+
+void BenchmarkTimer::stop() {
+	elapsedTime += std::chrono::steady_clock::now() - startTime;
+	allocationCount += ::getAllocationCount() - startAllocationCount;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+
+//Times the measured part of a benchmark, and counts the allocations made in it.
+//start and stop can be called several times, so that setup between the measured parts is left out.
+class BenchmarkTimer
+{
+	public:
+		BenchmarkTimer();
+
+		void start();
+		void stop();
+		double getElapsedSeconds() const;
+		size_t getAllocationCount() const;
+		void addBytesProcessed(size_t byteCount);		//For benchmarks that read through a buffer, so their throughput can be printed
+		size_t getBytesProcessed() const;
+
+	private:
+		std::chrono::steady_clock::time_point startTime;
+		std::chrono::duration<double> elapsedTime;
+		size_t startAllocationCount;
+		size_t allocationCount;
+		size_t bytesProcessed;
+};
+
+//Inline member functions
+inline double BenchmarkTimer::getElapsedSeconds() const {
+	return elapsedTime.count();
+}
+
+inline size_t BenchmarkTimer::getAllocationCount() const {
+	return allocationCount;
+}
+
+inline void BenchmarkTimer::addBytesProcessed(size_t byteCount) {
+	bytesProcessed += byteCount;
+}
+
+inline size_t BenchmarkTimer::getBytesProcessed() const {
+	return bytesProcessed;
+}
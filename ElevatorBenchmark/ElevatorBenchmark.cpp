@@ -0,0 +1,724 @@
+// ElevatorBenchmark.cpp : Microbenchmarks for the shaft, controller and display hot paths.
+//
+
+#include "stdafx.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "ElevatorState.h"
+#include "ElevatorShaft.h"
+#include "ElevatorController.h"
+#include "HallCallSet.h"
+#include "SimulationStateDisplay.h"
+#include "BenchmarkTimer.h"
+#include "NullStream.h"
+#include "ScriptParser.h"
+#include "TrafficGenerator.h"
+#include "EventLog.h"
+#include "EventLogReplay.h"
+
+
+#define MINIMUM_BENCHMARK_SECONDS 0.05	//Each benchmark is repeated with more operations until it runs for at least this long
+#define MAXIMUM_OPERATIONS 100000000
+#define BENCHMARK_SEED 20170404
+#define RANDOM_TABLE_SIZE 4096			//Random floors are drawn before timing, and reused in a loop
+#define TICK_REFILL_INTERVAL 16			//How many ticks between giving every shaft a new request in the tick benchmark
+#define BRANCH_PREFIX_TICKS 1000		//Ticks simulated before the checkpoint that the branches fork from
+#define BRANCH_TICKS 50					//Ticks simulated by each branch
+#define ALLOCATION_CHECK_WARMUP_TICKS 10000	//Ticks for the buffers to grow to what the traffic needs, before allocations are counted
+#define ALLOCATION_CHECK_TICKS 10000		//Ticks that must not allocate
+#define ALLOCATION_CHECK_ARRIVALS_PER_SHAFT 0.1	//Peak passengers per tick for each shaft
+#define ALLOCATION_CHECK_WORKER_THREADS 4		//Each case is also checked with the shafts ticked on this many threads
+#define REPLAY_CHECK_TICKS 20000			//Ticks recorded for the replay check, spanning several stored checkpoints
+#define REPLAY_CHECK_SEEKS 8				//Random ticks sought, besides the first tick, the last and those either side of the first stored checkpoint
+#define REPLAY_CHECK_STORED_TICK 4096		//The first checkpoint stored beside the log, at the log's checkpoint interval
+#define REPLAY_CHECK_LOG_PATH "ElevatorBenchmarkReplayCheck.log"	//Written to the working directory, and removed with its checkpoints afterwards
+
+//A benchmark performs operationCount operations, timing only the operations themselves
+typedef void(*BenchmarkFunction)(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer);
+
+//Stops the compiler from removing work whose result is otherwise unused
+volatile int benchmarkSink;
+
+//Random floors for the benchmark loops, so drawing them is not timed
+std::vector<int> makeRandomFloors(int numberOfFloors) {
+	std::mt19937 randomGenerator(BENCHMARK_SEED);
+	std::uniform_int_distribution<int> floorDistribution(0, numberOfFloors - 1);
+	std::vector<int> randomFloors(RANDOM_TABLE_SIZE);
+	for (size_t i = 0; i < randomFloors.size(); i++) {
+		randomFloors[i] = floorDistribution(randomGenerator);
+	}
+	return randomFloors;
+}
+
+std::vector<Elevator::ElevatorShaft> makeShafts(const Elevator::SimulationSettings& simulationSettings) {
+	std::vector<Elevator::ElevatorShaft> elevatorShafts;
+	for (int i = 0; i < simulationSettings.numberOfShafts; i++) {
+		elevatorShafts.push_back(Elevator::ElevatorShaft(i, simulationSettings.numberOfFloors));
+	}
+	return elevatorShafts;
+}
+
+//Gives each shaft a quarter of the floors as stops, then moves them part of the way, so they are spread over the building
+void spreadShafts(std::vector<Elevator::ElevatorShaft>& elevatorShafts, const std::vector<int>& randomFloors, int numberOfFloors) {
+	size_t randomIndex = 0;
+	for (size_t i = 0; i < elevatorShafts.size(); i++) {
+		for (int j = 0; j < numberOfFloors / 4 + 1; j++) {
+			elevatorShafts[i].requestFloor(randomFloors[randomIndex++ % randomFloors.size()]);
+		}
+		for (size_t j = 0; j < i % numberOfFloors; j++) {
+			elevatorShafts[i].gotoNextFloorInQueue();
+		}
+	}
+}
+
+//One operation moves one shaft one floor. A shaft that has stopped is sent to the other end of the building.
+void benchmarkGotoNextFloorInQueue(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<Elevator::ElevatorShaft> elevatorShafts = makeShafts(simulationSettings);
+	int topFloor = simulationSettings.numberOfFloors - 1;
+
+	benchmarkTimer.start();
+	for (size_t i = 0; i < operationCount; i++) {
+		Elevator::ElevatorShaft& elevatorShaft = elevatorShafts[i % elevatorShafts.size()];
+		elevatorShaft.gotoNextFloorInQueue();
+		if (elevatorShaft.getCurrentMovementStatus() == Elevator::MovementStatus::Waiting) {
+			elevatorShaft.requestFloor(elevatorShaft.getCurrentPosition() == 0 ? topFloor : 0);
+		}
+	}
+	benchmarkTimer.stop();
+}
+
+//One operation requests a random floor from one shaft. The stop sets fill up, so most requests are for floors already requested.
+void benchmarkRequestFloor(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<Elevator::ElevatorShaft> elevatorShafts = makeShafts(simulationSettings);
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+
+	benchmarkTimer.start();
+	for (size_t i = 0; i < operationCount; i++) {
+		elevatorShafts[i % elevatorShafts.size()].requestFloor(randomFloors[i % randomFloors.size()]);
+	}
+	benchmarkTimer.stop();
+}
+
+//One operation costs a random floor for one shaft, with the shafts spread over the building
+void benchmarkCostToVisitFloor(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<Elevator::ElevatorShaft> elevatorShafts = makeShafts(simulationSettings);
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+	spreadShafts(elevatorShafts, randomFloors, simulationSettings.numberOfFloors);
+
+	int totalCost = 0;
+	benchmarkTimer.start();
+	for (size_t i = 0; i < operationCount; i++) {
+		totalCost += elevatorShafts[i % elevatorShafts.size()].costToVisitFloor(randomFloors[i % randomFloors.size()]);
+	}
+	benchmarkTimer.stop();
+	benchmarkSink = totalCost;
+}
+
+//One operation looks up the ETA to a random floor and direction for one shaft, with the shafts spread over the building
+void benchmarkEtaToMeetCall(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<Elevator::ElevatorShaft> elevatorShafts = makeShafts(simulationSettings);
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+	spreadShafts(elevatorShafts, randomFloors, simulationSettings.numberOfFloors);
+
+	int totalEta = 0;
+	benchmarkTimer.start();
+	for (size_t i = 0; i < operationCount; i++) {
+		totalEta += elevatorShafts[i % elevatorShafts.size()].etaToMeetCall(randomFloors[i % randomFloors.size()],
+			i % 2 == 0 ? Elevator::MovementDirection::Up : Elevator::MovementDirection::Down);
+	}
+	benchmarkTimer.stop();
+	benchmarkSink = totalEta;
+}
+
+//One operation finds the call ahead of a random floor in a random direction, up to the end of the building, with calls on one floor in 16.
+//The shafts are not used, as every shaft searches the same calls.
+void benchmarkFindCallAhead(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+	Elevator::HallCallSet hallCalls(simulationSettings.numberOfFloors);
+	for (int i = 0; i < simulationSettings.numberOfFloors / 16 + 1; i++) {
+		hallCalls.call(randomFloors[i], i % 2 == 0 ? Elevator::MovementDirection::Up : Elevator::MovementDirection::Down);
+	}
+	int topFloor = simulationSettings.numberOfFloors - 1;
+
+	int totalFloors = 0;
+	benchmarkTimer.start();
+	for (size_t i = 0; i < operationCount; i++) {
+		int position = randomFloors[i % randomFloors.size()];
+		if (i % 2 == 0) {
+			totalFloors += hallCalls.findCallAhead(position, Elevator::MovementDirection::Up, topFloor);
+		}
+		else {
+			totalFloors += hallCalls.findCallAhead(position, Elevator::MovementDirection::Down, 0);
+		}
+	}
+	benchmarkTimer.stop();
+	benchmarkSink = totalFloors;
+}
+
+//Creates a headless controller, with the shafts spread over the building
+std::unique_ptr<Elevator::ElevatorController> makeController(const Elevator::SimulationSettings& simulationSettings, const std::vector<int>& randomFloors) {
+	std::unique_ptr<Elevator::ElevatorController> controllerPtr(new Elevator::ElevatorController(simulationSettings));
+	controllerPtr->setDisplayEnabled(false);
+	for (int i = 0; i < simulationSettings.numberOfShafts; i++) {
+		controllerPtr->requestFloor(i, randomFloors[i % randomFloors.size()]);
+	}
+	controllerPtr->simulationTick(static_cast<size_t>(simulationSettings.numberOfFloors / 2));
+	return controllerPtr;
+}
+
+//One operation calls an elevator to a random floor, alternating directions
+void benchmarkCallElevator(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+	std::unique_ptr<Elevator::ElevatorController> controllerPtr = makeController(simulationSettings, randomFloors);
+
+	benchmarkTimer.start();
+	for (size_t i = 0; i < operationCount; i++) {
+		controllerPtr->callElevator(randomFloors[i % randomFloors.size()], i % 2 == 0 ? Elevator::MovementDirection::Up : Elevator::MovementDirection::Down);
+	}
+	benchmarkTimer.stop();
+}
+
+//The same as benchmarkCallElevator, with the controller using another dispatch policy than the default
+template <Elevator::DispatchPolicyType dispatchPolicy>
+void benchmarkCallElevatorWithPolicy(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	Elevator::SimulationSettings policySettings = simulationSettings;
+	policySettings.dispatchPolicy = dispatchPolicy;
+	benchmarkCallElevator(policySettings, operationCount, benchmarkTimer);
+}
+
+//One operation is a whole tick. Every few ticks, each shaft is given a new request, which is not timed.
+void benchmarkSimulationTick(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+	std::unique_ptr<Elevator::ElevatorController> controllerPtr = makeController(simulationSettings, randomFloors);
+
+	size_t randomIndex = 0;
+	for (size_t i = 0; i < operationCount; i++) {
+		if (i % TICK_REFILL_INTERVAL == 0) {
+			for (int shaft = 0; shaft < simulationSettings.numberOfShafts; shaft++) {
+				controllerPtr->requestFloor(shaft, randomFloors[randomIndex++ % randomFloors.size()]);
+			}
+		}
+
+		benchmarkTimer.start();
+		controllerPtr->simulationTick();
+		benchmarkTimer.stop();
+	}
+}
+
+//One operation builds and writes the whole display into a stream that discards it
+void benchmarkDisplayState(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+	std::unique_ptr<Elevator::ElevatorController> controllerPtr = makeController(simulationSettings, randomFloors);
+	NullStream nullStream;
+	SimulationStateDisplay simulationStateDisplay(simulationSettings, nullStream);
+
+	benchmarkTimer.start();
+	for (size_t i = 0; i < operationCount; i++) {
+		simulationStateDisplay.displayState(controllerPtr->getCurrentState());
+	}
+	benchmarkTimer.stop();
+}
+
+//One operation parses a script line, cycling through a buffer of Call, RequestFloor, Passenger and Tick lines.
+//The building only sets the range of the numbers in the lines, so this runs once, for the largest building.
+void benchmarkParseScriptLine(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+	std::string scriptBuffer;
+	std::vector<size_t> lineStarts;
+	for (size_t i = 0; i < randomFloors.size(); i++) {
+		int floor = randomFloors[i] + 1;
+		int otherFloor = randomFloors[(i + 1) % randomFloors.size()] + 1;
+		lineStarts.push_back(scriptBuffer.size());
+		switch (i % 4) {
+		case 0:
+			scriptBuffer += "Call " + std::to_string(floor) + (i % 8 == 0 ? " Up" : " Down");
+			break;
+		case 1:
+			scriptBuffer += "RequestFloor " + std::to_string(i % simulationSettings.numberOfShafts) + " " + std::to_string(floor);
+			break;
+		case 2:
+			scriptBuffer += "Passenger " + std::to_string(floor) + " " + std::to_string(otherFloor);
+			break;
+		default:
+			scriptBuffer += "Tick " + std::to_string(i % 16);
+			break;
+		}
+		scriptBuffer += '\n';
+	}
+	lineStarts.push_back(scriptBuffer.size());
+
+	ScriptParser scriptParser;
+	ScriptCommand scriptCommand;
+	size_t commandCount = 0;
+	size_t lineCount = lineStarts.size() - 1;
+	size_t line = 0;
+	benchmarkTimer.start();
+	for (size_t i = 0; i < operationCount; i++) {
+		const char* lineBegin = scriptBuffer.data() + lineStarts[line];
+		const char* lineEnd = scriptBuffer.data() + lineStarts[line + 1] - 1;
+		commandCount += scriptParser.parseLine(lineBegin, lineEnd, scriptCommand) == ScriptLineType::Command ? 1 : 0;
+		line = line + 1 == lineCount ? 0 : line + 1;
+	}
+	benchmarkTimer.stop();
+
+	//Whole passes through the buffer, plus the lines of the last partial pass, including their newlines
+	benchmarkTimer.addBytesProcessed(operationCount / lineCount * scriptBuffer.size() + lineStarts[operationCount % lineCount]);
+
+	//Every line is valid, and using the count stops the parsing being optimised away
+	if (commandCount != operationCount) {
+		std::cerr << "parseScriptLine rejected a valid line" << std::endl;
+	}
+}
+
+//One operation copies what the display shows out of the state, as the simulation thread does for the render thread after each tick
+void benchmarkCaptureSnapshot(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+	std::unique_ptr<Elevator::ElevatorController> controllerPtr = makeController(simulationSettings, randomFloors);
+	DisplaySnapshot displaySnapshot;
+	displaySnapshot.capture(controllerPtr->getCurrentState());
+
+	benchmarkTimer.start();
+	for (size_t i = 0; i < operationCount; i++) {
+		displaySnapshot.capture(controllerPtr->getCurrentState());
+	}
+	benchmarkTimer.stop();
+}
+
+#ifndef _WIN32
+//One operation ticks the controller, then redraws only what changed. Only the redraw is timed.
+//The Windows console redraw moves the real console cursor, so it is not benchmarked there.
+void benchmarkRefreshDisplay(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+	std::unique_ptr<Elevator::ElevatorController> controllerPtr = makeController(simulationSettings, randomFloors);
+	NullStream nullStream;
+	SimulationStateDisplay simulationStateDisplay(simulationSettings, nullStream);
+	simulationStateDisplay.displayState(controllerPtr->getCurrentState());
+
+	size_t randomIndex = 0;
+	for (size_t i = 0; i < operationCount; i++) {
+		if (i % TICK_REFILL_INTERVAL == 0) {
+			for (int shaft = 0; shaft < simulationSettings.numberOfShafts; shaft++) {
+				controllerPtr->requestFloor(shaft, randomFloors[randomIndex++ % randomFloors.size()]);
+			}
+		}
+		controllerPtr->simulationTick();
+
+		benchmarkTimer.start();
+		simulationStateDisplay.refreshDisplay(controllerPtr->getCurrentState());
+		benchmarkTimer.stop();
+	}
+}
+
+//Passes each batch of changes to the display, timing only the display
+class TimedDisplayListener : public Elevator::SimulationEventListener {
+	public:
+		TimedDisplayListener(SimulationStateDisplay& simulationStateDisplay, BenchmarkTimer& benchmarkTimer) :
+			simulationStateDisplay(simulationStateDisplay),
+			benchmarkTimer(benchmarkTimer)
+		{
+		}
+
+		void simulationEventsPublished(const Elevator::SimulationEventBatch& eventBatch, const Elevator::SimulationState& simulationState) override {
+			benchmarkTimer.start();
+			simulationStateDisplay.simulationEventsPublished(eventBatch, simulationState);
+			benchmarkTimer.stop();
+		}
+
+	private:
+		SimulationStateDisplay& simulationStateDisplay;
+		BenchmarkTimer& benchmarkTimer;
+};
+
+//The same as refreshDisplay, but the display is a listener that only rebuilds the cells the tick's changes touched
+void benchmarkDisplayEvents(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+	std::unique_ptr<Elevator::ElevatorController> controllerPtr = makeController(simulationSettings, randomFloors);
+	NullStream nullStream;
+	SimulationStateDisplay simulationStateDisplay(simulationSettings, nullStream);
+	simulationStateDisplay.displayState(controllerPtr->getCurrentState());
+
+	size_t randomIndex = 0;
+	for (size_t i = 0; i < operationCount; i++) {
+		if (i % TICK_REFILL_INTERVAL == 0) {
+			for (int shaft = 0; shaft < simulationSettings.numberOfShafts; shaft++) {
+				controllerPtr->requestFloor(shaft, randomFloors[randomIndex++ % randomFloors.size()]);
+			}
+		}
+
+		//Only the batch published by the tick is timed
+		TimedDisplayListener timedDisplayListener(simulationStateDisplay, benchmarkTimer);
+		controllerPtr->addEventListener(&timedDisplayListener);
+		controllerPtr->simulationTick();
+		controllerPtr->removeEventListener(&timedDisplayListener);
+	}
+}
+#endif
+
+//Simulates ticks with a new request for every shaft every few ticks, continuing the random floors from randomIndex
+void simulateWithRequests(Elevator::ElevatorController& controller, size_t numberOfTicks, const std::vector<int>& randomFloors, size_t& randomIndex) {
+	for (size_t i = 0; i < numberOfTicks; i++) {
+		if (controller.getCurrentTick() % TICK_REFILL_INTERVAL == 0) {
+			for (size_t shaft = 0; shaft < controller.getCurrentState().elevatorShaftVector.size(); shaft++) {
+				controller.requestFloor(static_cast<int>(shaft), randomFloors[randomIndex++ % randomFloors.size()]);
+			}
+		}
+		controller.simulationTick();
+	}
+}
+
+//One operation saves the whole simulation into a checkpoint that is reused
+void benchmarkSaveCheckpoint(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+	std::unique_ptr<Elevator::ElevatorController> controllerPtr = makeController(simulationSettings, randomFloors);
+	Elevator::SimulationCheckpoint checkpoint;
+	controllerPtr->saveCheckpoint(checkpoint);
+
+	benchmarkTimer.start();
+	for (size_t i = 0; i < operationCount; i++) {
+		controllerPtr->saveCheckpoint(checkpoint);
+	}
+	benchmarkTimer.stop();
+	benchmarkSink = static_cast<int>(checkpoint.size());
+}
+
+//One operation restores the whole simulation from a checkpoint
+void benchmarkRestoreCheckpoint(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+	std::unique_ptr<Elevator::ElevatorController> controllerPtr = makeController(simulationSettings, randomFloors);
+	Elevator::SimulationCheckpoint checkpoint;
+	controllerPtr->saveCheckpoint(checkpoint);
+
+	benchmarkTimer.start();
+	for (size_t i = 0; i < operationCount; i++) {
+		controllerPtr->restoreCheckpoint(checkpoint);
+	}
+	benchmarkTimer.stop();
+}
+
+//One operation is a what-if branch: restore the checkpoint taken after the prefix, then simulate the branch's ticks
+void benchmarkForkBranch(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+	std::unique_ptr<Elevator::ElevatorController> controllerPtr = makeController(simulationSettings, randomFloors);
+	size_t randomIndex = 0;
+	simulateWithRequests(*controllerPtr, BRANCH_PREFIX_TICKS, randomFloors, randomIndex);
+	Elevator::SimulationCheckpoint checkpoint;
+	controllerPtr->saveCheckpoint(checkpoint);
+
+	benchmarkTimer.start();
+	for (size_t i = 0; i < operationCount; i++) {
+		controllerPtr->restoreCheckpoint(checkpoint);
+		size_t branchRandomIndex = i;
+		simulateWithRequests(*controllerPtr, BRANCH_TICKS, randomFloors, branchRandomIndex);
+	}
+	benchmarkTimer.stop();
+}
+
+//One operation is the same branch without a checkpoint: a new controller simulates the prefix again, then the branch's ticks
+void benchmarkResimulateBranch(const Elevator::SimulationSettings& simulationSettings, size_t operationCount, BenchmarkTimer& benchmarkTimer) {
+	std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+
+	benchmarkTimer.start();
+	for (size_t i = 0; i < operationCount; i++) {
+		std::unique_ptr<Elevator::ElevatorController> controllerPtr = makeController(simulationSettings, randomFloors);
+		size_t randomIndex = 0;
+		simulateWithRequests(*controllerPtr, BRANCH_PREFIX_TICKS, randomFloors, randomIndex);
+		size_t branchRandomIndex = i;
+		simulateWithRequests(*controllerPtr, BRANCH_TICKS, randomFloors, branchRandomIndex);
+	}
+	benchmarkTimer.stop();
+}
+
+//Runs lunch time traffic, with a display listening to each tick and another redrawing from a snapshot as the render thread does.
+//After the warm up, every buffer has grown to what the traffic needs, so the steady state ticks should not allocate at all.
+//Returns how many allocations the counted ticks made, and sets stateCopyCount to how many times they copied the state, on any thread.
+size_t countSteadyStateAllocations(const Elevator::SimulationSettings& simulationSettings, size_t workerThreadCount, size_t& stateCopyCount) {
+	std::unique_ptr<Elevator::ElevatorController> controllerPtr(new Elevator::ElevatorController(simulationSettings));
+	controllerPtr->setDisplayEnabled(false);
+	controllerPtr->setWorkerThreadCount(workerThreadCount);
+	Elevator::TrafficGenerator trafficGenerator(simulationSettings.numberOfFloors, Elevator::TrafficGenerator::lunchProfile(),
+		ALLOCATION_CHECK_ARRIVALS_PER_SHAFT * simulationSettings.numberOfShafts, BENCHMARK_SEED);
+	Elevator::PassengerArrival passengerArrival;
+	bool hasArrival = trafficGenerator.next(passengerArrival);
+
+#ifndef _WIN32
+	NullStream nullStream;
+	SimulationStateDisplay listeningDisplay(simulationSettings, nullStream);
+	SimulationStateDisplay snapshotDisplay(simulationSettings, nullStream);
+	DisplaySnapshot displaySnapshot;
+	controllerPtr->addEventListener(&listeningDisplay);
+#endif
+
+	BenchmarkTimer benchmarkTimer;
+	size_t copyCountBeforeCheck = 0;
+	for (size_t tick = 0; tick < ALLOCATION_CHECK_WARMUP_TICKS + ALLOCATION_CHECK_TICKS; tick++) {
+		if (tick == ALLOCATION_CHECK_WARMUP_TICKS) {
+			copyCountBeforeCheck = Elevator::StateCopyCounter::getCopyCount();
+			benchmarkTimer.start();
+		}
+
+		while (hasArrival && passengerArrival.tick <= tick) {
+			controllerPtr->addPassenger(passengerArrival.originFloor, passengerArrival.destinationFloor);
+			hasArrival = trafficGenerator.next(passengerArrival);
+		}
+		controllerPtr->simulationTick();
+
+#ifndef _WIN32
+		displaySnapshot.capture(controllerPtr->getCurrentState());
+		snapshotDisplay.refreshDisplay(displaySnapshot);
+#endif
+	}
+	benchmarkTimer.stop();
+	stateCopyCount = Elevator::StateCopyCounter::getCopyCount() - copyCountBeforeCheck;
+
+#ifndef _WIN32
+	controllerPtr->removeEventListener(&listeningDisplay);
+#endif
+	return benchmarkTimer.getAllocationCount();
+}
+
+//True if both checkpoints hold exactly the same state
+bool isSameCheckpoint(const Elevator::SimulationCheckpoint& firstCheckpoint, const Elevator::SimulationCheckpoint& secondCheckpoint) {
+	return firstCheckpoint.size() == secondCheckpoint.size() && memcmp(firstCheckpoint.getBytes(), secondCheckpoint.getBytes(), firstCheckpoint.size()) == 0;
+}
+
+//Records a session of traffic, hall calls and floor requests, saving the state at each of seekTicks as it goes.
+//Then checks that a new replay seeking straight to each tick, starting from the checkpoints stored beside the log, reaches the same state
+//as one that replays every record up to it, and as one replay seeking back and forth between the ticks from its own checkpoints.
+//Returns how many states did not match, and sets storedRestoreCount to how many seeks started from a stored checkpoint.
+size_t countReplaySeekMismatches(const Elevator::SimulationSettings& simulationSettings, size_t& storedRestoreCount) {
+	std::mt19937 randomGenerator(BENCHMARK_SEED);
+	std::vector<size_t> seekTicks = { 0, REPLAY_CHECK_STORED_TICK - 1, REPLAY_CHECK_STORED_TICK, REPLAY_CHECK_TICKS };
+	std::uniform_int_distribution<size_t> tickDistribution(0, REPLAY_CHECK_TICKS);
+	for (size_t i = 0; i < REPLAY_CHECK_SEEKS; i++) {
+		seekTicks.push_back(tickDistribution(randomGenerator));
+	}
+	std::sort(seekTicks.begin(), seekTicks.end());
+	seekTicks.erase(std::unique(seekTicks.begin(), seekTicks.end()), seekTicks.end());
+
+	std::vector<Elevator::SimulationCheckpoint> recordedCheckpoints(seekTicks.size());
+	{
+		Elevator::ElevatorController controller(simulationSettings);
+		controller.setDisplayEnabled(false);
+		Elevator::EventLogWriter eventLogWriter;
+		if (!eventLogWriter.open(REPLAY_CHECK_LOG_PATH, simulationSettings)) {
+			return seekTicks.size();
+		}
+		controller.setEventLogWriter(&eventLogWriter);
+
+		Elevator::TrafficGenerator trafficGenerator(simulationSettings.numberOfFloors, Elevator::TrafficGenerator::lunchProfile(),
+			ALLOCATION_CHECK_ARRIVALS_PER_SHAFT * simulationSettings.numberOfShafts, BENCHMARK_SEED);
+		Elevator::PassengerArrival passengerArrival;
+		bool hasArrival = trafficGenerator.next(passengerArrival);
+		std::vector<int> randomFloors = makeRandomFloors(simulationSettings.numberOfFloors);
+		size_t randomIndex = 0;
+		size_t seekIndex = 0;
+		for (size_t tick = 0; tick <= REPLAY_CHECK_TICKS; tick++) {
+			while (hasArrival && passengerArrival.tick <= tick) {
+				controller.addPassenger(passengerArrival.originFloor, passengerArrival.destinationFloor);
+				hasArrival = trafficGenerator.next(passengerArrival);
+			}
+			if (tick % TICK_REFILL_INTERVAL == 0) {
+				int floor = randomFloors[randomIndex++ % randomFloors.size()];
+				controller.callElevator(floor, floor == simulationSettings.numberOfFloors - 1 ? Elevator::MovementDirection::Down : Elevator::MovementDirection::Up);
+				int shaft = randomFloors[randomIndex++ % randomFloors.size()] % simulationSettings.numberOfShafts;
+				controller.requestFloor(shaft, randomFloors[randomIndex++ % randomFloors.size()]);
+			}
+
+			//A replay to a tick stops after that tick's records, before simulating it
+			if (seekIndex < seekTicks.size() && seekTicks[seekIndex] == tick) {
+				controller.saveCheckpoint(recordedCheckpoints[seekIndex++]);
+			}
+			if (tick < REPLAY_CHECK_TICKS) {
+				controller.simulationTick();
+			}
+		}
+		controller.setEventLogWriter(nullptr);
+		eventLogWriter.close(REPLAY_CHECK_TICKS);
+	}
+
+	size_t mismatchCount = 0;
+	storedRestoreCount = 0;
+	Elevator::EventLogReader eventLogReader;
+	if (!eventLogReader.open(REPLAY_CHECK_LOG_PATH)) {
+		mismatchCount = seekTicks.size();
+	}
+	Elevator::SimulationCheckpoint replayedCheckpoint;
+	for (size_t i = 0; i < seekTicks.size() && mismatchCount < seekTicks.size(); i++) {
+		Elevator::ElevatorController fullReplayController(simulationSettings);
+		EventLogReplay fullReplay(&fullReplayController, &eventLogReader);
+		fullReplay.replayTo(seekTicks[i]);
+		fullReplayController.saveCheckpoint(replayedCheckpoint);
+		mismatchCount += isSameCheckpoint(replayedCheckpoint, recordedCheckpoints[i]) ? 0 : 1;
+
+		Elevator::ElevatorController seekController(simulationSettings);
+		EventLogReplay seekReplay(&seekController, &eventLogReader);
+		seekReplay.seekTo(seekTicks[i]);
+		seekController.saveCheckpoint(replayedCheckpoint);
+		mismatchCount += isSameCheckpoint(replayedCheckpoint, recordedCheckpoints[i]) ? 0 : 1;
+		storedRestoreCount += seekReplay.getStoredCheckpointsRestored();
+	}
+
+	//The same replay seeks forwards past some ticks and back to others, restoring its own checkpoints as well as the stored ones
+	std::vector<size_t> seekOrder(seekTicks.size());
+	for (size_t i = 0; i < seekOrder.size(); i++) {
+		seekOrder[i] = i;
+	}
+	std::shuffle(seekOrder.begin(), seekOrder.end(), randomGenerator);
+	if (mismatchCount < seekTicks.size()) {
+		Elevator::ElevatorController controller(simulationSettings);
+		EventLogReplay eventLogReplay(&controller, &eventLogReader);
+		for (size_t seekIndex : seekOrder) {
+			eventLogReplay.seekTo(seekTicks[seekIndex]);
+			controller.saveCheckpoint(replayedCheckpoint);
+			mismatchCount += isSameCheckpoint(replayedCheckpoint, recordedCheckpoints[seekIndex]) ? 0 : 1;
+		}
+	}
+
+	eventLogReader.close();
+	remove(REPLAY_CHECK_LOG_PATH);
+	remove(Elevator::getEventLogCheckpointPath(REPLAY_CHECK_LOG_PATH).c_str());
+	return mismatchCount;
+}
+
+//Runs a benchmark with more and more operations until it takes long enough to time, then prints ns/op and allocations/op, and MB/s for those that read a buffer
+void runBenchmark(const std::string& benchmarkName, BenchmarkFunction benchmarkFunction, const Elevator::SimulationSettings& simulationSettings) {
+	size_t operationCount = 1;
+	BenchmarkTimer benchmarkTimer;
+	while (true) {
+		benchmarkTimer = BenchmarkTimer();
+		benchmarkFunction(simulationSettings, operationCount, benchmarkTimer);
+
+		double elapsedSeconds = benchmarkTimer.getElapsedSeconds();
+		if (elapsedSeconds >= MINIMUM_BENCHMARK_SECONDS || operationCount >= MAXIMUM_OPERATIONS) {
+			break;
+		}
+
+		//Aim a little past the minimum time, growing by at most 10 times, as short runs are not a reliable estimate
+		double scale = elapsedSeconds > 0 ? 1.2 * MINIMUM_BENCHMARK_SECONDS / elapsedSeconds : 10;
+		scale = std::min(std::max(scale, 2.0), 10.0);
+		operationCount = std::min(static_cast<size_t>(operationCount * scale), static_cast<size_t>(MAXIMUM_OPERATIONS));
+	}
+
+	std::cout << std::left << std::setw(24) << benchmarkName << std::right
+		<< std::setw(8) << simulationSettings.numberOfFloors
+		<< std::setw(8) << simulationSettings.numberOfShafts
+		<< std::setw(14) << std::fixed << std::setprecision(1) << benchmarkTimer.getElapsedSeconds() * 1e9 / operationCount
+		<< std::setw(14) << std::setprecision(3) << static_cast<double>(benchmarkTimer.getAllocationCount()) / operationCount
+		<< std::setw(12) << operationCount;
+	if (benchmarkTimer.getBytesProcessed() > 0) {
+		std::cout << std::setw(10) << std::setprecision(1) << benchmarkTimer.getBytesProcessed() / benchmarkTimer.getElapsedSeconds() / 1e6;
+	}
+	std::cout << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	//An optional argument only runs the benchmarks whose name contains it
+	std::string benchmarkFilter = argc > 1 ? argv[1] : "";
+
+	struct NamedBenchmark {
+		const char* name;
+		BenchmarkFunction benchmarkFunction;
+		bool largestBuildingOnly;				//Runs once, for the largest building, as the building barely changes the work
+	};
+	const NamedBenchmark benchmarks[] = {
+		{ "gotoNextFloorInQueue", benchmarkGotoNextFloorInQueue, false },
+		{ "requestFloor", benchmarkRequestFloor, false },
+		{ "costToVisitFloor", benchmarkCostToVisitFloor, false },
+		{ "etaToMeetCall", benchmarkEtaToMeetCall, false },
+		{ "findCallAhead", benchmarkFindCallAhead, false },
+		{ "callElevator", benchmarkCallElevator, false },
+		{ "callElevatorNearestCar", benchmarkCallElevatorWithPolicy<Elevator::DispatchPolicyType::NearestCar>, false },
+		{ "callElevatorStops", benchmarkCallElevatorWithPolicy<Elevator::DispatchPolicyType::Stops>, false },
+		{ "callElevatorLeastLoaded", benchmarkCallElevatorWithPolicy<Elevator::DispatchPolicyType::LeastLoaded>, false },
+		{ "callElevatorDestination", benchmarkCallElevatorWithPolicy<Elevator::DispatchPolicyType::Destination>, false },
+		{ "simulationTick", benchmarkSimulationTick, false },
+		{ "saveCheckpoint", benchmarkSaveCheckpoint, false },
+		{ "restoreCheckpoint", benchmarkRestoreCheckpoint, false },
+		{ "forkBranch", benchmarkForkBranch, false },
+		{ "resimulateBranch", benchmarkResimulateBranch, false },
+		{ "displayState", benchmarkDisplayState, false },
+		{ "captureSnapshot", benchmarkCaptureSnapshot, false },
+		{ "parseScriptLine", benchmarkParseScriptLine, true },
+#ifndef _WIN32
+		{ "refreshDisplay", benchmarkRefreshDisplay, false },
+		{ "displayEvents", benchmarkDisplayEvents, false },
+#endif
+	};
+	const int floorCounts[] = { 10, 50, 200 };
+	const int shaftCounts[] = { 1, 16, 256 };
+
+	//--check-allocations checks that steady state ticks neither allocate nor copy the state, instead of running the benchmarks. It fails if any of them do.
+	//Unlike the assert in simulationTick, this also checks release builds.
+	if (benchmarkFilter == "--check-allocations") {
+		std::cout << std::left << std::setw(24) << "Allocation check" << std::right << std::setw(8) << "Floors" << std::setw(8) << "Shafts"
+			<< std::setw(9) << "Threads" << std::setw(14) << "Ticks" << std::setw(14) << "Allocations" << std::setw(14) << "State copies" << std::endl;
+
+		bool allocationFree = true;
+		for (int floors : floorCounts) {
+			for (int shafts : shaftCounts) {
+				for (size_t workerThreadCount : { static_cast<size_t>(1), static_cast<size_t>(ALLOCATION_CHECK_WORKER_THREADS) }) {
+					Elevator::SimulationSettings simulationSettings;
+					simulationSettings.numberOfFloors = floors;
+					simulationSettings.numberOfShafts = shafts;
+					size_t stateCopyCount = 0;
+					size_t allocationCount = countSteadyStateAllocations(simulationSettings, workerThreadCount, stateCopyCount);
+					allocationFree = allocationFree && allocationCount == 0 && stateCopyCount == 0;
+					std::cout << std::left << std::setw(24) << "steadyStateTick" << std::right << std::setw(8) << floors << std::setw(8) << shafts
+						<< std::setw(9) << workerThreadCount << std::setw(14) << ALLOCATION_CHECK_TICKS << std::setw(14) << allocationCount << std::setw(14) << stateCopyCount << std::endl;
+				}
+			}
+		}
+		return allocationFree ? 0 : 1;
+	}
+
+	//--check-replay checks that seeking a replay to a tick gives the same state as replaying the whole log up to it. It fails if any state differs.
+	if (benchmarkFilter == "--check-replay") {
+		std::cout << std::left << std::setw(24) << "Replay check" << std::right << std::setw(8) << "Floors" << std::setw(8) << "Shafts"
+			<< std::setw(14) << "Ticks" << std::setw(16) << "Stored restores" << std::setw(14) << "Mismatches" << std::endl;
+
+		bool replayMatches = true;
+		for (int floors : floorCounts) {
+			for (int shafts : shaftCounts) {
+				Elevator::SimulationSettings simulationSettings;
+				simulationSettings.numberOfFloors = floors;
+				simulationSettings.numberOfShafts = shafts;
+				size_t storedRestoreCount = 0;
+				size_t mismatchCount = countReplaySeekMismatches(simulationSettings, storedRestoreCount);
+				replayMatches = replayMatches && mismatchCount == 0 && storedRestoreCount > 0;
+				std::cout << std::left << std::setw(24) << "seekTo" << std::right << std::setw(8) << floors << std::setw(8) << shafts
+					<< std::setw(14) << REPLAY_CHECK_TICKS << std::setw(16) << storedRestoreCount << std::setw(14) << mismatchCount << std::endl;
+			}
+		}
+		return replayMatches ? 0 : 1;
+	}
+
+	std::cout << std::left << std::setw(24) << "Benchmark" << std::right << std::setw(8) << "Floors" << std::setw(8) << "Shafts"
+		<< std::setw(14) << "ns/op" << std::setw(14) << "allocs/op" << std::setw(12) << "Operations" << std::setw(10) << "MB/s" << std::endl;
+
+	for (const NamedBenchmark& benchmark : benchmarks) {
+		if (std::string(benchmark.name).find(benchmarkFilter) == std::string::npos) {
+			continue;
+		}
+
+		for (int floors : floorCounts) {
+			for (int shafts : shaftCounts) {
+				if (benchmark.largestBuildingOnly && (floors != floorCounts[2] || shafts != shaftCounts[2])) {
+					continue;
+				}
+
+				Elevator::SimulationSettings simulationSettings;
+				simulationSettings.numberOfFloors = floors;
+				simulationSettings.numberOfShafts = shafts;
+				runBenchmark(benchmark.name, benchmark.benchmarkFunction, simulationSettings);
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <ostream>
+#include <streambuf>
+
+//A stream buffer that accepts and discards everything, so output can be benchmarked without the cost of a terminal
+class NullStreamBuffer : public std::streambuf
+{
+	protected:
+		int_type overflow(int_type character) override {
+			return traits_type::not_eof(character);
+		}
+
+		std::streamsize xsputn(const char_type*, std::streamsize count) override {
+			return count;
+		}
+};
+
+//An output stream that discards everything written to it
+class NullStream : public std::ostream
+{
+	public:
+		NullStream() : std::ostream(&nullStreamBuffer) {}
+
+	private:
+		NullStreamBuffer nullStreamBuffer;
+};
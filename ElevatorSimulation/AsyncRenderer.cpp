@@ -0,0 +1,92 @@
+#include "stdafx.h"
+#include "AsyncRenderer.h"
+#include "Tracing.h"
+
+#define SNAPSHOT_RING_CAPACITY 4	//Enough for the render thread to hold one snapshot while the simulation fills the others
+
+
+AsyncRenderer::AsyncRenderer(SimulationStateDisplay& simulationStateDisplay, unsigned int framesPerSecond) :
+	simulationStateDisplay(simulationStateDisplay),
+	snapshotRing(SNAPSHOT_RING_CAPACITY),
+	frameInterval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::seconds(1)) / (framesPerSecond > 0 ? framesPerSecond : 1)),
+	stopping(false),
+	framesDrawn(0),
+	snapshotsDropped(0),
+	batchesSkipped(0)
+{
+}
+
+AsyncRenderer::~AsyncRenderer() {
+	//Stop without a final frame if stop was never called, e.g. when leaving early
+	stopping = true;
+	if (renderThread.joinable()) {
+		renderThread.join();
+	}
+}
+
+//Draws the state in full on the calling thread, then starts the render thread
+void AsyncRenderer::start(const Elevator::SimulationState& simulationState) {
+	simulationStateDisplay.displayState(simulationState);
+	stopping = false;
+	renderThread = std::thread(&AsyncRenderer::renderLoop, this);
+}
+
+//Publishes the final state, waiting for a free slot so that it is not skipped, then lets the render thread draw it and finish
+void AsyncRenderer::stop(const Elevator::SimulationState& simulationState, size_t tick) {
+	if (!renderThread.joinable()) {
+		return;
+	}
+	publishSnapshot(simulationState, tick, true);
+	stopping = true;
+	renderThread.join();
+}
+
+//Called on the simulation thread. Only the state is copied, as the display does not need the changes themselves.
+void AsyncRenderer::simulationEventsPublished(const Elevator::SimulationEventBatch& eventBatch, const Elevator::SimulationState& simulationState) {
+	publishSnapshot(simulationState, eventBatch.tick, false);
+}
+
+void AsyncRenderer::publishSnapshot(const Elevator::SimulationState& simulationState, size_t tick, bool waitForSlot) {
+	DisplaySnapshot* displaySnapshotPtr = snapshotRing.beginWrite();
+	while (!displaySnapshotPtr && waitForSlot) {
+		std::this_thread::yield();
+		displaySnapshotPtr = snapshotRing.beginWrite();
+	}
+	if (!displaySnapshotPtr) {
+		batchesSkipped++;
+		return;
+	}
+
+	displaySnapshotPtr->capture(simulationState);
+	displaySnapshotPtr->tick = tick;
+	snapshotRing.endWrite();
+}
+
+//Draws the newest snapshot once per frame. The stop flag is read before the ring, so the snapshot published by stop is always drawn.
+void AsyncRenderer::renderLoop() {
+	std::chrono::steady_clock::time_point nextFrameTime = std::chrono::steady_clock::now();
+	while (true) {
+		bool stopRequested = stopping.load();
+
+		snapshotsDropped += snapshotRing.skipToNewest();
+		const DisplaySnapshot* displaySnapshotPtr = snapshotRing.beginRead();
+		if (displaySnapshotPtr) {
+			TRACE_SCOPE("renderFrame");
+			simulationStateDisplay.refreshDisplay(*displaySnapshotPtr);
+			snapshotRing.endRead();
+			framesDrawn++;
+		}
+
+		if (stopRequested) {
+			break;
+		}
+
+		//Keep to the frame rate, without trying to catch up on frames missed while drawing
+		nextFrameTime += frameInterval;
+		std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
+		if (nextFrameTime < currentTime) {
+			nextFrameTime = currentTime;
+		}
+		std::this_thread::sleep_until(nextFrameTime);
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include "SimulationEvents.h"
+#include "SimulationStateDisplay.h"
+#include "SnapshotRing.h"
+
+//Draws the simulation on its own thread, so the simulation never waits for the console.
+//After each batch of changes, the simulation thread copies what the display shows into a free slot of a lock-free ring. If the ring is full,
+//the batch is skipped, as a newer one will follow. The render thread wakes at most framesPerSecond times a second, drops every snapshot but the newest,
+//and draws that one.
+class AsyncRenderer : public Elevator::SimulationEventListener
+{
+	public:
+		AsyncRenderer(SimulationStateDisplay& simulationStateDisplay, unsigned int framesPerSecond);
+		~AsyncRenderer();
+
+		void start(const Elevator::SimulationState& simulationState);				//Draws the state in full, then starts the render thread
+		void stop(const Elevator::SimulationState& simulationState, size_t tick);	//Draws the final state, then waits for the render thread to finish
+		void simulationEventsPublished(const Elevator::SimulationEventBatch& eventBatch, const Elevator::SimulationState& simulationState) override;
+
+		size_t getFramesDrawn() const;
+		size_t getSnapshotsDropped() const;		//Snapshots that were replaced by a newer one before they were drawn
+		size_t getBatchesSkipped() const;		//Batches that were not captured, as the render thread had not freed a slot
+
+	private:
+		void renderLoop();
+		void publishSnapshot(const Elevator::SimulationState& simulationState, size_t tick, bool waitForSlot);
+
+		SimulationStateDisplay& simulationStateDisplay;
+		Elevator::SnapshotRing<DisplaySnapshot> snapshotRing;
+		const std::chrono::steady_clock::duration frameInterval;
+		std::thread renderThread;
+		std::atomic<bool> stopping;
+		std::atomic<size_t> framesDrawn;
+		std::atomic<size_t> snapshotsDropped;
+		size_t batchesSkipped;					//Only used by the simulation thread
+};
+
+//Inline member functions
+inline size_t AsyncRenderer::getFramesDrawn() const {
+	return framesDrawn.load();
+}
+
+inline size_t AsyncRenderer::getSnapshotsDropped() const {
+	return snapshotsDropped.load();
+}
+
+inline size_t AsyncRenderer::getBatchesSkipped() const {
+	return batchesSkipped;
+}
@@ -0,0 +1,222 @@
+#include "stdafx.h"
+#include "BatchSimulation.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#define SCENARIO_COMMENT_CHARACTER '#'
+
+BatchSimulation::BatchSimulation(Elevator::ElevatorController* elevatorControllerPtr) :
+	elevatorControllerPtr(elevatorControllerPtr),
+	ticksRun(0),
+	commandsExecuted(0),
+	commandsRejected(0),
+	commandsNotReached(0),
+	stateCopies(0),
+	eventDriven(false),
+	shaftEvents(0),
+	elapsedTime(0)
+{
+	//Nobody is watching a batch run, so skip the display and the wait between ticks
+	elevatorControllerPtr->setDisplayEnabled(false);
+}
+
+//Parses a single line of the scenario, in the form of [Tick] [Command] [Arguments]
+//Returns true if successful.
+bool BatchSimulation::parseScenarioLine(const std::string& line, size_t lineNumber, ScenarioCommand& scenarioCommand) {
+	std::istringstream inStringStream(line);
+	long long tick;
+	inStringStream >> tick >> scenarioCommand.command;
+	if (inStringStream.fail() || tick < 0) {
+		return false;
+	}
+
+	scenarioCommand.tick = static_cast<size_t>(tick);
+	scenarioCommand.lineNumber = lineNumber;
+	scenarioCommand.secondArgument = 0;
+	scenarioCommand.direction = Elevator::MovementDirection::Up;
+
+	if (scenarioCommand.command == CALL_COMMAND) {
+		std::string direction;
+		inStringStream >> scenarioCommand.firstArgument >> direction;
+		return !inStringStream.fail() && commandStringToDirection(direction, scenarioCommand.direction);
+	}
+
+	if (scenarioCommand.command == REQUEST_FLOOR_COMMAND || scenarioCommand.command == PASSENGER_COMMAND) {
+		inStringStream >> scenarioCommand.firstArgument >> scenarioCommand.secondArgument;
+		return !inStringStream.fail();
+	}
+
+	return false;
+}
+
+//Reads and parses a scenario file. Returns false if it could not be loaded.
+//Commands are ordered by their tick, keeping the file order for commands on the same tick.
+bool BatchSimulation::loadScenario(const std::string& scenarioPath) {
+	std::ifstream scenarioFile(scenarioPath);
+	if (!scenarioFile.is_open()) {
+		std::cerr << "Unable to open scenario file: " << scenarioPath << std::endl;
+		return false;
+	}
+
+	scenarioCommands.clear();
+	std::string line;
+	size_t lineNumber = 0;
+	while (std::getline(scenarioFile, line)) {
+		lineNumber++;
+
+		size_t firstCharacter = line.find_first_not_of(" \t\r");
+		if (firstCharacter == std::string::npos || line[firstCharacter] == SCENARIO_COMMENT_CHARACTER) {
+			continue;
+		}
+
+		ScenarioCommand scenarioCommand;
+		if (!parseScenarioLine(line, lineNumber, scenarioCommand)) {
+			std::cerr << "Invalid scenario command on line " << lineNumber << ": " << line << std::endl;
+			return false;
+		}
+		scenarioCommands.push_back(scenarioCommand);
+	}
+
+	std::stable_sort(scenarioCommands.begin(), scenarioCommands.end(), [](const ScenarioCommand& a, const ScenarioCommand& b) {
+		return a.tick < b.tick;
+	});
+	return true;
+}
+
+//Executes a scenario command against the controller, after validating the arguments.
+//Floors are 1 based in the scenario, matching the interactive commands.
+bool BatchSimulation::executeCommand(const ScenarioCommand& scenarioCommand) {
+	if (scenarioCommand.command == CALL_COMMAND) {
+		if (!elevatorControllerPtr->isValidFloorNumber(scenarioCommand.firstArgument - 1)) {
+			return false;
+		}
+		elevatorControllerPtr->callElevator(scenarioCommand.firstArgument - 1, scenarioCommand.direction);
+		return true;
+	}
+
+	if (scenarioCommand.command == REQUEST_FLOOR_COMMAND) {
+		if (!elevatorControllerPtr->isValidShaftNumber(scenarioCommand.firstArgument)
+			|| !elevatorControllerPtr->isValidFloorNumber(scenarioCommand.secondArgument - 1)) {
+			return false;
+		}
+		elevatorControllerPtr->requestFloor(scenarioCommand.firstArgument, scenarioCommand.secondArgument - 1);
+		return true;
+	}
+
+	if (scenarioCommand.command == PASSENGER_COMMAND) {
+		if (!elevatorControllerPtr->isValidFloorNumber(scenarioCommand.firstArgument - 1)
+			|| !elevatorControllerPtr->isValidFloorNumber(scenarioCommand.secondArgument - 1)
+			|| scenarioCommand.firstArgument == scenarioCommand.secondArgument) {
+			return false;
+		}
+		elevatorControllerPtr->addPassenger(scenarioCommand.firstArgument - 1, scenarioCommand.secondArgument - 1);
+		return true;
+	}
+
+	return false;
+}
+
+//Executes the commands scheduled for a tick, starting from nextCommandIndex, and moves nextCommandIndex past them
+void BatchSimulation::executeCommandsForTick(size_t tick, size_t& nextCommandIndex) {
+	while (nextCommandIndex < scenarioCommands.size() && scenarioCommands[nextCommandIndex].tick == tick) {
+		const ScenarioCommand& scenarioCommand = scenarioCommands[nextCommandIndex];
+		if (executeCommand(scenarioCommand)) {
+			commandsExecuted++;
+		}
+		else {
+			std::cerr << "Rejected scenario command on line " << scenarioCommand.lineNumber << std::endl;
+			commandsRejected++;
+		}
+		nextCommandIndex++;
+	}
+}
+
+//Runs the scenario for a number of ticks, as fast as possible
+//Commands scheduled for a tick are executed before that tick is simulated.
+void BatchSimulation::run(size_t numberOfTicks) {
+	ticksRun = 0;
+	commandsExecuted = 0;
+	commandsRejected = 0;
+	eventDriven = false;
+
+	size_t nextCommandIndex = 0;
+	size_t copyCountBeforeRun = Elevator::StateCopyCounter::getCopyCount();
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	for (size_t tick = 0; tick < numberOfTicks; tick++) {
+		executeCommandsForTick(tick, nextCommandIndex);
+		elevatorControllerPtr->simulationTick();
+		ticksRun++;
+	}
+
+	elapsedTime = std::chrono::steady_clock::now() - startTime;
+	commandsNotReached = scenarioCommands.size() - nextCommandIndex;
+	stateCopies = Elevator::StateCopyCounter::getCopyCount() - copyCountBeforeRun;
+}
+
+//Runs the scenario with the event driven engine. The final state is the same as run, but time jumps from one
+//command or shaft arrival to the next, so quiet periods cost nothing.
+void BatchSimulation::runEventDriven(size_t numberOfTicks) {
+	ticksRun = 0;
+	commandsExecuted = 0;
+	commandsRejected = 0;
+	eventDriven = true;
+
+	size_t nextCommandIndex = 0;
+	size_t copyCountBeforeRun = Elevator::StateCopyCounter::getCopyCount();
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	Elevator::EventDrivenSimulation eventDrivenSimulation(elevatorControllerPtr);
+	while (nextCommandIndex < scenarioCommands.size() && scenarioCommands[nextCommandIndex].tick < numberOfTicks) {
+		size_t tick = scenarioCommands[nextCommandIndex].tick;
+		eventDrivenSimulation.advanceTo(tick);
+		executeCommandsForTick(tick, nextCommandIndex);
+		eventDrivenSimulation.stateChanged();
+	}
+	eventDrivenSimulation.advanceTo(numberOfTicks);
+
+	ticksRun = eventDrivenSimulation.getCurrentTick();
+	shaftEvents = eventDrivenSimulation.getEventCount();
+	elapsedTime = std::chrono::steady_clock::now() - startTime;
+	commandsNotReached = scenarioCommands.size() - nextCommandIndex;
+	stateCopies = Elevator::StateCopyCounter::getCopyCount() - copyCountBeforeRun;
+}
+
+//Prints the results of the last run
+void BatchSimulation::printSummary(std::ostream& outStream) const {
+	const Elevator::SimulationState& simulationState = elevatorControllerPtr->getCurrentState();
+
+	//Count what is still outstanding at the end of the run
+	size_t outstandingHallCalls = simulationState.hallCalls.size();
+
+	size_t movingShafts = 0;
+	for (size_t i = 0; i < simulationState.elevatorShaftVector.size(); i++) {
+		Elevator::MovementStatus movementStatus = simulationState.elevatorShaftVector[i].getCurrentMovementStatus();
+		if (movementStatus == Elevator::MovementStatus::MovingUp || movementStatus == Elevator::MovementStatus::MovingDown) {
+			movingShafts++;
+		}
+	}
+
+	double elapsedSeconds = elapsedTime.count();
+	outStream << "Batch run complete." << std::endl;
+	outStream << "Floors: " << simulationState.simulationSettings.numberOfFloors
+		<< ", Shafts: " << simulationState.simulationSettings.numberOfShafts
+		<< ", Dispatch: " << Elevator::getDispatchPolicyName(simulationState.simulationSettings.dispatchPolicy) << std::endl;
+	outStream << "Ticks: " << ticksRun << std::endl;
+	outStream << "Commands executed: " << commandsExecuted << " (" << commandsRejected << " rejected, "
+		<< commandsNotReached << " scheduled after the last tick)" << std::endl;
+	outStream << "Outstanding hall calls: " << outstandingHallCalls << std::endl;
+	outStream << "Shafts still moving: " << movingShafts << std::endl;
+	outStream << "State copies during the run: " << stateCopies << std::endl;
+	if (eventDriven) {
+		outStream << "Shaft events simulated: " << shaftEvents << " (" << ticksRun * simulationState.elevatorShaftVector.size() << " shaft ticks stepping tick by tick)" << std::endl;
+	}
+	outStream << "Elapsed seconds: " << elapsedSeconds << std::endl;
+	outStream << "Ticks per second: " << (elapsedSeconds > 0 ? ticksRun / elapsedSeconds : 0) << std::endl;
+
+	const Elevator::PassengerTracker& passengerTracker = elevatorControllerPtr->getPassengerTracker();
+	if (passengerTracker.hasPassengers() || passengerTracker.getBuildingWaitHistogram().getCount() > 0) {
+		passengerTracker.printStatistics(outStream);
+	}
+}
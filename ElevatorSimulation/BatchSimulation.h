@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include "ElevatorState.h"
+#include "ElevatorController.h"
+#include "SimulationCommands.h"
+#include "EventDrivenSimulation.h"
+
+//A single timestamped command from a scenario file
+struct ScenarioCommand {
+	size_t tick;							//The tick before which the command is executed
+	size_t lineNumber;						//Line in the scenario file, used for error reporting
+	std::string command;					//Call, RequestFloor or Passenger
+	int firstArgument;						//Floor number for Call, shaft number for RequestFloor, origin floor for Passenger
+	int secondArgument;						//Unused for Call, floor number for RequestFloor, destination floor for Passenger
+	Elevator::MovementDirection direction;	//Only used for Call
+};
+
+//Runs a scenario headless, without the display, the input loop or the wait between ticks.
+//Scenario files have one command per line, prefixed by the tick it should be executed on:
+//	0 Call 10 Down
+//	12 RequestFloor 0 2
+//Empty lines, and lines starting with # are ignored.
+class BatchSimulation
+{
+	public:
+		BatchSimulation(Elevator::ElevatorController* elevatorControllerPtr);
+
+		bool loadScenario(const std::string& scenarioPath);		//Reads and parses a scenario file. Returns false if it could not be loaded.
+		void run(size_t numberOfTicks);							//Runs the scenario for a number of ticks, as fast as possible
+		void runEventDriven(size_t numberOfTicks);				//Runs the scenario with the event driven engine, skipping ticks where nothing happens
+		void printSummary(std::ostream& outStream) const;		//Prints the results of the last run
+
+	private:
+		bool parseScenarioLine(const std::string& line, size_t lineNumber, ScenarioCommand& scenarioCommand);
+		bool executeCommand(const ScenarioCommand& scenarioCommand);
+		void executeCommandsForTick(size_t tick, size_t& nextCommandIndex);	//Executes the commands scheduled for a tick, counting the results
+
+		Elevator::ElevatorController* elevatorControllerPtr;
+		std::vector<ScenarioCommand> scenarioCommands;
+
+		//Results of the last run
+		size_t ticksRun;
+		size_t commandsExecuted;
+		size_t commandsRejected;
+		size_t commandsNotReached;
+		size_t stateCopies;						//Whole state copies made while running, should always be 0
+		bool eventDriven;
+		size_t shaftEvents;						//Shaft ticks simulated by the event driven engine
+		std::chrono::duration<double> elapsedTime;
+};
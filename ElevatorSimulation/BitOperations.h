@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Elevator {
+
+	//Word level bit scanning, used by the bitsets that track floors.
+	//All of the scans require a word that is not zero.
+
+	//Returns the index of the lowest set bit in the word
+	inline int findFirstSetBit(uint64_t word) {
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanForward64(&index, word);
+		return static_cast<int>(index);
+#elif defined(_MSC_VER)
+		//32 bit builds do not have the 64 bit scan, so check each half
+		unsigned long index;
+		if (_BitScanForward(&index, static_cast<unsigned long>(word))) {
+			return static_cast<int>(index);
+		}
+		_BitScanForward(&index, static_cast<unsigned long>(word >> 32));
+		return static_cast<int>(index) + 32;
+#else
+		return __builtin_ctzll(word);
+#endif
+	}
+
+	//Returns the index of the highest set bit in the word
+	inline int findLastSetBit(uint64_t word) {
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanReverse64(&index, word);
+		return static_cast<int>(index);
+#elif defined(_MSC_VER)
+		unsigned long index;
+		if (_BitScanReverse(&index, static_cast<unsigned long>(word >> 32))) {
+			return static_cast<int>(index) + 32;
+		}
+		_BitScanReverse(&index, static_cast<unsigned long>(word));
+		return static_cast<int>(index);
+#else
+		return 63 - __builtin_clzll(word);
+#endif
+	}
+
+	//Returns how many bits are set in the word
+	inline int countSetBits(uint64_t word) {
+#if defined(_MSC_VER)
+		//__popcnt64 needs a processor with POPCNT, so count with shifts and masks instead
+		word = word - ((word >> 1) & 0x5555555555555555ULL);
+		word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+		word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+		return static_cast<int>((word * 0x0101010101010101ULL) >> 56);
+#else
+		return __builtin_popcountll(word);
+#endif
+	}
+
+	//Returns a word with the bits from bitIndex upwards set. bitIndex must be less than 64.
+	inline uint64_t maskFromBit(int bitIndex) {
+		return ~0ULL << bitIndex;
+	}
+
+	//Returns a word with the bits up to and including bitIndex set. bitIndex must be less than 64.
+	inline uint64_t maskUpToBit(int bitIndex) {
+		return bitIndex == 63 ? ~0ULL : (1ULL << (bitIndex + 1)) - 1;
+	}
+
+	//Scans for the lowest set bit that is >= bitIndex, in a run of words. Returns -1 if there is none.
+	//bitIndex must be within the words.
+	inline int findSetBitAtOrAbove(const uint64_t* words, size_t wordCount, int bitIndex) {
+		size_t wordIndex = bitIndex >> 6;
+		uint64_t word = words[wordIndex] & maskFromBit(bitIndex & 63);
+		while (word == 0) {
+			wordIndex++;
+			if (wordIndex >= wordCount) {
+				return -1;
+			}
+			word = words[wordIndex];
+		}
+		return static_cast<int>(wordIndex << 6) + findFirstSetBit(word);
+	}
+
+	//Scans for the highest set bit that is <= bitIndex, in a run of words. Returns -1 if there is none.
+	//bitIndex must be within the words.
+	inline int findSetBitAtOrBelow(const uint64_t* words, int bitIndex) {
+		size_t wordIndex = bitIndex >> 6;
+		uint64_t word = words[wordIndex] & maskUpToBit(bitIndex & 63);
+		while (word == 0) {
+			if (wordIndex == 0) {
+				return -1;
+			}
+			wordIndex--;
+			word = words[wordIndex];
+		}
+		return static_cast<int>(wordIndex << 6) + findLastSetBit(word);
+	}
+
+	//Counts the set bits from lowBitIndex to highBitIndex inclusive, in a run of words.
+	//Both indexes must be within the words, and lowBitIndex <= highBitIndex.
+	inline size_t countSetBitsInRange(const uint64_t* words, int lowBitIndex, int highBitIndex) {
+		size_t lowWordIndex = lowBitIndex >> 6;
+		size_t highWordIndex = highBitIndex >> 6;
+		uint64_t lowMask = maskFromBit(lowBitIndex & 63);
+		uint64_t highMask = maskUpToBit(highBitIndex & 63);
+
+		//Both ends are in the same word
+		if (lowWordIndex == highWordIndex) {
+			return countSetBits(words[lowWordIndex] & lowMask & highMask);
+		}
+
+		size_t count = countSetBits(words[lowWordIndex] & lowMask);
+		for (size_t i = lowWordIndex + 1; i < highWordIndex; i++) {
+			count += countSetBits(words[i]);
+		}
+		count += countSetBits(words[highWordIndex] & highMask);
+		return count;
+	}
+}
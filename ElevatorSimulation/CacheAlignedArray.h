@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+namespace Elevator {
+
+	//A fixed size array of elements that each start on their own cache lines, so threads writing to neighbouring elements never share a line.
+	//Before C++17, new and std::vector only align to the fundamental types, so the storage is over-allocated and aligned by hand.
+	template <class T>
+	class CacheAlignedArray {
+		public:
+			CacheAlignedArray(size_t elementCount);
+			~CacheAlignedArray();
+			CacheAlignedArray(const CacheAlignedArray&) = delete;
+			CacheAlignedArray& operator=(const CacheAlignedArray&) = delete;
+
+			void reset(size_t elementCount);	//Replaces the elements with elementCount default constructed ones
+			T& operator[](size_t index);
+			size_t size() const;
+
+		private:
+			static const size_t CACHE_LINE_SIZE = 64;
+			static const size_t ELEMENT_STRIDE = (sizeof(T) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;	//Whole cache lines per element
+
+			void destroyElements();
+
+			std::unique_ptr<char[]> storage;
+			char* firstElement;						//The first cache line boundary in storage
+			size_t count;
+	};
+
+	//Inline member functions
+
+	template <class T>
+	CacheAlignedArray<T>::CacheAlignedArray(size_t elementCount) :
+		firstElement(nullptr),
+		count(0)
+	{
+		reset(elementCount);
+	}
+
+	template <class T>
+	CacheAlignedArray<T>::~CacheAlignedArray() {
+		destroyElements();
+	}
+
+	template <class T>
+	void CacheAlignedArray<T>::reset(size_t elementCount) {
+		destroyElements();
+		storage.reset(new char[elementCount * ELEMENT_STRIDE + CACHE_LINE_SIZE - 1]);
+		uintptr_t address = reinterpret_cast<uintptr_t>(storage.get());
+		firstElement = storage.get() + (CACHE_LINE_SIZE - address % CACHE_LINE_SIZE) % CACHE_LINE_SIZE;
+		for (; count < elementCount; count++) {
+			new (firstElement + count * ELEMENT_STRIDE) T();
+		}
+	}
+
+	template <class T>
+	void CacheAlignedArray<T>::destroyElements() {
+		for (; count > 0; count--) {
+			(*this)[count - 1].~T();
+		}
+	}
+
+	template <class T>
+	inline T& CacheAlignedArray<T>::operator[](size_t index) {
+		return *reinterpret_cast<T*>(firstElement + index * ELEMENT_STRIDE);
+	}
+
+	template <class T>
+	inline size_t CacheAlignedArray<T>::size() const {
+		return count;
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace Elevator {
+
+	//The binary framing of the control server, for processes that drive the simulation over its socket.
+	//Each request is a type byte followed by fixed size arguments, so the type alone gives the length of the frame.
+	//Integers are unsigned and little endian. Floors and shafts are 0 based, as in the controller.
+	//	Call			floor (4 bytes), direction (1 byte, 0 for Up, 1 for Down)
+	//	RequestFloor	shaft (4 bytes), floor (4 bytes)
+	//	Passenger		origin floor (4 bytes), destination floor (4 bytes)
+	//	Tick			number of ticks (4 bytes)
+	//	QueryState		no arguments
+	//	Shutdown		no arguments, stops the server once the current batch has been applied
+	//Only QueryState is answered. Its reply is sent once every request before it, from the same client, has been applied:
+	//	StateReply		tick (8 bytes), rejected requests from this client (4 bytes), shaft count (4 bytes), floor count (4 bytes),
+	//					then for each shaft its floor (4 bytes) and MovementStatus (1 byte), then for each floor its CONTROL_CALLING flags (1 byte)
+	enum class ControlRequestType : uint8_t {
+		Call = 1,
+		RequestFloor = 2,
+		Passenger = 3,
+		Tick = 4,
+		QueryState = 5,
+		Shutdown = 6
+	};
+
+	enum class ControlReplyType : uint8_t {
+		StateReply = 0x81
+	};
+
+	const size_t CONTROL_CALL_FRAME_SIZE = 6;
+	const size_t CONTROL_TWO_ARGUMENT_FRAME_SIZE = 9;	//RequestFloor and Passenger
+	const size_t CONTROL_TICK_FRAME_SIZE = 5;
+	const size_t CONTROL_EMPTY_FRAME_SIZE = 1;			//QueryState and Shutdown
+	const size_t CONTROL_STATE_REPLY_HEADER_SIZE = 21;
+	const size_t CONTROL_STATE_REPLY_SHAFT_SIZE = 5;
+
+	const uint8_t CONTROL_CALLING_UP = 1;
+	const uint8_t CONTROL_CALLING_DOWN = 2;
+
+	//Returns the length of a request frame from its type byte, or 0 if the type is not a request
+	inline size_t getControlFrameSize(uint8_t requestType) {
+		switch (static_cast<ControlRequestType>(requestType)) {
+		case ControlRequestType::Call:
+			return CONTROL_CALL_FRAME_SIZE;
+		case ControlRequestType::RequestFloor:
+		case ControlRequestType::Passenger:
+			return CONTROL_TWO_ARGUMENT_FRAME_SIZE;
+		case ControlRequestType::Tick:
+			return CONTROL_TICK_FRAME_SIZE;
+		case ControlRequestType::QueryState:
+		case ControlRequestType::Shutdown:
+			return CONTROL_EMPTY_FRAME_SIZE;
+		default:
+			return 0;
+		}
+	}
+
+	//Byte by byte, so the framing does not depend on the alignment or byte order of the machine
+	inline void writeControlUint32(uint8_t* buffer, uint32_t value) {
+		buffer[0] = static_cast<uint8_t>(value);
+		buffer[1] = static_cast<uint8_t>(value >> 8);
+		buffer[2] = static_cast<uint8_t>(value >> 16);
+		buffer[3] = static_cast<uint8_t>(value >> 24);
+	}
+
+	inline uint32_t readControlUint32(const uint8_t* buffer) {
+		return static_cast<uint32_t>(buffer[0]) | static_cast<uint32_t>(buffer[1]) << 8 | static_cast<uint32_t>(buffer[2]) << 16 | static_cast<uint32_t>(buffer[3]) << 24;
+	}
+
+	inline void writeControlUint64(uint8_t* buffer, uint64_t value) {
+		writeControlUint32(buffer, static_cast<uint32_t>(value));
+		writeControlUint32(buffer + 4, static_cast<uint32_t>(value >> 32));
+	}
+
+	inline uint64_t readControlUint64(const uint8_t* buffer) {
+		return static_cast<uint64_t>(readControlUint32(buffer)) | static_cast<uint64_t>(readControlUint32(buffer + 4)) << 32;
+	}
+}
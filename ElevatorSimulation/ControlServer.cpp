@@ -0,0 +1,522 @@
+#include "stdafx.h"
+#include "ControlServer.h"
+#include <limits>
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#define CONTROL_LISTEN_BACKLOG 128
+#define CONTROL_MAXIMUM_EVENTS 64			//Ready clients handled per round
+#define CONTROL_RECEIVE_BUFFER_SIZE 65536	//Also the most one client can send in a round
+#define CONTROL_SEND_LIMIT (16 * 1024 * 1024)	//A client with this many unread reply bytes is not reading them, and is dropped
+#define CONTROL_MAXIMUM_TICKS_PER_ROUND 1024	//Longer Ticks are spread over several rounds, so one client cannot hold up the others
+#define CONTROL_SHUTDOWN_FLUSH_MILLISECONDS 1000	//How long replies still being sent at shutdown are given to drain
+
+
+ControlServer::ControlServer(Elevator::ElevatorController* elevatorControllerPtr) :
+	elevatorControllerPtr(elevatorControllerPtr),
+	listenDescriptor(-1),
+	epollDescriptor(-1),
+	ticksRequested(0),
+	shutdownRequested(false),
+	clientsAccepted(0),
+	requestsApplied(0),
+	requestsRejected(0),
+	clientsDropped(0),
+	roundsApplied(0),
+	ticksRun(0),
+	elapsedTime(0)
+{
+	//The clients drive the simulation, so skip the display
+	elevatorControllerPtr->setDisplayEnabled(false);
+}
+
+//Prints the results of the last run
+void ControlServer::printSummary(std::ostream& outStream) const {
+	const Elevator::SimulationSettings& simulationSettings = elevatorControllerPtr->getCurrentState().simulationSettings;
+	double elapsedSeconds = elapsedTime.count();
+
+	outStream << "Control server stopped." << std::endl;
+	outStream << "Floors: " << simulationSettings.numberOfFloors << ", Shafts: " << simulationSettings.numberOfShafts
+		<< ", Dispatch: " << Elevator::getDispatchPolicyName(simulationSettings.dispatchPolicy) << std::endl;
+	outStream << "Clients: " << clientsAccepted << " (" << clientsDropped << " dropped)" << std::endl;
+	outStream << "Requests applied: " << requestsApplied << " (" << requestsRejected << " rejected) in " << roundsApplied << " batches" << std::endl;
+	outStream << "Ticks: " << ticksRun << std::endl;
+	outStream << "Elapsed seconds: " << elapsedSeconds << std::endl;
+	outStream << "Requests per second: " << (elapsedSeconds > 0 ? requestsApplied / elapsedSeconds : 0) << std::endl;
+
+	const Elevator::PassengerTracker& passengerTracker = elevatorControllerPtr->getPassengerTracker();
+	if (passengerTracker.hasPassengers() || passengerTracker.getBuildingWaitHistogram().getCount() > 0) {
+		passengerTracker.printStatistics(outStream);
+	}
+}
+
+//Floors and shafts arrive unsigned. Anything too large for an int is out of range.
+static bool toControlArgument(uint32_t argument, int& value) {
+	if (argument > static_cast<uint32_t>(std::numeric_limits<int>::max())) {
+		return false;
+	}
+	value = static_cast<int>(argument);
+	return true;
+}
+
+//Applies a queued request to the controller, after validating its arguments
+bool ControlServer::applyRequest(const QueuedRequest& queuedRequest) {
+	int firstArgument, secondArgument;
+	bool argumentsFit = toControlArgument(queuedRequest.firstArgument, firstArgument) && toControlArgument(queuedRequest.secondArgument, secondArgument);
+	switch (queuedRequest.requestType) {
+	case Elevator::ControlRequestType::Call:
+		if (!argumentsFit || !elevatorControllerPtr->isValidFloorNumber(firstArgument) || secondArgument > static_cast<int>(Elevator::MovementDirection::Down)) {
+			return false;
+		}
+		elevatorControllerPtr->callElevator(firstArgument, static_cast<Elevator::MovementDirection>(secondArgument));
+		return true;
+	case Elevator::ControlRequestType::RequestFloor:
+		if (!argumentsFit || !elevatorControllerPtr->isValidShaftNumber(firstArgument) || !elevatorControllerPtr->isValidFloorNumber(secondArgument)) {
+			return false;
+		}
+		elevatorControllerPtr->requestFloor(firstArgument, secondArgument);
+		return true;
+	case Elevator::ControlRequestType::Passenger:
+		if (!argumentsFit || !elevatorControllerPtr->isValidFloorNumber(firstArgument) || !elevatorControllerPtr->isValidFloorNumber(secondArgument)
+			|| firstArgument == secondArgument) {
+			return false;
+		}
+		elevatorControllerPtr->addPassenger(firstArgument, secondArgument);
+		return true;
+	default:
+		return true;
+	}
+}
+
+#ifdef _WIN32
+
+ControlServer::~ControlServer() {
+}
+
+//Windows has no epoll, so there is no server to start
+bool ControlServer::listen(const std::string& socketPath) {
+	std::cerr << "The control server is only supported on Linux." << std::endl;
+	return false;
+}
+
+void ControlServer::run(Elevator::TickPacer* tickPacerPtr) {
+}
+
+#else
+
+ControlServer::~ControlServer() {
+	for (std::unordered_map<int, ControlClient>::iterator clientIterator = controlClients.begin(); clientIterator != controlClients.end(); ++clientIterator) {
+		::close(clientIterator->first);
+	}
+	if (epollDescriptor >= 0) {
+		::close(epollDescriptor);
+	}
+	if (listenDescriptor >= 0) {
+		::close(listenDescriptor);
+		unlink(socketPath.c_str());
+	}
+}
+
+bool ControlServer::listen(const std::string& _socketPath) {
+	socketPath = _socketPath;
+	sockaddr_un socketAddress;
+	std::memset(&socketAddress, 0, sizeof(socketAddress));
+	socketAddress.sun_family = AF_UNIX;
+	if (socketPath.empty() || socketPath.size() >= sizeof(socketAddress.sun_path)) {
+		std::cerr << "The control socket path must be between 1 and " << sizeof(socketAddress.sun_path) - 1 << " characters." << std::endl;
+		return false;
+	}
+	std::memcpy(socketAddress.sun_path, socketPath.c_str(), socketPath.size());
+
+	//A socket file left behind by an earlier server would stop the bind
+	unlink(socketPath.c_str());
+	listenDescriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (listenDescriptor < 0 || bind(listenDescriptor, reinterpret_cast<sockaddr*>(&socketAddress), sizeof(socketAddress)) != 0
+		|| ::listen(listenDescriptor, CONTROL_LISTEN_BACKLOG) != 0) {
+		std::cerr << "Unable to listen on control socket: " << socketPath << " (" << std::strerror(errno) << ")" << std::endl;
+		return false;
+	}
+
+	epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+	epoll_event listenEvent;
+	listenEvent.events = EPOLLIN;
+	listenEvent.data.fd = listenDescriptor;
+	if (epollDescriptor < 0 || epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, listenDescriptor, &listenEvent) != 0) {
+		std::cerr << "Unable to create the control server's epoll instance (" << std::strerror(errno) << ")" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+//Each round waits for clients, queues what they sent, then applies it as one batch at the tick boundary
+void ControlServer::run(Elevator::TickPacer* tickPacerPtr) {
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	if (tickPacerPtr) {
+		tickPacerPtr->start(startTime);
+	}
+
+	epoll_event readyEvents[CONTROL_MAXIMUM_EVENTS];
+	while (!shutdownRequested) {
+		//Clients whose parsing stopped at a Tick or QueryState continue first, once their ticks have run, and the round does not wait for more
+		bool hasUnparsedRequests = false;
+		for (std::unordered_map<int, ControlClient>::iterator clientIterator = controlClients.begin(); clientIterator != controlClients.end(); ++clientIterator) {
+			if (clientIterator->second.hasUnparsedRequests && !isWaitingForTicks(clientIterator->second)) {
+				parseRequests(clientIterator->second);
+				hasUnparsedRequests = true;
+			}
+		}
+
+		int waitMilliseconds = -1;
+		if (hasUnparsedRequests || ticksRequested > 0 || shutdownRequested) {
+			waitMilliseconds = 0;
+		}
+		else if (tickPacerPtr && tickPacerPtr->isPaced()) {
+			std::chrono::steady_clock::duration untilDeadline = tickPacerPtr->getNextDeadline() - std::chrono::steady_clock::now();
+			waitMilliseconds = static_cast<int>(std::max<long long>(0, std::chrono::duration_cast<std::chrono::milliseconds>(untilDeadline).count() + 1));
+		}
+
+		int readyCount = epoll_wait(epollDescriptor, readyEvents, CONTROL_MAXIMUM_EVENTS, waitMilliseconds);
+		if (readyCount < 0 && errno != EINTR) {
+			std::cerr << "Control server wait failed (" << std::strerror(errno) << ")" << std::endl;
+			break;
+		}
+
+		for (int i = 0; i < readyCount; i++) {
+			int descriptor = readyEvents[i].data.fd;
+			if (descriptor == listenDescriptor) {
+				acceptClients();
+				continue;
+			}
+
+			std::unordered_map<int, ControlClient>::iterator clientIterator = controlClients.find(descriptor);
+			if (clientIterator == controlClients.end()) {
+				continue;
+			}
+			if (readyEvents[i].events & EPOLLOUT) {
+				flushClient(clientIterator->second);
+			}
+			if (readyEvents[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+				receiveFromClient(clientIterator->second);
+			}
+		}
+
+		if (tickPacerPtr && tickPacerPtr->isPaced()) {
+			ticksRequested += tickPacerPtr->takeDueTicks(std::chrono::steady_clock::now());
+		}
+		applyQueuedRequests();
+		closeFinishedClients();
+		removeClosedClients();
+	}
+
+	flushBeforeShutdown();
+	elapsedTime = std::chrono::steady_clock::now() - startTime;
+}
+
+void ControlServer::acceptClients() {
+	while (true) {
+		int clientDescriptor = accept4(listenDescriptor, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (clientDescriptor < 0) {
+			return;
+		}
+
+		ControlClient& client = controlClients[clientDescriptor];
+		client.socketDescriptor = clientDescriptor;
+		client.receiveBuffer.resize(CONTROL_RECEIVE_BUFFER_SIZE);
+		client.receiveOffset = 0;
+		client.receiveEnd = 0;
+		client.sendOffset = 0;
+		client.requestsRejected = 0;
+		client.hasUnparsedRequests = false;
+		client.waitingToSend = false;
+		client.receiveClosed = false;
+		client.closeWhenSent = false;
+		client.closing = false;
+		client.resumeTick = 0;
+
+		epoll_event clientEvent;
+		clientEvent.events = EPOLLIN;
+		clientEvent.data.fd = clientDescriptor;
+		epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, clientDescriptor, &clientEvent);
+		clientsAccepted++;
+	}
+}
+
+void ControlServer::receiveFromClient(ControlClient& client) {
+	if (client.closing || client.receiveClosed) {
+		return;
+	}
+
+	//Move the start of a partly received frame to the front, to make room after it
+	if (client.receiveOffset > 0) {
+		std::memmove(client.receiveBuffer.data(), client.receiveBuffer.data() + client.receiveOffset, client.receiveEnd - client.receiveOffset);
+		client.receiveEnd -= client.receiveOffset;
+		client.receiveOffset = 0;
+	}
+
+	//A full buffer is waiting behind a Tick or QueryState. The socket stays readable, so it is read again next round.
+	if (client.receiveEnd == client.receiveBuffer.size()) {
+		return;
+	}
+
+	ssize_t receivedCount = recv(client.socketDescriptor, client.receiveBuffer.data() + client.receiveEnd, client.receiveBuffer.size() - client.receiveEnd, 0);
+	if (receivedCount > 0) {
+		client.receiveEnd += static_cast<size_t>(receivedCount);
+	}
+	else if (receivedCount == 0) {
+		client.receiveClosed = true;
+		watchClient(client);
+	}
+	else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+		closeClient(client);
+		return;
+	}
+
+	//A client waiting for its ticks keeps what it sent until they have run
+	if (isWaitingForTicks(client)) {
+		client.hasUnparsedRequests = true;
+	}
+	else if (!client.hasUnparsedRequests) {
+		parseRequests(client);
+	}
+}
+
+void ControlServer::parseRequests(ControlClient& client) {
+	client.hasUnparsedRequests = false;
+	const uint8_t* receiveBuffer = client.receiveBuffer.data();
+	bool roundEnded = false;
+	while (client.receiveOffset < client.receiveEnd && !roundEnded) {
+		const uint8_t* frame = receiveBuffer + client.receiveOffset;
+		size_t frameSize = Elevator::getControlFrameSize(frame[0]);
+		if (frameSize == 0) {
+			std::cerr << "Dropped control client " << client.socketDescriptor << ": unknown request type " << static_cast<int>(frame[0]) << std::endl;
+			clientsDropped++;
+			closeClient(client);
+			return;
+		}
+		if (client.receiveEnd - client.receiveOffset < frameSize) {
+			break;
+		}
+		client.receiveOffset += frameSize;
+
+		Elevator::ControlRequestType requestType = static_cast<Elevator::ControlRequestType>(frame[0]);
+		QueuedRequest queuedRequest = { requestType, 0, 0, &client };
+		switch (requestType) {
+		case Elevator::ControlRequestType::Call:
+			queuedRequest.firstArgument = Elevator::readControlUint32(frame + 1);
+			queuedRequest.secondArgument = frame[5];
+			queuedRequests.push_back(queuedRequest);
+			break;
+		case Elevator::ControlRequestType::RequestFloor:
+		case Elevator::ControlRequestType::Passenger:
+			queuedRequest.firstArgument = Elevator::readControlUint32(frame + 1);
+			queuedRequest.secondArgument = Elevator::readControlUint32(frame + 5);
+			queuedRequests.push_back(queuedRequest);
+			break;
+		case Elevator::ControlRequestType::Tick:
+		case Elevator::ControlRequestType::QueryState:
+			//Anything sent after these has to wait for the batch to be applied
+			if (requestType == Elevator::ControlRequestType::Tick) {
+				ticksRequested += Elevator::readControlUint32(frame + 1);
+				client.resumeTick = ticksRun + ticksRequested;
+			}
+			else {
+				queuedRequests.push_back(queuedRequest);
+			}
+			client.hasUnparsedRequests = client.receiveOffset < client.receiveEnd;
+			roundEnded = true;
+			break;
+		case Elevator::ControlRequestType::Shutdown:
+			shutdownRequested = true;
+			roundEnded = true;
+			break;
+		}
+	}
+
+	//A client that has finished sending is closed after the round, once it has been sent its replies
+	if (client.receiveClosed && !client.hasUnparsedRequests && !client.closeWhenSent) {
+		client.closeWhenSent = true;
+		finishedDescriptors.push_back(client.socketDescriptor);
+	}
+}
+
+//Applies the round's requests in the order they were parsed, runs some of the ticks that were asked for, then answers the state queries
+void ControlServer::applyQueuedRequests() {
+	if (queuedRequests.empty() && ticksRequested == 0) {
+		return;
+	}
+
+	for (size_t i = 0; i < queuedRequests.size(); i++) {
+		if (queuedRequests[i].requestType == Elevator::ControlRequestType::QueryState) {
+			continue;
+		}
+		if (applyRequest(queuedRequests[i])) {
+			requestsApplied++;
+		}
+		else {
+			queuedRequests[i].clientPtr->requestsRejected++;
+			requestsRejected++;
+		}
+	}
+
+	//The rest of a long Tick is left for the next rounds. Its client's later requests, including its state queries, are held until it has all run.
+	if (ticksRequested > 0) {
+		size_t roundTicks = std::min<size_t>(ticksRequested, CONTROL_MAXIMUM_TICKS_PER_ROUND);
+		elevatorControllerPtr->simulationTick(roundTicks);
+		ticksRun += roundTicks;
+		ticksRequested -= roundTicks;
+	}
+
+	for (size_t i = 0; i < queuedRequests.size(); i++) {
+		if (queuedRequests[i].requestType == Elevator::ControlRequestType::QueryState) {
+			sendStateReply(*queuedRequests[i].clientPtr);
+		}
+	}
+
+	queuedRequests.clear();
+	roundsApplied++;
+}
+
+void ControlServer::sendStateReply(ControlClient& client) {
+	const Elevator::SimulationState& simulationState = elevatorControllerPtr->getCurrentState();
+	const std::vector<Elevator::ElevatorShaft>& elevatorShafts = simulationState.elevatorShaftVector;
+	const std::vector<Elevator::Floor>& floorsVector = simulationState.floorsVector;
+	replyBuffer.resize(Elevator::CONTROL_STATE_REPLY_HEADER_SIZE + elevatorShafts.size() * Elevator::CONTROL_STATE_REPLY_SHAFT_SIZE + floorsVector.size());
+
+	uint8_t* position = replyBuffer.data();
+	*position++ = static_cast<uint8_t>(Elevator::ControlReplyType::StateReply);
+	Elevator::writeControlUint64(position, elevatorControllerPtr->getCurrentTick());
+	Elevator::writeControlUint32(position + 8, client.requestsRejected);
+	Elevator::writeControlUint32(position + 12, static_cast<uint32_t>(elevatorShafts.size()));
+	Elevator::writeControlUint32(position + 16, static_cast<uint32_t>(floorsVector.size()));
+	position += Elevator::CONTROL_STATE_REPLY_HEADER_SIZE - 1;
+
+	for (size_t i = 0; i < elevatorShafts.size(); i++) {
+		Elevator::writeControlUint32(position, static_cast<uint32_t>(elevatorShafts[i].getCurrentPosition()));
+		position[4] = static_cast<uint8_t>(elevatorShafts[i].getCurrentMovementStatus());
+		position += Elevator::CONTROL_STATE_REPLY_SHAFT_SIZE;
+	}
+	for (size_t i = 0; i < floorsVector.size(); i++) {
+		int floorNumber = static_cast<int>(i);
+		*position++ = (simulationState.hallCalls.isCallingForUp(floorNumber) ? Elevator::CONTROL_CALLING_UP : 0)
+			| (simulationState.hallCalls.isCallingForDown(floorNumber) ? Elevator::CONTROL_CALLING_DOWN : 0);
+	}
+
+	client.sendBuffer.insert(client.sendBuffer.end(), replyBuffer.begin(), replyBuffer.end());
+	if (client.sendBuffer.size() - client.sendOffset > CONTROL_SEND_LIMIT) {
+		std::cerr << "Dropped control client " << client.socketDescriptor << ": not reading its replies" << std::endl;
+		clientsDropped++;
+		closeClient(client);
+		return;
+	}
+	if (!client.waitingToSend) {
+		flushClient(client);
+	}
+}
+
+//Sends as much of the client's replies as its socket takes, and watches for it to drain if it fills
+void ControlServer::flushClient(ControlClient& client) {
+	while (client.sendOffset < client.sendBuffer.size()) {
+		ssize_t sentCount = send(client.socketDescriptor, client.sendBuffer.data() + client.sendOffset, client.sendBuffer.size() - client.sendOffset, MSG_NOSIGNAL);
+		if (sentCount > 0) {
+			client.sendOffset += static_cast<size_t>(sentCount);
+		}
+		else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			if (!client.waitingToSend) {
+				client.waitingToSend = true;
+				watchClient(client);
+			}
+			return;
+		}
+		else if (errno != EINTR) {
+			closeClient(client);
+			return;
+		}
+	}
+
+	client.sendBuffer.clear();
+	client.sendOffset = 0;
+	if (client.closeWhenSent) {
+		closeClient(client);
+		return;
+	}
+	if (client.waitingToSend) {
+		client.waitingToSend = false;
+		watchClient(client);
+	}
+}
+
+void ControlServer::watchClient(ControlClient& client) {
+	epoll_event clientEvent;
+	clientEvent.events = (client.receiveClosed ? 0u : static_cast<uint32_t>(EPOLLIN)) | (client.waitingToSend ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+	clientEvent.data.fd = client.socketDescriptor;
+	epoll_ctl(epollDescriptor, EPOLL_CTL_MOD, client.socketDescriptor, &clientEvent);
+}
+
+//Stops watching the client straight away, but its requests already queued are still applied, and replied to if it can still be sent to
+void ControlServer::closeClient(ControlClient& client) {
+	if (client.closing) {
+		return;
+	}
+	client.closing = true;
+	client.hasUnparsedRequests = false;
+	epoll_ctl(epollDescriptor, EPOLL_CTL_DEL, client.socketDescriptor, nullptr);
+	closingDescriptors.push_back(client.socketDescriptor);
+}
+
+//A finished client whose replies filled its socket stays open, watched for it to drain, and flushClient closes it once they are all sent
+void ControlServer::closeFinishedClients() {
+	for (size_t i = 0; i < finishedDescriptors.size(); i++) {
+		std::unordered_map<int, ControlClient>::iterator clientIterator = controlClients.find(finishedDescriptors[i]);
+		if (clientIterator != controlClients.end() && !clientIterator->second.waitingToSend) {
+			closeClient(clientIterator->second);
+		}
+	}
+	finishedDescriptors.clear();
+}
+
+void ControlServer::removeClosedClients() {
+	for (size_t i = 0; i < closingDescriptors.size(); i++) {
+		::close(closingDescriptors[i]);
+		controlClients.erase(closingDescriptors[i]);
+	}
+	closingDescriptors.clear();
+}
+
+//The replies to the last round may still be waiting for their clients to read them, so they are sent before the sockets are closed
+void ControlServer::flushBeforeShutdown() {
+	std::chrono::steady_clock::time_point flushDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CONTROL_SHUTDOWN_FLUSH_MILLISECONDS);
+	epoll_event readyEvents[CONTROL_MAXIMUM_EVENTS];
+	while (true) {
+		bool sending = false;
+		for (std::unordered_map<int, ControlClient>::iterator clientIterator = controlClients.begin(); clientIterator != controlClients.end(); ++clientIterator) {
+			sending = sending || (clientIterator->second.waitingToSend && !clientIterator->second.closing);
+		}
+		std::chrono::steady_clock::duration untilDeadline = flushDeadline - std::chrono::steady_clock::now();
+		if (!sending || untilDeadline <= std::chrono::steady_clock::duration::zero()) {
+			break;
+		}
+
+		int waitMilliseconds = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(untilDeadline).count() + 1);
+		int readyCount = epoll_wait(epollDescriptor, readyEvents, CONTROL_MAXIMUM_EVENTS, waitMilliseconds);
+		if (readyCount < 0 && errno != EINTR) {
+			break;
+		}
+		for (int i = 0; i < readyCount; i++) {
+			std::unordered_map<int, ControlClient>::iterator clientIterator = controlClients.find(readyEvents[i].data.fd);
+			if (clientIterator != controlClients.end() && (readyEvents[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR))) {
+				flushClient(clientIterator->second);
+			}
+		}
+		removeClosedClients();
+	}
+}
+
+#endif
@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+#include "ElevatorState.h"
+#include "ElevatorController.h"
+#include "ControlProtocol.h"
+#include "TickPacer.h"
+
+//Lets other processes drive the simulation through a Unix domain socket, using the binary framing in ControlProtocol.h.
+//A single thread waits on every client with epoll. Each round, it reads what the ready clients have sent and queues their requests,
+//then applies the queued requests to the controller together, runs the ticks that were asked for, and answers the state queries.
+//A client's Tick and QueryState end its part of a round, so the requests it sent after them are not applied early.
+//A round runs a bounded number of ticks, so a long Tick is spread over several rounds and the other clients are served in between.
+//The client that sent it has the rest of its requests held until all of its ticks have run.
+//Only supported on Linux. Elsewhere the server fails to start.
+class ControlServer
+{
+	public:
+		ControlServer(Elevator::ElevatorController* elevatorControllerPtr);
+		~ControlServer();
+
+		bool listen(const std::string& socketPath);			//Replaces any socket file already at the path. Returns false if the socket could not be created.
+		void run(Elevator::TickPacer* tickPacerPtr = nullptr);	//Serves until a client sends Shutdown. A pacer also runs ticks in real time, as well as those the clients ask for.
+		void printSummary(std::ostream& outStream) const;
+
+	private:
+		struct ControlClient {
+			int socketDescriptor;
+			std::vector<uint8_t> receiveBuffer;		//Fixed size. Bytes from receiveOffset to receiveEnd are received but not yet parsed.
+			size_t receiveOffset;
+			size_t receiveEnd;
+			std::vector<uint8_t> sendBuffer;		//Replies not yet accepted by the socket, from sendOffset
+			size_t sendOffset;
+			uint32_t requestsRejected;
+			bool hasUnparsedRequests;				//Parsing stopped at a Tick or QueryState, so the rest waits for the next round
+			bool waitingToSend;						//The socket is full, and epoll is watching for it to drain
+			bool receiveClosed;						//The client has finished sending
+			bool closeWhenSent;						//Its requests are all parsed, so it is closed once its replies have all been sent
+			bool closing;							//Closed once the round is applied, so its descriptor is not reused by an accept in the same round
+			size_t resumeTick;						//Its requests after a Tick are held until the server has run this many ticks
+		};
+
+		//A request queued for the next batch. QueryState is queued too, and answered after the batch's ticks.
+		struct QueuedRequest {
+			Elevator::ControlRequestType requestType;
+			uint32_t firstArgument;
+			uint32_t secondArgument;
+			ControlClient* clientPtr;
+		};
+
+		void acceptClients();
+		void receiveFromClient(ControlClient& client);
+		void parseRequests(ControlClient& client);			//Queues whole frames until a Tick or QueryState, or the end of the received bytes
+		bool isWaitingForTicks(const ControlClient& client) const;	//True while the ticks the client asked for are still being run
+		void applyQueuedRequests();
+		bool applyRequest(const QueuedRequest& queuedRequest);	//Returns false if the arguments are out of range
+		void sendStateReply(ControlClient& client);
+		void flushClient(ControlClient& client);
+		void closeClient(ControlClient& client);
+		void closeFinishedClients();						//Closes the clients that finished sending this round, unless their replies are still being sent
+		void removeClosedClients();
+		void flushBeforeShutdown();							//Gives the replies still being sent a short time to drain before the server stops
+		void watchClient(ControlClient& client);					//Updates what epoll watches the client for, from its flags
+
+		Elevator::ElevatorController* elevatorControllerPtr;
+		std::string socketPath;
+		int listenDescriptor;
+		int epollDescriptor;
+		std::unordered_map<int, ControlClient> controlClients;	//Keyed on the socket descriptor. Nodes do not move, so queued requests can point at their client.
+		std::vector<QueuedRequest> queuedRequests;				//Reused every round
+		std::vector<int> closingDescriptors;					//Clients to remove once the round is applied
+		std::vector<int> finishedDescriptors;					//Clients that finished sending this round, closed once their replies are sent
+		std::vector<uint8_t> replyBuffer;						//Reused for every state reply
+		size_t ticksRequested;									//Ticks still to run, some of them each round once its requests are applied
+		bool shutdownRequested;
+
+		//Results of the last run
+		size_t clientsAccepted;
+		size_t requestsApplied;
+		size_t requestsRejected;
+		size_t clientsDropped;									//Closed for sending an unknown request type, or for not reading their replies
+		size_t roundsApplied;
+		size_t ticksRun;
+		std::chrono::duration<double> elapsedTime;
+};
+
+//Inline member functions
+
+inline bool ControlServer::isWaitingForTicks(const ControlClient& client) const {
+	return client.resumeTick > ticksRun;
+}
@@ -0,0 +1,111 @@
+#include "stdafx.h"
+#include "DispatchIndex.h"
+#include <algorithm>
+#include <limits>
+
+
+//Creates an empty index for a building.
+//The shaft position is clamped to numberOfFloors, so there is one more floor than the building has.
+//A building with no more shafts than floors is not indexed, so nothing is allocated for it.
+Elevator::DispatchIndex::DispatchIndex(int numberOfFloors, int numberOfShafts) :
+	floorCount(numberOfFloors + 1),
+	indexed(numberOfShafts > numberOfFloors),
+	wordsPerFloor((numberOfShafts + BITS_PER_WORD - 1) / BITS_PER_WORD)
+{
+	if (indexed) {
+		shaftsOnFloorWords.assign(floorCount * wordsPerFloor, 0);
+		bucketSummaries.resize(floorCount * BucketCount);
+		shaftEntries.resize(numberOfShafts);
+		clear();
+	}
+}
+
+//Removes all shafts
+void Elevator::DispatchIndex::clear() {
+	std::fill(shaftsOnFloorWords.begin(), shaftsOnFloorWords.end(), 0);
+	BucketSummary emptySummary = { 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false };
+	std::fill(bucketSummaries.begin(), bucketSummaries.end(), emptySummary);
+	ShaftEntry emptyEntry = { -1, 0, 0, 0 };
+	std::fill(shaftEntries.begin(), shaftEntries.end(), emptyEntry);
+}
+
+//Moves the shaft to its floor and bucket, and updates the summaries of the buckets it left and joined.
+//Most updates come from the shafts moving each tick, so an unchanged shaft returns straight away, and the summaries are only recomputed when searched.
+void Elevator::DispatchIndex::updateShaft(size_t shaft, const ElevatorShaft& elevatorShaft) {
+	if (!indexed) {
+		return;
+	}
+
+	//The shafts move up and down in no particular order, so the bucket and run are selected rather than branched on
+	MovementStatus movementStatus = elevatorShaft.getCurrentMovementStatus();
+	bool movingUp = movementStatus == MovementStatus::MovingUp;
+	bool movingDown = movementStatus == MovementStatus::MovingDown;
+	ShaftEntry shaftEntry;
+	shaftEntry.floor = std::min(elevatorShaft.getCurrentPosition(), floorCount - 1);
+	shaftEntry.stopCount = static_cast<int>(elevatorShaft.getStopCount());
+	shaftEntry.bucket = movingUp ? MovingUpBucket : (movingDown ? MovingDownBucket : StoppedBucket);
+	int runUp = elevatorShaft.getHighestStopAbove() - shaftEntry.floor;
+	int runDown = elevatorShaft.getLowestStopBelow() < 0 ? 0 : shaftEntry.floor - elevatorShaft.getLowestStopBelow();
+	shaftEntry.remainingRun = std::max(movingUp ? runUp : (movingDown ? runDown : 0), 0);
+
+	ShaftEntry& indexedEntry = shaftEntries[shaft];
+	if (indexedEntry.floor == shaftEntry.floor && indexedEntry.bucket == shaftEntry.bucket
+		&& indexedEntry.remainingRun == shaftEntry.remainingRun && indexedEntry.stopCount == shaftEntry.stopCount) {
+		return;
+	}
+
+	if (indexedEntry.floor >= 0) {
+		removeShaft(shaft);
+	}
+	indexedEntry = shaftEntry;
+	insertShaft(shaft);
+}
+
+//An empty bucket's minimums are the largest int, so a shaft joining it sets them
+void Elevator::DispatchIndex::insertShaft(size_t shaft) {
+	const ShaftEntry& shaftEntry = shaftEntries[shaft];
+	getFloorWords(shaftEntry.floor)[shaft >> 6] |= 1ULL << (shaft & 63);
+
+	BucketSummary& bucketSummary = bucketSummaries[shaftEntry.bucket * floorCount + shaftEntry.floor];
+	bucketSummary.minimumRemainingRun = std::min(bucketSummary.minimumRemainingRun, shaftEntry.remainingRun);
+	bucketSummary.minimumStopCount = std::min(bucketSummary.minimumStopCount, shaftEntry.stopCount);
+	bucketSummary.shaftCount++;
+}
+
+//The summary is only stale if the shaft leaving held one of its minimums, and an emptied bucket starts again
+void Elevator::DispatchIndex::removeShaft(size_t shaft) {
+	const ShaftEntry& shaftEntry = shaftEntries[shaft];
+	getFloorWords(shaftEntry.floor)[shaft >> 6] &= ~(1ULL << (shaft & 63));
+
+	BucketSummary& bucketSummary = bucketSummaries[shaftEntry.bucket * floorCount + shaftEntry.floor];
+	bucketSummary.shaftCount--;
+	bool emptied = bucketSummary.shaftCount == 0;
+	bool heldMinimum = (shaftEntry.remainingRun == bucketSummary.minimumRemainingRun) | (shaftEntry.stopCount == bucketSummary.minimumStopCount);
+	bucketSummary.stale = (bucketSummary.stale | heldMinimum) & !emptied;
+	bucketSummary.minimumRemainingRun = emptied ? std::numeric_limits<int>::max() : bucketSummary.minimumRemainingRun;
+	bucketSummary.minimumStopCount = emptied ? std::numeric_limits<int>::max() : bucketSummary.minimumStopCount;
+}
+
+//A floor holds a few shafts on average, so this only visits a handful of entries. The buckets share the floor's bitset, so they are summarized together.
+void Elevator::DispatchIndex::summarizeFloor(int floorNumber) {
+	int minimumRemainingRuns[BucketCount];
+	int minimumStopCounts[BucketCount];
+	std::fill(minimumRemainingRuns, minimumRemainingRuns + BucketCount, std::numeric_limits<int>::max());
+	std::fill(minimumStopCounts, minimumStopCounts + BucketCount, std::numeric_limits<int>::max());
+
+	const uint64_t* floorWords = getFloorWords(floorNumber);
+	for (size_t i = 0; i < wordsPerFloor; i++) {
+		for (uint64_t word = floorWords[i]; word != 0; word &= word - 1) {
+			const ShaftEntry& shaftEntry = shaftEntries[i * BITS_PER_WORD + findFirstSetBit(word)];
+			minimumRemainingRuns[shaftEntry.bucket] = std::min(minimumRemainingRuns[shaftEntry.bucket], shaftEntry.remainingRun);
+			minimumStopCounts[shaftEntry.bucket] = std::min(minimumStopCounts[shaftEntry.bucket], shaftEntry.stopCount);
+		}
+	}
+
+	for (int bucket = 0; bucket < BucketCount; bucket++) {
+		BucketSummary& bucketSummary = bucketSummaries[bucket * floorCount + floorNumber];
+		bucketSummary.minimumRemainingRun = minimumRemainingRuns[bucket];
+		bucketSummary.minimumStopCount = minimumStopCounts[bucket];
+		bucketSummary.stale = false;
+	}
+}
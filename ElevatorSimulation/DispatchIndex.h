@@ -0,0 +1,173 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include "ElevatorShaft.h"
+#include "DispatchPolicies.h"
+#include "BitOperations.h"
+
+namespace Elevator {
+
+	//Index of the elevator shafts by the floor they are on, used to assign hall calls without scanning every shaft.
+	//Every dispatch policy's cost for a shaft is at least its distance from the floor, so the search works outwards from the called floor
+	//and stops as soon as the remaining shafts are too far away to beat the best cost found.
+	//Gives the same choice as a linear scan with the policy's cost: the lowest cost, then the lowest shaft number.
+	//Each floor has a bitset of the shafts on it, visited in shaft order, and each shaft is in one of three buckets: moving up, moving down, and waiting or disabled.
+	//Each floor keeps a summary of the shafts on it in each bucket, the fewest stops queued and the shortest run left before turning around, and the policy turns
+	//that into the lowest cost any of them can have. A busy shaft can cost far more than its distance: LeastLoaded counts its stops,
+	//and the ETA policies count its whole run when it is heading away from the call. The shafts of a bucket are skipped from the summary alone.
+	//Walking the floors only pays when there are more shafts than floors, so with fewer the index is not kept, and the controller checks every shaft instead.
+	class DispatchIndex {
+		public:
+			DispatchIndex(int numberOfFloors, int numberOfShafts);
+
+			void updateShaft(size_t shaft, const ElevatorShaft& elevatorShaft);	//Updates the index after a shaft has moved, or its status or stops have changed
+			void clear();														//Removes all shafts
+			bool isIndexed() const;												//False if the building has too few shafts for the index to pay
+
+			//Returns the shaft with the lowest cost to meet the call under DispatchPolicy, as long as the cost is below maximumCost.
+			//Returns NO_SHAFT if no shaft is below maximumCost. Not const, as it summarizes the floors it visits again if they are stale.
+			template <class DispatchPolicy>
+			size_t findLowestCostShaft(const std::vector<ElevatorShaft>& elevatorShafts, const DispatchCall& dispatchCall, int maximumCost);
+
+			static const size_t NO_SHAFT = static_cast<size_t>(-1);
+
+		private:
+			enum ShaftBucket { MovingUpBucket = 0, MovingDownBucket = 1, StoppedBucket = 2, BucketCount = 3 };
+
+			//Where a shaft is in the index. The run is the floors left to its furthest stop in the direction it is moving.
+			struct ShaftEntry {
+				int floor;														//-1 if the shaft is not in the index
+				int bucket;
+				int remainingRun;
+				int stopCount;
+			};
+
+			//The shafts in one bucket on one floor. The minimums are never above the shafts' own values, but once the shaft that set one
+			//has left they may be below them, and the summary is stale until a search summarizes the floor again. An empty bucket's minimums are the largest int.
+			struct BucketSummary {
+				int shaftCount;
+				int minimumRemainingRun;
+				int minimumStopCount;
+				bool stale;
+			};
+
+			void insertShaft(size_t shaft);
+			void removeShaft(size_t shaft);
+			void summarizeFloor(int floorNumber);								//Recomputes the floor's summaries from its shafts
+			uint64_t* getFloorWords(int floorNumber);
+			const uint64_t* getFloorWords(int floorNumber) const;
+
+			static const int BITS_PER_WORD = 64;
+
+			const int floorCount;
+			const bool indexed;
+			const size_t wordsPerFloor;
+			std::vector<uint64_t> shaftsOnFloorWords;							//wordsPerFloor words for each floor, one bit per shaft
+			std::vector<BucketSummary> bucketSummaries;							//A summary for each floor in each bucket, the floors of a bucket together
+			std::vector<ShaftEntry> shaftEntries;
+	};
+
+	//Inline member functions
+
+	inline bool DispatchIndex::isIndexed() const {
+		return indexed;
+	}
+
+	inline uint64_t* DispatchIndex::getFloorWords(int floorNumber) {
+		return &shaftsOnFloorWords[floorNumber * wordsPerFloor];
+	}
+
+	inline const uint64_t* DispatchIndex::getFloorWords(int floorNumber) const {
+		return &shaftsOnFloorWords[floorNumber * wordsPerFloor];
+	}
+
+	//Searches the floors at distance 0, 1, 2... from the called floor. Every shaft at a distance costs at least that distance,
+	//so once the distance is greater than the best cost, no other shaft can beat it. Within a floor, the shafts in a bucket are skipped
+	//if the lowest cost its summary allows cannot beat the best cost either.
+	template <class DispatchPolicy>
+	size_t DispatchIndex::findLowestCostShaft(const std::vector<ElevatorShaft>& elevatorShafts, const DispatchCall& dispatchCall, int maximumCost) {
+		size_t bestShaft = NO_SHAFT;
+		int bestCost = maximumCost;
+		int shaftCount = static_cast<int>(wordsPerFloor * BITS_PER_WORD);
+		int floorNumber = dispatchCall.floor;
+
+		for (int distance = 0; distance < floorCount; distance++) {
+			//Every shaft from here on costs at least the distance
+			if (distance > bestCost || (bestShaft == NO_SHAFT && distance >= bestCost)) {
+				break;
+			}
+
+			int candidateFloors[2] = { floorNumber - distance, floorNumber + distance };
+			int candidateFloorCount = distance == 0 ? 1 : 2;
+			for (int i = 0; i < candidateFloorCount; i++) {
+				int candidateFloor = candidateFloors[i];
+				if (candidateFloor < 0 || candidateFloor >= floorCount) {
+					continue;
+				}
+
+				//The lowest cost each bucket allows, and which of them could still beat the best
+				int minimumCosts[BucketCount];
+				int floorMinimumCost = std::numeric_limits<int>::max();
+				unsigned int searchedBuckets = 0;
+				for (int bucket = 0; bucket < BucketCount; bucket++) {
+					BucketSummary& bucketSummary = bucketSummaries[bucket * floorCount + candidateFloor];
+					if (bucketSummary.shaftCount == 0) {
+						continue;
+					}
+					if (bucketSummary.stale) {
+						summarizeFloor(candidateFloor);
+					}
+
+					//A shaft moving up from above the call, or down from below it, has to finish its run and come back
+					bool headingAway = (bucket == MovingUpBucket && candidateFloor > floorNumber) || (bucket == MovingDownBucket && candidateFloor < floorNumber);
+					minimumCosts[bucket] = distance + DispatchPolicy::minimumExtraCost(headingAway, bucketSummary.minimumRemainingRun, bucketSummary.minimumStopCount);
+					if (minimumCosts[bucket] > bestCost || (bestShaft == NO_SHAFT && minimumCosts[bucket] >= bestCost)) {
+						continue;
+					}
+					searchedBuckets |= 1u << bucket;
+					floorMinimumCost = std::min(floorMinimumCost, minimumCosts[bucket]);
+				}
+
+				//Visit the shafts on the floor in shaft order
+				const uint64_t* floorWords = getFloorWords(candidateFloor);
+				for (int nextShaft = searchedBuckets == 0 ? -1 : findSetBitAtOrAbove(floorWords, wordsPerFloor, 0); nextShaft >= 0;
+					nextShaft = nextShaft + 1 < shaftCount ? findSetBitAtOrAbove(floorWords, wordsPerFloor, nextShaft + 1) : -1) {
+					size_t shaft = static_cast<size_t>(nextShaft);
+
+					//Cannot beat the best, as the cost is at least as high and ties go to the lower shaft number
+					if (bestShaft != NO_SHAFT && shaft > bestShaft && floorMinimumCost >= bestCost) {
+						break;
+					}
+
+					int bucket = shaftEntries[shaft].bucket;
+					if ((searchedBuckets & (1u << bucket)) == 0) {
+						continue;
+					}
+					int minimumCost = minimumCosts[bucket];
+					if (minimumCost > bestCost || (minimumCost == bestCost && (bestShaft == NO_SHAFT || shaft > bestShaft))) {
+						continue;
+					}
+
+					int shaftCost = DispatchPolicy::cost(elevatorShafts[shaft], dispatchCall);
+					assert(shaftCost >= minimumCost);
+					if (shaftCost < bestCost || (bestShaft != NO_SHAFT && shaftCost == bestCost && shaft < bestShaft)) {
+						bestShaft = shaft;
+						bestCost = shaftCost;
+					}
+
+					//Nothing else in this bucket can cost less, and the rest have higher shaft numbers
+					if (shaftCost == minimumCost) {
+						searchedBuckets &= ~(1u << bucket);
+						if (searchedBuckets == 0) {
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		return bestShaft;
+	}
+}
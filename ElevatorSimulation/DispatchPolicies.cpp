@@ -0,0 +1,41 @@
+#include "stdafx.h"
+#include "DispatchPolicies.h"
+
+
+//Looks up a dispatch policy by name. Returns false if there is no policy with that name.
+bool Elevator::dispatchPolicyFromName(const std::string& policyName, DispatchPolicyType& dispatchPolicy) {
+	if (policyName == "Stops") {
+		dispatchPolicy = DispatchPolicyType::Stops;
+	}
+	else if (policyName == "NearestCar") {
+		dispatchPolicy = DispatchPolicyType::NearestCar;
+	}
+	else if (policyName == "Collective") {
+		dispatchPolicy = DispatchPolicyType::Collective;
+	}
+	else if (policyName == "LeastLoaded") {
+		dispatchPolicy = DispatchPolicyType::LeastLoaded;
+	}
+	else if (policyName == "Destination") {
+		dispatchPolicy = DispatchPolicyType::Destination;
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+const char* Elevator::getDispatchPolicyName(DispatchPolicyType dispatchPolicy) {
+	switch (dispatchPolicy) {
+		case DispatchPolicyType::NearestCar:
+			return "NearestCar";
+		case DispatchPolicyType::Collective:
+			return "Collective";
+		case DispatchPolicyType::LeastLoaded:
+			return "LeastLoaded";
+		case DispatchPolicyType::Destination:
+			return "Destination";
+		default:
+			return "Stops";
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <string>
+#include "ElevatorState.h"
+#include "ElevatorShaft.h"
+
+namespace Elevator {
+
+	//A hall call that is being assigned to a shaft
+	struct DispatchCall {
+		int floor;
+		MovementDirection direction;
+		int destinationFloor;				//Only known for passengers, -1 for a plain call
+	};
+
+	//Dispatch policies give the cost of a shaft meeting a call, and the call goes to the lowest cost shaft, ties going to the lowest shaft number.
+	//A policy is a type with a static cost function, used as a template argument by the dispatch search, so the cost function is inlined into it.
+	//Every cost must be at least the distance between the shaft and the called floor. The DispatchIndex relies on this to stop searching early.
+	//Each policy also gives the lowest cost above the distance that a group of shafts can have, from the group's fewest queued stops and shortest remaining run,
+	//and whether they are moving away from the call. The DispatchIndex skips a group whose lowest cost cannot beat the best shaft found.
+
+	//The distance, plus the number of stops the shaft makes on the way. This was the original policy.
+	struct StopsPolicy {
+		static int cost(const ElevatorShaft& elevatorShaft, const DispatchCall& dispatchCall);
+		static int minimumExtraCost(bool headingAway, int minimumRemainingRun, int minimumStopCount);
+	};
+
+	//Only the distance, ignoring where the shaft is going
+	struct NearestCarPolicy {
+		static int cost(const ElevatorShaft& elevatorShaft, const DispatchCall& dispatchCall);
+		static int minimumExtraCost(bool headingAway, int minimumRemainingRun, int minimumStopCount);
+	};
+
+	//Direction aware collective control. The cost is the shaft's ETA to meet the call: the floors travelled until it leaves the called floor in the call's direction.
+	//A shaft already heading that way picks the call up on its way past, any other shaft must finish its run and turn around first.
+	//The ETA is looked up from the ends of the shaft's runs, which the shaft keeps up to date, so it costs a few comparisons per shaft. This is the default.
+	//A shaft heading away from the call travels the rest of its run and back again before it meets the call, so it costs at least twice that run above the distance.
+	struct CollectivePolicy {
+		static int cost(const ElevatorShaft& elevatorShaft, const DispatchCall& dispatchCall);
+		static int minimumExtraCost(bool headingAway, int minimumRemainingRun, int minimumStopCount);
+	};
+
+	//Prefers the shaft with the fewest stops queued, using the distance to choose between equally loaded shafts
+	struct LeastLoadedPolicy {
+		static int cost(const ElevatorShaft& elevatorShaft, const DispatchCall& dispatchCall);
+		static int minimumExtraCost(bool headingAway, int minimumRemainingRun, int minimumStopCount);
+		static const int STOP_COST = 8;		//Each queued stop counts as this many floors of travel
+	};
+
+	//Destination dispatch, for passengers who give their destination at the hall. The ETA, plus a penalty for each of the origin
+	//and destination that is not already one of the shaft's stops, so passengers travelling between the same floors share a car.
+	struct DestinationPolicy {
+		static int cost(const ElevatorShaft& elevatorShaft, const DispatchCall& dispatchCall);
+		static int minimumExtraCost(bool headingAway, int minimumRemainingRun, int minimumStopCount);
+		static const int NEW_STOP_COST = 2;
+	};
+
+	bool dispatchPolicyFromName(const std::string& policyName, DispatchPolicyType& dispatchPolicy);	//Returns false if there is no policy with that name
+	const char* getDispatchPolicyName(DispatchPolicyType dispatchPolicy);
+
+	//Inline member functions
+
+	inline int StopsPolicy::cost(const ElevatorShaft& elevatorShaft, const DispatchCall& dispatchCall) {
+		return elevatorShaft.costToVisitFloor(dispatchCall.floor);
+	}
+
+	//The stops counted are only those between the shaft and the call, which may be none
+	inline int StopsPolicy::minimumExtraCost(bool headingAway, int minimumRemainingRun, int minimumStopCount) {
+		return 0;
+	}
+
+	inline int NearestCarPolicy::cost(const ElevatorShaft& elevatorShaft, const DispatchCall& dispatchCall) {
+		int distance = elevatorShaft.getCurrentPosition() - dispatchCall.floor;
+		return distance < 0 ? -distance : distance;
+	}
+
+	inline int NearestCarPolicy::minimumExtraCost(bool headingAway, int minimumRemainingRun, int minimumStopCount) {
+		return 0;
+	}
+
+	inline int CollectivePolicy::cost(const ElevatorShaft& elevatorShaft, const DispatchCall& dispatchCall) {
+		return elevatorShaft.etaToMeetCall(dispatchCall.floor, dispatchCall.direction);
+	}
+
+	inline int CollectivePolicy::minimumExtraCost(bool headingAway, int minimumRemainingRun, int minimumStopCount) {
+		return headingAway ? 2 * minimumRemainingRun : 0;
+	}
+
+	inline int LeastLoadedPolicy::cost(const ElevatorShaft& elevatorShaft, const DispatchCall& dispatchCall) {
+		const ElevatorState& elevatorState = elevatorShaft.getCurrentElevatorState();
+		int queuedStops = static_cast<int>(elevatorState.floorsAboveStopSet.size() + elevatorState.floorsBelowStopSet.size());
+		return NearestCarPolicy::cost(elevatorShaft, dispatchCall) + STOP_COST * queuedStops;
+	}
+
+	inline int LeastLoadedPolicy::minimumExtraCost(bool headingAway, int minimumRemainingRun, int minimumStopCount) {
+		return STOP_COST * minimumStopCount;
+	}
+
+	inline int DestinationPolicy::cost(const ElevatorShaft& elevatorShaft, const DispatchCall& dispatchCall) {
+		const ElevatorState& elevatorState = elevatorShaft.getCurrentElevatorState();
+		int shaftCost = CollectivePolicy::cost(elevatorShaft, dispatchCall);
+		if (!elevatorState.floorsAboveStopSet.contains(dispatchCall.floor) && !elevatorState.floorsBelowStopSet.contains(dispatchCall.floor)) {
+			shaftCost += NEW_STOP_COST;
+		}
+		if (dispatchCall.destinationFloor >= 0
+			&& !elevatorState.floorsAboveStopSet.contains(dispatchCall.destinationFloor) && !elevatorState.floorsBelowStopSet.contains(dispatchCall.destinationFloor)) {
+			shaftCost += NEW_STOP_COST;
+		}
+		return shaftCost;
+	}
+
+	//The penalties are never negative, so the ETA's bound holds
+	inline int DestinationPolicy::minimumExtraCost(bool headingAway, int minimumRemainingRun, int minimumStopCount) {
+		return CollectivePolicy::minimumExtraCost(headingAway, minimumRemainingRun, minimumStopCount);
+	}
+}
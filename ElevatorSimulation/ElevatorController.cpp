@@ -1,13 +1,29 @@
 #include "stdafx.h"
 #include "ElevatorController.h"
+#include "Tracing.h"
+#include <cstring>
+#include <limits>
+#include <algorithm>
 
-#define TICK_DURATION 1 //How long should the thread sleep between ticks
+#define CACHE_LINE_SIZE 64
+#define PARALLEL_TICK_MINIMUM_SHAFTS 1024 //Below this, waking the workers costs more than the tick itself
+#define CHECKPOINT_MAGIC 0x31504B4356454C45ULL //"ELEVCKP1"
+#define CALL_FLAGS_PER_WORD 32 //Each floor's up and down calls take 2 bits of a word
 
 
 //Creates the default state, simulation display.
 Elevator::ElevatorController::ElevatorController(SimulationSettings settings) :
 	currentState(SimulationState()), 
-	simulationStateDisplay(SimulationStateDisplay(settings))
+	simulationStateDisplay(SimulationStateDisplay(settings)),
+	displayEnabled(true),
+	dispatchIndex(settings.numberOfFloors, settings.numberOfShafts),
+	passengerTracker(settings.numberOfFloors, settings.numberOfShafts),
+	hallCallShafts(2 * settings.numberOfFloors, 0),
+	currentTick(0),
+	eventLogWriterPtr(nullptr),
+	shaftTickRanges(1),
+	recordingEvents(true),
+	publishingDeferred(false)
 {
 	//Initialize the current state.
 
@@ -15,7 +31,8 @@ Elevator::ElevatorController::ElevatorController(SimulationSettings settings) :
 	currentState.simulationSettings = settings;
 	for (int i = 0; i < settings.numberOfShafts; i++) {
 		ElevatorShaft newElevatorShaft(i, settings.numberOfFloors);
-		currentState.elevatorShaftVector.push_back(newElevatorShaft);
+		dispatchIndex.updateShaft(i, newElevatorShaft);
+		currentState.elevatorShaftVector.push_back(std::move(newElevatorShaft));
 	}
 
 	//Create the floors, checking to see if we are adding the first and top floors.
@@ -23,6 +40,7 @@ Elevator::ElevatorController::ElevatorController(SimulationSettings settings) :
 	for (int i = 0; i < settings.numberOfFloors; i++) {
 		currentState.floorsVector.push_back(Elevator::Floor(i, i == settings.numberOfFloors -1, i == 0));
 	}
+	currentState.hallCalls.resize(settings.numberOfFloors);
 
 
 }
@@ -33,84 +51,574 @@ Elevator::ElevatorController::~ElevatorController()
 }
 
 //Calls an elevator to a given floor, based on the direction that the passenger intends to travel
-void Elevator::ElevatorController::callElevator(int floor, MovementDirection direction) {
-	currentState.floorsVector[floor].callElevator(direction); //Update the model to reflect that an elevator has been called
+//Returns the shaft that the call was assigned to
+size_t Elevator::ElevatorController::callElevator(int floor, MovementDirection direction) {
+	TRACE_SCOPE("callElevator");
+	if (eventLogWriterPtr) {
+		eventLogWriterPtr->logCall(currentTick, floor, direction);
+	}
+	DispatchCall dispatchCall = { floor, direction, -1 };
+	return assignCall(dispatchCall);
+}
+
+//Assigns a call to the lowest cost shaft under the dispatch policy. Passengers call elevators through here, as their calls are logged as the passenger.
+//The policy is chosen once per call, and each policy has its own instantiation of the search, so there is no indirect call per shaft.
+size_t Elevator::ElevatorController::assignCall(const DispatchCall& dispatchCall) {
+	switch (currentState.simulationSettings.dispatchPolicy) {
+		case DispatchPolicyType::NearestCar:
+			return assignCallWithPolicy<NearestCarPolicy>(dispatchCall);
+		case DispatchPolicyType::Collective:
+			return assignCallWithPolicy<CollectivePolicy>(dispatchCall);
+		case DispatchPolicyType::LeastLoaded:
+			return assignCallWithPolicy<LeastLoadedPolicy>(dispatchCall);
+		case DispatchPolicyType::Destination:
+			return assignCallWithPolicy<DestinationPolicy>(dispatchCall);
+		default:
+			return assignCallWithPolicy<StopsPolicy>(dispatchCall);
+	}
+}
+
+template <class DispatchPolicy>
+size_t Elevator::ElevatorController::assignCallWithPolicy(const DispatchCall& dispatchCall) {
+	int floor = dispatchCall.floor;
+	if (currentState.hallCalls.call(floor, dispatchCall.direction)) { //Update the model to reflect that an elevator has been called
+		recordEvent(SimulationEventType::CallSet, 0, floor, static_cast<int>(dispatchCall.direction));
+	}
 	
 	//We next need to select a shaft to assign this call to.
-	//Linear search through each shaft to find which elevator has the lowest cost (as a measure of floors)
-	int lowestCost = 2 * currentState.floorsVector.size(); //Start the value at a cost at a maximum value
+	//The dispatch index finds which elevator has the lowest cost, without checking every shaft. With no more shafts than floors, checking every shaft is quicker.
+	size_t lowestCostshaftIndex;
+	if (dispatchIndex.isIndexed()) {
+		int lowestCost = std::numeric_limits<int>::max(); //Start the value at a cost at a maximum value
+		lowestCostshaftIndex = dispatchIndex.findLowestCostShaft<DispatchPolicy>(currentState.elevatorShaftVector, dispatchCall, lowestCost);
+		if (lowestCostshaftIndex == DispatchIndex::NO_SHAFT) {
+			lowestCostshaftIndex = 0;
+		}
+
+		//The index must agree with checking every shaft
+		assert(lowestCostshaftIndex == findLowestCostShaftByScan<DispatchPolicy>(dispatchCall));
+	}
+	else {
+		lowestCostshaftIndex = findLowestCostShaftByScan<DispatchPolicy>(dispatchCall);
+	}
+
+	//Assign the request to a chosen shaft.
+	requestShaftFloor(lowestCostshaftIndex, floor);
+	hallCallShafts[2 * floor + (dispatchCall.direction == MovementDirection::Down ? 1 : 0)] = lowestCostshaftIndex;
+	publishEvents(); //Update the view
+	return lowestCostshaftIndex;
+}
+
+//Linear search through each shaft to find which elevator has the lowest cost
+//Used when the building has too few shafts for the dispatch index, and to check the index
+template <class DispatchPolicy>
+size_t Elevator::ElevatorController::findLowestCostShaftByScan(const DispatchCall& dispatchCall) const {
+	int lowestCost = std::numeric_limits<int>::max(); //Start the value at a cost at a maximum value
 	size_t lowestCostshaftIndex = 0;
 
 	for (size_t i = 0; i < currentState.elevatorShaftVector.size(); i++) {
-		int shaftCost = currentState.elevatorShaftVector[i].costToVisitFloor(floor);
+		int shaftCost = DispatchPolicy::cost(currentState.elevatorShaftVector[i], dispatchCall);
 		if (shaftCost < lowestCost) {
 			lowestCostshaftIndex = i;
 			lowestCost = shaftCost;
 		}
 	}
-
-	//Assign the request to a chosen shaft.
-	currentState.elevatorShaftVector[lowestCostshaftIndex].requestFloor(floor);
-	simulationStateDisplay.refreshDisplay(currentState); //Update the view
-
+	return lowestCostshaftIndex;
 }
 
 //Requests that a specific elevator travels to a specific floor
 //This is used to simulate button presses when inside the elevator
 //As well as for when the controller is sending an elevator meet a call request
-//Note that the floorNumber is used directly as the priority queue value
 void Elevator::ElevatorController::requestFloor(int shaft, int floorNumber) {
+	TRACE_SCOPE("requestFloor");
+	if (eventLogWriterPtr) {
+		eventLogWriterPtr->logRequestFloor(currentTick, shaft, floorNumber);
+	}
 
-	currentState.elevatorShaftVector[shaft].requestFloor(floorNumber); //Add the floor to the elevator queue, which updates the model
-	
-	ElevatorState elevatorState = currentState.elevatorShaftVector[shaft].getCurrentElevatorState();
+	//Add the floor to the elevator queue, which updates the model
+	//The elevator ignores requests to go to it's current position
+	requestShaftFloor(shaft, floorNumber);
+
+	publishEvents(); //refresh the view
 	
-	//The elevator should ignore requests to go to it's current position
-	if (floorNumber == elevatorState.currentPosition) {
+}
+
+//Adds a passenger waiting at their origin floor. They call an elevator, unless the floor is already calling in their direction,
+//and request their destination from whichever elevator meets the call.
+void Elevator::ElevatorController::addPassenger(int originFloor, int destinationFloor) {
+	if (originFloor == destinationFloor) {
 		return;
 	}
 
-	//Push the floor number onto the appropriate priority queue
-	if (floorNumber > elevatorState.currentPosition) {
-		elevatorState.floorsAbovePriorityQueue.push(floorNumber);
+	if (eventLogWriterPtr) {
+		eventLogWriterPtr->logPassenger(currentTick, originFloor, destinationFloor);
 	}
+	passengerTracker.addPassenger(originFloor, destinationFloor, currentTick);
 
-	if (floorNumber < elevatorState.currentPosition) {
-		elevatorState.floorsBelowPriorityQueue.push(floorNumber);
+	bool goingUp = destinationFloor > originFloor;
+	if (currentState.hallCalls.isCalling(originFloor, goingUp ? MovementDirection::Up : MovementDirection::Down)) {
+		publishEvents();
+		return;
 	}
-
-	simulationStateDisplay.refreshDisplay(currentState); //refresh the view
-	
+	DispatchCall dispatchCall = { originFloor, goingUp ? MovementDirection::Up : MovementDirection::Down, destinationFloor };
+	assignCall(dispatchCall);
 }
 
 //Simulates the passage of time. This simulation moves the elevators at a pace of one floor per tick
 void Elevator::ElevatorController::simulationTick() {
-	//Move the elevators according to their priority queues
-	for (int i = 0; i < currentState.elevatorShaftVector.size(); i++) {
-		
+	TRACE_SCOPE("simulationTick");
+#ifndef NDEBUG
+	size_t copyCountBeforeTick = StateCopyCounter::getCopyCount();
+#endif
+
+	//Every tick's inputs come before the tick is simulated, so this is the state a replay reaches once it has applied them
+	if (eventLogWriterPtr && eventLogWriterPtr->isCheckpointDue(currentTick)) {
+		saveCheckpoint(eventLogCheckpoint);
+		eventLogWriterPtr->logCheckpoint(currentTick, eventLogCheckpoint);
+	}
+
+	//Move the elevators according to their stop sets
+	//The shafts move independently, so they are split into one range per worker thread
+	size_t numberOfShafts = currentState.elevatorShaftVector.size();
+	size_t rangeCount = 1;
+	if (tickWorkerPool && numberOfShafts >= PARALLEL_TICK_MINIMUM_SHAFTS) {
+		rangeCount = tickWorkerPool->getWorkerCount();
+	}
+
+	size_t rangeBegin = 0;
+	for (size_t i = 0; i < rangeCount; i++) {
+		size_t rangeEnd = i + 1 == rangeCount ? numberOfShafts : alignRangeBoundary(numberOfShafts * (i + 1) / rangeCount);
+		shaftTickRanges[i].beginShaft = rangeBegin;
+		shaftTickRanges[i].endShaft = rangeEnd < rangeBegin ? rangeBegin : rangeEnd;
+		rangeBegin = shaftTickRanges[i].endShaft;
+	}
+
+	if (rangeCount == 1) {
+		tickShaftRange(shaftTickRanges[0]);
+	}
+	else {
+		tickWorkerPool->run([this](size_t rangeIndex) {
+			tickShaftRange(shaftTickRanges[rangeIndex]);
+		});
+	}
+
+	//Merge the changes in shaft order, so the result is the same as ticking every shaft on one thread
+	for (size_t i = 0; i < rangeCount; i++) {
+		applyShaftTickRange(shaftTickRanges[i]);
+	}
+	currentTick++;
+
+	//refresh the view, unless this tick is part of a batch
+	if (!publishingDeferred) {
+		publishEvents();
+	}
+
+	//Neither the tick nor the display refresh should have copied the state
+	assert(StateCopyCounter::getCopyCount() == copyCountBeforeTick);
+}
+
+//Moves the shafts in a range. Only the shafts in the range, and the range itself, are written to.
+void Elevator::ElevatorController::tickShaftRange(ShaftTickRange& shaftTickRange) {
+	TRACE_SCOPE("tickShaftRange");
+	shaftTickRange.servicedFloors.clear();
+	shaftTickRange.changedShafts.clear();
+	shaftTickRange.simulationEvents.clear();
+
+	for (size_t i = shaftTickRange.beginShaft; i < shaftTickRange.endShaft; i++) {
+		ElevatorShaft& elevatorShaft = currentState.elevatorShaftVector[i];
+
+		//Stop for a call on the way to the next stop. The calls only change once every range has been ticked, so every shaft sees the same calls.
+		int hallCallFloor = findHallCallAhead(i);
+		if (hallCallFloor >= 0) {
+			elevatorShaft.requestFloor(hallCallFloor);
+			if (recordingEvents) {
+				SimulationEvent stopAdded = { SimulationEventType::StopAdded, static_cast<uint32_t>(i), hallCallFloor, 0 };
+				shaftTickRange.simulationEvents.push_back(stopAdded);
+			}
+		}
+
 		//Get the current floor before the elevator moves. This is needed to track if a call was met or not.
-		int currentFloor = currentState.elevatorShaftVector[i].getCurrentElevatorState().currentPosition;
-		
+		int currentFloor = elevatorShaft.getCurrentPosition();
+		MovementStatus previousStatus = elevatorShaft.getCurrentMovementStatus();
+		size_t previousStopCount = elevatorShaft.getStopCount();
+
 		//Move the elevator to the next floor in it's queue(s)
-		bool servicedFloor = currentState.elevatorShaftVector[i].gotoNextFloorInQueue();
+		//A waiting shaft services its floor every tick without changing, so only shafts that moved, or whose status or stops changed, update the dispatch index
+		bool servicedFloor = elevatorShaft.gotoNextFloorInQueue();
+		if (elevatorShaft.getCurrentPosition() != currentFloor || elevatorShaft.getCurrentMovementStatus() != previousStatus
+			|| elevatorShaft.getStopCount() != previousStopCount || hallCallFloor >= 0) {
+			shaftTickRange.changedShafts.push_back(i);
+		}
+		if (recordingEvents) {
+			recordShaftTickEvents(shaftTickRange.simulationEvents, i, currentFloor, previousStatus, previousStopCount);
+		}
 
 		//If it has serviced a floor, then it means that is responding to a floor call
-		//Update the state to reflect that
 		if (servicedFloor) {
-			MovementStatus movementStatus = currentState.elevatorShaftVector[i].getCurrentElevatorState().movementStatus;
-			currentState.floorsVector[currentFloor].callMet(movementStatus);
+			MovementStatus movementStatus = elevatorShaft.getCurrentMovementStatus();
+			ServicedFloor servicedFloor = { i, currentFloor, movementStatus, isTurnAround(previousStatus, movementStatus) };
+			shaftTickRange.servicedFloors.push_back(servicedFloor);
 		}
 	}
+}
 
-	simulationStateDisplay.refreshDisplay(currentState); //refresh the view
+//Applies a range's changes to the floors and the dispatch index
+void Elevator::ElevatorController::applyShaftTickRange(ShaftTickRange& shaftTickRange) {
+	TRACE_SCOPE("applyShaftTickRange");
+	if (recordingEvents) {
+		pendingEventBatch.simulationEvents.insert(pendingEventBatch.simulationEvents.end(), shaftTickRange.simulationEvents.begin(), shaftTickRange.simulationEvents.end());
+	}
+
+	//Update the floors to reflect the calls that were met
+	for (size_t i = 0; i < shaftTickRange.servicedFloors.size(); i++) {
+		floorServiced(shaftTickRange.servicedFloors[i], currentTick + 1);
+	}
 
+	for (size_t i = 0; i < shaftTickRange.changedShafts.size(); i++) {
+		size_t shaft = shaftTickRange.changedShafts[i];
+		dispatchIndex.updateShaft(shaft, currentState.elevatorShaftVector[shaft]);
+	}
 }
 
-//Simulates multiple ticks, with a short wait period in between ticks
+//Clears the call that a shaft met, and boards and drops off its passengers. tick is when the shaft serviced the floor.
+void Elevator::ElevatorController::floorServiced(const ServicedFloor& servicedFloor, size_t tick) {
+	HallCallSet& hallCalls = currentState.hallCalls;
+	ElevatorShaft& elevatorShaft = currentState.elevatorShaftVector[servicedFloor.shaft];
+	//A shaft meets the call in the direction it leaves in. Where it turns around, it also meets the call in the direction it arrived in, as it is
+	//the end of that run. Otherwise two calls at the ends of its runs, each the other way to the shaft, would send it back and forth between them for ever.
+	MovementStatus movementStatus = servicedFloor.turnedAround ? MovementStatus::Waiting : servicedFloor.movementStatus;
+	if (movementStatus != MovementStatus::MovingDown && hallCalls.callMet(servicedFloor.floor, MovementDirection::Up)) {
+		recordEvent(SimulationEventType::CallCleared, servicedFloor.shaft, servicedFloor.floor, static_cast<int>(MovementDirection::Up));
+	}
+	if (movementStatus != MovementStatus::MovingUp && hallCalls.callMet(servicedFloor.floor, MovementDirection::Down)) {
+		recordEvent(SimulationEventType::CallCleared, servicedFloor.shaft, servicedFloor.floor, static_cast<int>(MovementDirection::Down));
+	}
+
+	//A shaft passing through only clears the call in the direction it is leaving in, but the stop is gone from its stop sets.
+	//If it was also assigned the call in the other direction, it needs to come back for it. It will arrive in that direction, so the call is met then.
+	if ((hallCalls.isCallingForUp(servicedFloor.floor) && hallCallShafts[2 * servicedFloor.floor] == servicedFloor.shaft)
+		|| (hallCalls.isCallingForDown(servicedFloor.floor) && hallCallShafts[2 * servicedFloor.floor + 1] == servicedFloor.shaft)) {
+		requestShaftFloor(servicedFloor.shaft, servicedFloor.floor);
+	}
+
+	if (!passengerTracker.hasPassengers()) {
+		return;
+	}
+
+	const std::vector<int>& floorsToRequest = passengerTracker.floorServiced(servicedFloor.shaft, servicedFloor.floor,
+		movementStatus, elevatorShaft.getCurrentPosition(), tick);
+	for (size_t i = 0; i < floorsToRequest.size(); i++) {
+		requestShaftFloor(servicedFloor.shaft, floorsToRequest[i]);
+	}
+}
+
+//Simulates one tick for a single shaft, applying its changes to the floors and the dispatch index straight away.
+//Calling pickUpHallCallAhead for every shaft, then ticking every shaft in order like this, gives the same result as simulationTick, without refreshing the display.
+//tick is the tick being simulated, which the event driven engine tracks itself.
+void Elevator::ElevatorController::tickShaft(size_t shaft, size_t tick) {
+	ElevatorShaft& elevatorShaft = currentState.elevatorShaftVector[shaft];
+	int currentFloor = elevatorShaft.getCurrentPosition();
+	MovementStatus previousStatus = elevatorShaft.getCurrentMovementStatus();
+	size_t previousStopCount = recordingEvents ? elevatorShaft.getStopCount() : 0;
+
+	bool servicedFloor = elevatorShaft.gotoNextFloorInQueue();
+	dispatchIndex.updateShaft(shaft, elevatorShaft);
+	if (recordingEvents) {
+		recordShaftTickEvents(pendingEventBatch.simulationEvents, shaft, currentFloor, previousStatus, previousStopCount);
+	}
+
+	if (servicedFloor) {
+		MovementStatus movementStatus = elevatorShaft.getCurrentMovementStatus();
+		ServicedFloor shaftServicedFloor = { shaft, currentFloor, movementStatus, isTurnAround(previousStatus, movementStatus) };
+		floorServiced(shaftServicedFloor, tick + 1);
+	}
+}
+
+//Finds a call the shaft can stop for on its way to its next stop, made in the direction it is travelling. Returns -1 if there is none.
+//Only the calls before the next stop are considered, so a shaft that stops for one carries on in the call's direction.
+int Elevator::ElevatorController::findHallCallAhead(size_t shaft) const {
+	const ElevatorShaft& elevatorShaft = currentState.elevatorShaftVector[shaft];
+	MovementStatus movementStatus = elevatorShaft.getCurrentMovementStatus();
+	if ((movementStatus != MovementStatus::MovingUp && movementStatus != MovementStatus::MovingDown) || !elevatorShaft.hasFloorsInCurrentDirectionQueue()) {
+		return -1;
+	}
+	MovementDirection direction = movementStatus == MovementStatus::MovingUp ? MovementDirection::Up : MovementDirection::Down;
+	return currentState.hallCalls.findCallAhead(elevatorShaft.getCurrentPosition(), direction, elevatorShaft.getNextFloorInQueue());
+}
+
+//Adds a stop for the call ahead of a shaft, if there is one, as simulationTick does at the start of each shaft's tick
+void Elevator::ElevatorController::pickUpHallCallAhead(size_t shaft) {
+	int hallCallFloor = findHallCallAhead(shaft);
+	if (hallCallFloor >= 0) {
+		requestShaftFloor(shaft, hallCallFloor);
+	}
+}
+
+//Moves a shaft floorCount floors in its direction at once, the same as floorCount ticks where it does not reach a stop.
+//The caller is responsible for making sure there is no stop along the way.
+void Elevator::ElevatorController::advanceShaft(size_t shaft, int floorCount) {
+	ElevatorShaft& elevatorShaft = currentState.elevatorShaftVector[shaft];
+	int currentFloor = elevatorShaft.getCurrentPosition();
+
+	elevatorShaft.advanceFloors(floorCount);
+	if (elevatorShaft.getCurrentPosition() != currentFloor) {
+		dispatchIndex.updateShaft(shaft, elevatorShaft);
+		recordEvent(SimulationEventType::ShaftMoved, shaft, elevatorShaft.getCurrentPosition(), currentFloor);
+	}
+}
+
+//A shaft's position, status and enabled flag, which are followed by its stop set words in a checkpoint.
+//Zeroed before it is filled in, so its padding bytes are not written out uninitialized.
+struct ShaftCheckpoint {
+	int32_t currentPosition;
+	uint8_t movementStatus;
+	uint8_t enabled;
+};
+
+//Writes the whole simulation into the checkpoint: the building, the tick, each shaft followed by its stop set words,
+//the floors' call flags, the shaft assigned to each call, and the passengers.
+void Elevator::ElevatorController::saveCheckpoint(SimulationCheckpoint& checkpoint) const {
+	checkpoint.clear();
+	checkpoint.write(CHECKPOINT_MAGIC);
+	checkpoint.write(currentState.simulationSettings.numberOfFloors);
+	checkpoint.write(currentState.simulationSettings.numberOfShafts);
+	checkpoint.write(static_cast<uint64_t>(currentTick));
+
+	for (size_t i = 0; i < currentState.elevatorShaftVector.size(); i++) {
+		const ElevatorShaft& elevatorShaft = currentState.elevatorShaftVector[i];
+		const ElevatorState& elevatorState = elevatorShaft.getCurrentElevatorState();
+		ShaftCheckpoint shaftCheckpoint;
+		std::memset(&shaftCheckpoint, 0, sizeof(shaftCheckpoint));
+		shaftCheckpoint.currentPosition = elevatorState.currentPosition;
+		shaftCheckpoint.movementStatus = static_cast<uint8_t>(elevatorState.movementStatus);
+		shaftCheckpoint.enabled = elevatorShaft.isEnabled() ? 1 : 0;
+		checkpoint.write(shaftCheckpoint);
+
+		const std::vector<uint64_t>& floorsAboveWords = elevatorState.floorsAboveStopSet.getWords();
+		const std::vector<uint64_t>& floorsBelowWords = elevatorState.floorsBelowStopSet.getWords();
+		checkpoint.writeBytes(floorsAboveWords.data(), floorsAboveWords.size() * sizeof(uint64_t));
+		checkpoint.writeBytes(floorsBelowWords.data(), floorsBelowWords.size() * sizeof(uint64_t));
+	}
+
+	for (size_t i = 0; i < currentState.floorsVector.size(); i += CALL_FLAGS_PER_WORD) {
+		uint64_t callFlags = 0;
+		for (size_t j = 0; j < CALL_FLAGS_PER_WORD && i + j < currentState.floorsVector.size(); j++) {
+			int floorNumber = static_cast<int>(i + j);
+			callFlags |= static_cast<uint64_t>(currentState.hallCalls.isCallingForUp(floorNumber) ? 1 : 0) << (2 * j);
+			callFlags |= static_cast<uint64_t>(currentState.hallCalls.isCallingForDown(floorNumber) ? 1 : 0) << (2 * j + 1);
+		}
+		checkpoint.write(callFlags);
+	}
+
+	//Written as 64 bit words, so the layout does not depend on the size of size_t
+	for (size_t i = 0; i < hallCallShafts.size(); i++) {
+		checkpoint.write(static_cast<uint64_t>(hallCallShafts[i]));
+	}
+	passengerTracker.saveCheckpoint(checkpoint);
+}
+
+//Returns the simulation to a checkpoint saved from the same building. Everything is copied into the existing storage, so it does not allocate.
+//The dispatch index is rebuilt from the restored positions.
+bool Elevator::ElevatorController::restoreCheckpoint(SimulationCheckpoint& checkpoint) {
+	checkpoint.rewind();
+	uint64_t magic, tick;
+	int numberOfFloors, numberOfShafts;
+	if (!checkpoint.read(magic) || !checkpoint.read(numberOfFloors) || !checkpoint.read(numberOfShafts) || !checkpoint.read(tick)
+		|| magic != CHECKPOINT_MAGIC
+		|| numberOfFloors != currentState.simulationSettings.numberOfFloors
+		|| numberOfShafts != currentState.simulationSettings.numberOfShafts) {
+		return false;
+	}
+
+	//Check the rest of the checkpoint, after the header just read, is long enough before changing anything. Only the passengers are variable in size.
+	size_t wordsPerStopSet = currentState.elevatorShaftVector[0].getCurrentElevatorState().floorsAboveStopSet.getWords().size();
+	size_t fixedSize = currentState.elevatorShaftVector.size() * (sizeof(uint64_t) + 2 * wordsPerStopSet * sizeof(uint64_t))
+		+ (currentState.floorsVector.size() + CALL_FLAGS_PER_WORD - 1) / CALL_FLAGS_PER_WORD * sizeof(uint64_t)
+		+ hallCallShafts.size() * sizeof(uint64_t);
+	if (checkpoint.remainingSize() < fixedSize) {
+		return false;
+	}
+
+	//Then check every value, as a checkpoint file may be corrupt, and read back from here once it has passed
+	size_t stateStart = checkpoint.getReadPosition();
+	if (!canRestoreCheckpoint(checkpoint, static_cast<size_t>(tick))) {
+		return false;
+	}
+	checkpoint.seek(stateStart);
+
+	currentTick = static_cast<size_t>(tick);
+	dispatchIndex.clear();
+	for (size_t i = 0; i < currentState.elevatorShaftVector.size(); i++) {
+		ShaftCheckpoint shaftCheckpoint;
+		checkpoint.read(shaftCheckpoint);
+		const uint64_t* floorsAboveWords = static_cast<const uint64_t*>(checkpoint.readBytes(wordsPerStopSet * sizeof(uint64_t)));
+		const uint64_t* floorsBelowWords = static_cast<const uint64_t*>(checkpoint.readBytes(wordsPerStopSet * sizeof(uint64_t)));
+		ElevatorShaft& elevatorShaft = currentState.elevatorShaftVector[i];
+		elevatorShaft.restoreState(shaftCheckpoint.currentPosition, static_cast<MovementStatus>(shaftCheckpoint.movementStatus),
+			shaftCheckpoint.enabled != 0, floorsAboveWords, floorsBelowWords);
+		dispatchIndex.updateShaft(i, elevatorShaft);
+	}
+
+	//The flags were valid for each floor when they were saved, so calling again sets the same calls
+	currentState.hallCalls.clear();
+	for (size_t i = 0; i < currentState.floorsVector.size(); i += CALL_FLAGS_PER_WORD) {
+		uint64_t callFlags = 0;
+		checkpoint.read(callFlags);
+		for (size_t j = 0; j < CALL_FLAGS_PER_WORD && i + j < currentState.floorsVector.size(); j++) {
+			int floorNumber = static_cast<int>(i + j);
+			if ((callFlags >> (2 * j)) & 1) {
+				currentState.hallCalls.call(floorNumber, MovementDirection::Up);
+			}
+			if ((callFlags >> (2 * j + 1)) & 1) {
+				currentState.hallCalls.call(floorNumber, MovementDirection::Down);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < hallCallShafts.size(); i++) {
+		uint64_t hallCallShaft = 0;
+		checkpoint.read(hallCallShaft);
+		hallCallShafts[i] = static_cast<size_t>(hallCallShaft);
+	}
+
+	passengerTracker.restoreCheckpoint(checkpoint);
+	pendingEventBatch.simulationEvents.clear();
+	recordEvent(SimulationEventType::StateReplaced, 0, 0, 0);
+	publishEvents();
+	return true;
+}
+
+//Reads the shafts, calls and passengers after the header without restoring them, checking each is valid for this building.
+//The checkpoint has already been checked to be long enough for the shafts, calls and assigned shafts.
+bool Elevator::ElevatorController::canRestoreCheckpoint(SimulationCheckpoint& checkpoint, size_t tick) const {
+	size_t wordsPerStopSet = currentState.elevatorShaftVector[0].getCurrentElevatorState().floorsAboveStopSet.getWords().size();
+	for (size_t i = 0; i < currentState.elevatorShaftVector.size(); i++) {
+		ShaftCheckpoint shaftCheckpoint;
+		checkpoint.read(shaftCheckpoint);
+		const uint64_t* floorsAboveWords = static_cast<const uint64_t*>(checkpoint.readBytes(wordsPerStopSet * sizeof(uint64_t)));
+		const uint64_t* floorsBelowWords = static_cast<const uint64_t*>(checkpoint.readBytes(wordsPerStopSet * sizeof(uint64_t)));
+		if (shaftCheckpoint.enabled > 1 || !currentState.elevatorShaftVector[i].canRestoreState(shaftCheckpoint.currentPosition,
+			static_cast<MovementStatus>(shaftCheckpoint.movementStatus), floorsAboveWords, floorsBelowWords)) {
+			return false;
+		}
+	}
+
+	//Only calls that callElevator could have made are accepted: no up call on the top floor, no down call on the bottom floor, and nothing past the top floor
+	int numberOfFloors = currentState.simulationSettings.numberOfFloors;
+	for (size_t i = 0; i < currentState.floorsVector.size(); i += CALL_FLAGS_PER_WORD) {
+		uint64_t callFlags = 0;
+		checkpoint.read(callFlags);
+		for (size_t j = 0; j < CALL_FLAGS_PER_WORD; j++) {
+			int floorNumber = static_cast<int>(i + j);
+			bool upAllowed = floorNumber < numberOfFloors - 1;
+			bool downAllowed = floorNumber > 0 && floorNumber < numberOfFloors;
+			if ((((callFlags >> (2 * j)) & 1) && !upAllowed) || (((callFlags >> (2 * j + 1)) & 1) && !downAllowed)) {
+				return false;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < hallCallShafts.size(); i++) {
+		uint64_t hallCallShaft = 0;
+		checkpoint.read(hallCallShaft);
+		if (hallCallShaft >= currentState.elevatorShaftVector.size()) {
+			return false;
+		}
+	}
+	return passengerTracker.canRestoreCheckpoint(checkpoint, tick);
+}
+
+//Moves a range boundary forward so that the next range's first shaft starts on a new cache line, and two workers do not write to the same shaft line.
+//This only covers the shaft objects. Each shaft's stop set words are its own heap block, so only the shafts either side of a boundary can share a line there.
+//Gives up and returns the original boundary if no shaft within a cache line's worth of shafts is aligned.
+size_t Elevator::ElevatorController::alignRangeBoundary(size_t shaft) const {
+	const std::vector<ElevatorShaft>& elevatorShafts = currentState.elevatorShaftVector;
+	for (size_t i = shaft; i < shaft + CACHE_LINE_SIZE && i < elevatorShafts.size(); i++) {
+		if (reinterpret_cast<uintptr_t>(&elevatorShafts[i]) % CACHE_LINE_SIZE == 0) {
+			return i;
+		}
+	}
+	return shaft;
+}
+
+//Splits the shafts across this many threads each tick. The threads are kept until the count changes.
+//1 ticks on the calling thread only.
+void Elevator::ElevatorController::setWorkerThreadCount(size_t workerThreadCount) {
+	if (workerThreadCount == getWorkerThreadCount()) {
+		return;
+	}
+
+	tickWorkerPool.reset();
+	if (workerThreadCount > 1) {
+		tickWorkerPool.reset(new TickWorkerPool(workerThreadCount));
+	}
+	shaftTickRanges.reset(workerThreadCount < 1 ? 1 : workerThreadCount);
+}
+
+//Simulates multiple ticks back to back. Their changes are published as one batch, so the display is only drawn once.
+//Pacing the ticks in real time is up to the caller, see TickPacer.
 void Elevator::ElevatorController::simulationTick(size_t numberOfTicks) {
+	publishingDeferred = true;
 	for (size_t i = 0; i < numberOfTicks; i++) {
 		simulationTick();
-		std::this_thread::sleep_for(std::chrono::seconds(TICK_DURATION));
+	}
+	publishingDeferred = false;
+	publishEvents();
+}
+
+//Sends the changes since the last batch to the display and the listeners. Does nothing when running headless with no listeners.
+void Elevator::ElevatorController::publishEvents() {
+	if (!recordingEvents) {
+		return;
+	}
+
+	pendingEventBatch.tick = currentTick;
+	if (displayEnabled) {
+		simulationStateDisplay.simulationEventsPublished(pendingEventBatch, currentState);
+	}
+	for (size_t i = 0; i < eventListeners.size(); i++) {
+		eventListeners[i]->simulationEventsPublished(pendingEventBatch, currentState);
+	}
+	pendingEventBatch.simulationEvents.clear();
+}
+
+void Elevator::ElevatorController::addEventListener(SimulationEventListener* eventListenerPtr) {
+	eventListeners.push_back(eventListenerPtr);
+	updateRecordingEvents();
+}
+
+void Elevator::ElevatorController::removeEventListener(SimulationEventListener* eventListenerPtr) {
+	eventListeners.erase(std::remove(eventListeners.begin(), eventListeners.end(), eventListenerPtr), eventListeners.end());
+	updateRecordingEvents();
+}
+
+//Adds a stop to a shaft. Repeated requests for a stop, and requests the shaft ignores, are not recorded.
+void Elevator::ElevatorController::requestShaftFloor(size_t shaft, int floorNumber) {
+	ElevatorShaft& elevatorShaft = currentState.elevatorShaftVector[shaft];
+	size_t previousStopCount = elevatorShaft.getStopCount();
+	elevatorShaft.requestFloor(floorNumber);
+	if (elevatorShaft.getStopCount() != previousStopCount) {
+		dispatchIndex.updateShaft(shaft, elevatorShaft);
+		recordEvent(SimulationEventType::StopAdded, shaft, floorNumber, 0);
+	}
+}
+
+//Records what changed when a shaft was ticked. A tick removes at most one stop, the floor the shaft was on.
+void Elevator::ElevatorController::recordShaftTickEvents(std::vector<SimulationEvent>& simulationEvents, size_t shaft, int previousFloor,
+	MovementStatus previousStatus, size_t previousStopCount) const {
+	const ElevatorShaft& elevatorShaft = currentState.elevatorShaftVector[shaft];
+	uint32_t shaftNumber = static_cast<uint32_t>(shaft);
+	if (elevatorShaft.getStopCount() != previousStopCount) {
+		SimulationEvent stopRemoved = { SimulationEventType::StopRemoved, shaftNumber, previousFloor, 0 };
+		simulationEvents.push_back(stopRemoved);
+	}
+	if (elevatorShaft.getCurrentMovementStatus() != previousStatus) {
+		SimulationEvent statusChanged = { SimulationEventType::StatusChanged, shaftNumber, previousFloor, static_cast<int>(elevatorShaft.getCurrentMovementStatus()) };
+		simulationEvents.push_back(statusChanged);
+	}
+	if (elevatorShaft.getCurrentPosition() != previousFloor) {
+		SimulationEvent shaftMoved = { SimulationEventType::ShaftMoved, shaftNumber, elevatorShaft.getCurrentPosition(), previousFloor };
+		simulationEvents.push_back(shaftMoved);
 	}
 }
 
@@ -2,11 +2,38 @@
 #include "ElevatorState.h"
 #include "SimState.h"
 #include "SimulationStateDisplay.h"
+#include "DispatchIndex.h"
+#include "TickWorkerPool.h"
+#include "CacheAlignedArray.h"
+#include "PassengerTracker.h"
+#include "EventLog.h"
+#include "SimulationCheckpoint.h"
+#include "SimulationEvents.h"
 #include <thread>
 #include <chrono>
+#include <memory>
 
 namespace Elevator {
 
+	//A shaft that serviced a floor during a tick, and its movement status afterwards
+	struct ServicedFloor {
+		size_t shaft;
+		int floor;
+		MovementStatus movementStatus;
+		bool turnedAround;											//True if it leaves in the opposite direction to the one it arrived in
+	};
+
+	//A contiguous range of shafts that is moved by one worker during a tick.
+	//Changes to the floors and the dispatch index are recorded, and applied once every range has finished, in range order.
+	//The recorded lists are separate heap blocks for each range, so neighbouring workers can at most share the line where two blocks meet.
+	struct ShaftTickRange {
+		size_t beginShaft;
+		size_t endShaft;
+		std::vector<ServicedFloor> servicedFloors;					//Each shaft that serviced a floor
+		std::vector<size_t> changedShafts;							//Each shaft that moved, or whose status or stops changed, for the dispatch index
+		std::vector<SimulationEvent> simulationEvents;				//Changes to the shafts, only recorded while something is listening
+	};
+
 	//Class handles inter-elevator shaft logic
 	//And updates the view when the state changes
 	//This is the primary controller, with the remaining logic in the ElevatorShaft class.
@@ -15,24 +42,125 @@ namespace Elevator {
 	public:
 		ElevatorController(SimulationSettings settings);
 		~ElevatorController();
-		void callElevator(int floor, MovementDirection direction);	//Calls an elevator to a given floor, based on the direction that the passenger intends to travel
+		size_t callElevator(int floor, MovementDirection direction);	//Calls an elevator to a given floor, based on the direction that the passenger intends to travel. Returns the shaft assigned to the call.
 		void requestFloor(int shaft, int floorNumber);		//Requests that a specific elevator travels to a specific floor
-		SimulationState getCurrentState() const;			//Returns the current simulation state.
+		void addPassenger(int originFloor, int destinationFloor);	//Adds a passenger, who calls an elevator and requests their destination once it arrives
+		const PassengerTracker& getPassengerTracker() const;	//Wait and journey times of the passengers
+		const SimulationState& getCurrentState() const;		//Returns the current simulation state, without copying it.
 		void simulationTick();								//Simulates the passage of time. This simulation moves the elevators at a pace of one floor per tick
-		void simulationTick(size_t numberOfTicks);			//Simulates multiple ticks, with a short wait period in between ticks
+		void simulationTick(size_t numberOfTicks);			//Simulates multiple ticks back to back, publishing their changes as one batch
 		SimulationStateDisplay simulationStateDisplay;		//Used to display the current state in a windows console window
+		void setDisplayEnabled(bool enabled);				//Headless runs disable the display, which also removes the wait between ticks
+		bool isDisplayEnabled() const;
+		void setWorkerThreadCount(size_t workerThreadCount);	//Splits the shafts across this many threads each tick. 1 ticks on the calling thread only.
+		size_t getWorkerThreadCount() const;
+		void tickShaft(size_t shaft, size_t tick);			//Simulates one tick for a single shaft, after pickUpHallCallAhead. Used by the event driven engine, which ticks shafts individually
+		void pickUpHallCallAhead(size_t shaft);				//Adds a stop for a call the shaft passes on the way to its next stop, in its direction
+		bool hasHallCallAhead(size_t shaft) const;
+		size_t getCurrentTick() const;						//Number of ticks simulated, used to time the passengers
+		void setCurrentTick(size_t tick);					//Used by the event driven engine, which keeps its own time
+		void advanceShaft(size_t shaft, int floorCount);	//Moves a shaft several floors at once, without servicing any floor along the way
+		void saveCheckpoint(SimulationCheckpoint& checkpoint) const;	//Writes the shafts, floors, calls and passengers into the checkpoint, replacing what it held
+		//Returns the simulation to a checkpoint saved from the same building, without allocating. The passenger histograms start again from empty.
+		//Returns false, leaving the state unchanged, if the checkpoint is for a different building, ends early, or holds any value that could not have been saved from it.
+		bool restoreCheckpoint(SimulationCheckpoint& checkpoint);
+		DispatchPolicyType getDispatchPolicy() const;		//The policy from the settings, used to assign every hall call
+		void setEventLogWriter(EventLogWriter* eventLogWriterPtr);	//Calls, floor requests and passengers are appended to the log, stamped with the current tick, with a checkpoint at each interval. nullptr stops logging.
+		void addEventListener(SimulationEventListener* eventListenerPtr);	//The listener gets every batch of changes until it is removed. Not owned.
+		void removeEventListener(SimulationEventListener* eventListenerPtr);
+		void publishEvents();								//Sends the changes since the last batch to the display and the listeners. Ticks and inputs publish their own changes.
 
 		bool isValidFloorNumber(int floorNumber) const;		//Utility method for checking if a given floor number is valid. Returns true if valid.
 		bool isValidShaftNumber(int shaftNumber) const;		//Utility method for checking if a given shaft number is valid. Returns true if valid.
 
 	private:
 		SimulationState currentState;						//Only the controller should be able to modify the simulation state. 
+		bool displayEnabled;
+		DispatchIndex dispatchIndex;						//Finds the lowest cost shaft for a call, kept up to date as the shafts move
+		PassengerTracker passengerTracker;
+		std::vector<size_t> hallCallShafts;					//The shaft last assigned to each floor's call, up then down
+		size_t currentTick;
+		EventLogWriter* eventLogWriterPtr;					//Not owned, nullptr when the inputs are not being logged
+		SimulationCheckpoint eventLogCheckpoint;			//Reused for each checkpoint stored beside the log
+		size_t assignCall(const DispatchCall& dispatchCall);	//Assigns a call to the lowest cost shaft under the dispatch policy, without logging it
+		template <class DispatchPolicy>
+		size_t assignCallWithPolicy(const DispatchCall& dispatchCall);	//Instantiated for each policy, so the policy's cost is inlined into the search
+		int findHallCallAhead(size_t shaft) const;			//The floor of a call the shaft can stop for on its way, or -1
+		void floorServiced(const ServicedFloor& servicedFloor, size_t tick);	//Clears the floor's call, and boards and drops off passengers
+		void recordEvent(SimulationEventType eventType, size_t shaft, int floor, int value);	//Adds a change to the next batch, if anything is listening
+		void requestShaftFloor(size_t shaft, int floorNumber);	//Adds a stop to a shaft, recording it if it was not already a stop
+		void updateRecordingEvents();						//Changes are only recorded while the display or a listener wants them
+		void recordShaftTickEvents(std::vector<SimulationEvent>& simulationEvents, size_t shaft, int previousFloor, MovementStatus previousStatus, size_t previousStopCount) const;
+		template <class DispatchPolicy>
+		size_t findLowestCostShaftByScan(const DispatchCall& dispatchCall) const;	//Checks every shaft for the lowest cost, used to verify the dispatch index
+		bool canRestoreCheckpoint(SimulationCheckpoint& checkpoint, size_t tick) const;	//Reads past the state after the header, checking every value is valid for this building
+
+		void tickShaftRange(ShaftTickRange& shaftTickRange);	//Moves the shafts in a range, only writing to those shafts and the range
+		void applyShaftTickRange(ShaftTickRange& shaftTickRange);	//Applies a range's changes to the floors and the dispatch index
+		size_t alignRangeBoundary(size_t shaft) const;		//Moves a range boundary forward so that the range's shafts start on a new cache line
+		std::unique_ptr<TickWorkerPool> tickWorkerPool;		//Only created when ticking on more than one thread
+		CacheAlignedArray<ShaftTickRange> shaftTickRanges;	//One range per worker, reused between ticks. Each starts on its own cache line, as the workers write to them.
+		std::vector<SimulationEventListener*> eventListeners;
+		SimulationEventBatch pendingEventBatch;				//Changes since the last batch was published
+		bool recordingEvents;								//True while the display or a listener wants the changes
+		bool publishingDeferred;							//True while simulationTick(size_t) is batching ticks
 		
 	};
 
-	inline SimulationState ElevatorController::getCurrentState() const {
+	inline const SimulationState& ElevatorController::getCurrentState() const {
 		return currentState;
 	}
+
+	inline const PassengerTracker& ElevatorController::getPassengerTracker() const {
+		return passengerTracker;
+	}
+
+	inline size_t ElevatorController::getCurrentTick() const {
+		return currentTick;
+	}
+
+	inline void ElevatorController::setCurrentTick(size_t tick) {
+		currentTick = tick;
+	}
+
+	inline DispatchPolicyType ElevatorController::getDispatchPolicy() const {
+		return currentState.simulationSettings.dispatchPolicy;
+	}
+
+	inline void ElevatorController::setEventLogWriter(EventLogWriter* _eventLogWriterPtr) {
+		eventLogWriterPtr = _eventLogWriterPtr;
+	}
+
+	inline void ElevatorController::setDisplayEnabled(bool enabled) {
+		displayEnabled = enabled;
+		updateRecordingEvents();
+	}
+
+	inline void ElevatorController::updateRecordingEvents() {
+		recordingEvents = displayEnabled || !eventListeners.empty();
+		if (!recordingEvents) {
+			pendingEventBatch.simulationEvents.clear();
+		}
+	}
+
+	inline void ElevatorController::recordEvent(SimulationEventType eventType, size_t shaft, int floor, int value) {
+		if (recordingEvents) {
+			SimulationEvent simulationEvent = { eventType, static_cast<uint32_t>(shaft), floor, value };
+			pendingEventBatch.simulationEvents.push_back(simulationEvent);
+		}
+	}
+
+	inline bool ElevatorController::isDisplayEnabled() const {
+		return displayEnabled;
+	}
+
+	inline bool ElevatorController::hasHallCallAhead(size_t shaft) const {
+		return findHallCallAhead(shaft) >= 0;
+	}
+
+	inline size_t ElevatorController::getWorkerThreadCount() const {
+		return tickWorkerPool ? tickWorkerPool->getWorkerCount() : 1;
+	}
 }
 
 
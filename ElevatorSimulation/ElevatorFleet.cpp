@@ -0,0 +1,192 @@
+#include "stdafx.h"
+#include "ElevatorFleet.h"
+#include <cstring>
+
+#define BITS_PER_WORD 64
+
+
+//Creates the fleet, with each elevator waiting at the bottom
+Elevator::ElevatorFleet::ElevatorFleet(int numberOfShafts, int numberOfFloors) :
+	numberOfFloors(numberOfFloors),
+	wordsPerShaft((numberOfFloors + BITS_PER_WORD - 1) / BITS_PER_WORD),
+	positions(numberOfShafts, 0),
+	directions(numberOfShafts, 0),
+	nextStops(numberOfShafts, 0),
+	arrived(numberOfShafts, 0),
+	statuses(numberOfShafts, MovementStatus::Waiting),
+	floorsAboveStopWords(numberOfShafts * wordsPerShaft, 0),
+	floorsBelowStopWords(numberOfShafts * wordsPerShaft, 0),
+	floorsAboveStopCounts(numberOfShafts, 0),
+	floorsBelowStopCounts(numberOfShafts, 0),
+	hasPendingStatusUpdate(numberOfShafts, 0),
+	waitingShaftsOnFloor(numberOfFloors, 0)
+{
+	//An elevator must travel between at least two floors by definition.
+	assert(numberOfFloors >= 2);
+	waitingShaftsOnFloor[0] = numberOfShafts;
+}
+
+//Adds a floor to a shaft's stop sets. Requests for the current floor follow the same rules as ElevatorShaft::requestFloor.
+//The status is recalculated at the start of the next tick.
+void Elevator::ElevatorFleet::requestFloor(size_t shaft, int floorNumber) {
+	assert(floorNumber >= 0 && floorNumber < numberOfFloors);
+	int currentPosition = positions[shaft];
+	if (floorNumber == currentPosition && (directions[shaft] == 0 || nextStops[shaft] == currentPosition)) {
+		return;
+	}
+
+	//A moving shaft passing the floor has to come back for it, so it goes in the stop set behind the shaft
+	uint64_t bit = 1ULL << (floorNumber % BITS_PER_WORD);
+	size_t wordIndex = shaft * wordsPerShaft + floorNumber / BITS_PER_WORD;
+	if (floorNumber > currentPosition || (floorNumber == currentPosition && directions[shaft] < 0)) {
+		if (floorsAboveStopWords[wordIndex] & bit) {
+			return;
+		}
+		floorsAboveStopWords[wordIndex] |= bit;
+		floorsAboveStopCounts[shaft]++;
+	}
+	else {
+		if (floorsBelowStopWords[wordIndex] & bit) {
+			return;
+		}
+		floorsBelowStopWords[wordIndex] |= bit;
+		floorsBelowStopCounts[shaft]++;
+	}
+
+	if (!hasPendingStatusUpdate[shaft]) {
+		hasPendingStatusUpdate[shaft] = 1;
+		pendingStatusUpdates.push_back(shaft);
+	}
+}
+
+//Keeps the count of waiting shafts on each floor up to date
+void Elevator::ElevatorFleet::setWaiting(size_t shaft, bool waiting) {
+	bool wasWaiting = statuses[shaft] == MovementStatus::Waiting;
+	if (wasWaiting != waiting) {
+		waitingShaftsOnFloor[positions[shaft]] += waiting ? 1 : -1;
+	}
+}
+
+//Recalculates the status, direction and next stop from the stop sets.
+//Follows the same rules as ElevatorShaft::updateCurrentStatus.
+void Elevator::ElevatorFleet::updateCurrentStatus(size_t shaft) {
+	MovementStatus currentStatus = statuses[shaft];
+	bool hasFloorsAbove = floorsAboveStopCounts[shaft] != 0;
+	bool hasFloorsBelow = floorsBelowStopCounts[shaft] != 0;
+
+	if (!hasFloorsAbove && !hasFloorsBelow) {
+		currentStatus = MovementStatus::Waiting;
+	}
+	else if (currentStatus == MovementStatus::Waiting) {
+		currentStatus = hasFloorsAbove ? MovementStatus::MovingUp : MovementStatus::MovingDown;
+	}
+	else if (currentStatus == MovementStatus::MovingUp ? !hasFloorsAbove : !hasFloorsBelow) {
+		//Current direction is empty, but the other direction is not, change directions
+		currentStatus = currentStatus == MovementStatus::MovingDown ? MovementStatus::MovingUp : MovementStatus::MovingDown;
+	}
+
+	setWaiting(shaft, currentStatus == MovementStatus::Waiting);
+	statuses[shaft] = currentStatus;
+
+	const uint64_t* shaftWords;
+	switch (currentStatus) {
+	case MovementStatus::MovingUp:
+		shaftWords = &floorsAboveStopWords[shaft * wordsPerShaft];
+		directions[shaft] = 1;
+		nextStops[shaft] = findSetBitAtOrAbove(shaftWords, wordsPerShaft, 0);
+		break;
+	case MovementStatus::MovingDown:
+		shaftWords = &floorsBelowStopWords[shaft * wordsPerShaft];
+		directions[shaft] = -1;
+		nextStops[shaft] = findSetBitAtOrBelow(shaftWords, numberOfFloors - 1);
+		break;
+	default:
+		directions[shaft] = 0;
+		nextStops[shaft] = positions[shaft];
+		break;
+	}
+}
+
+//Removes the next stop in the direction the shaft is moving
+void Elevator::ElevatorFleet::removeNextFloorFromQueue(size_t shaft) {
+	int nextStop = nextStops[shaft];
+	uint64_t bit = 1ULL << (nextStop % BITS_PER_WORD);
+	size_t wordIndex = shaft * wordsPerShaft + nextStop / BITS_PER_WORD;
+	if (statuses[shaft] == MovementStatus::MovingUp) {
+		floorsAboveStopWords[wordIndex] &= ~bit;
+		floorsAboveStopCounts[shaft]--;
+	}
+	else if (statuses[shaft] == MovementStatus::MovingDown) {
+		floorsBelowStopWords[wordIndex] &= ~bit;
+		floorsBelowStopCounts[shaft]--;
+	}
+}
+
+//Moves every shaft one floor towards its next stop.
+//Shafts that are at their next stop service the floor, which clears its calls, then carry on from there.
+void Elevator::ElevatorFleet::simulationTick(HallCallSet& hallCalls) {
+	const size_t numberOfShafts = positions.size();
+
+	//Requests may have changed the status of some shafts, e.g. from waiting to moving
+	//A shaft that was waiting services its floor as it leaves, as ElevatorShaft::gotoNextFloorInQueue does
+	for (size_t i = 0; i < pendingStatusUpdates.size(); i++) {
+		size_t shaft = pendingStatusUpdates[i];
+		bool wasWaiting = statuses[shaft] == MovementStatus::Waiting;
+		updateCurrentStatus(shaft);
+		if (wasWaiting && statuses[shaft] != MovementStatus::Waiting) {
+			hallCalls.callMet(positions[shaft], statuses[shaft]);
+		}
+		hasPendingStatusUpdate[shaft] = 0;
+	}
+	pendingStatusUpdates.clear();
+
+	//Find the moving shafts that are at their next stop
+	//Kept branch free so that it vectorizes
+	const int32_t* positionData = positions.data();
+	const int32_t* nextStopData = nextStops.data();
+	const int32_t* directionData = directions.data();
+	uint8_t* arrivedData = arrived.data();
+	size_t arrivedCount = 0;
+	for (size_t i = 0; i < numberOfShafts; i++) {
+		uint8_t hasArrived = static_cast<uint8_t>((positionData[i] == nextStopData[i]) & (directionData[i] != 0));
+		arrivedData[i] = hasArrived;
+		arrivedCount += hasArrived;
+	}
+
+	//Service the floors that were arrived at, skipping eight flags at a time where nobody arrived
+	for (size_t i = 0; i < numberOfShafts && arrivedCount > 0; ) {
+		if (i + sizeof(uint64_t) <= numberOfShafts) {
+			uint64_t arrivedFlags;
+			std::memcpy(&arrivedFlags, arrivedData + i, sizeof(uint64_t));
+			if (arrivedFlags == 0) {
+				i += sizeof(uint64_t);
+				continue;
+			}
+		}
+
+		if (arrivedData[i]) {
+			int currentFloor = positions[i];
+			MovementStatus arrivalStatus = statuses[i];
+			removeNextFloorFromQueue(i);
+			updateCurrentStatus(i);
+
+			//A shaft that turns around here meets the calls in both directions, as ElevatorController::floorServiced does
+			hallCalls.callMet(currentFloor, isTurnAround(arrivalStatus, statuses[i]) ? MovementStatus::Waiting : statuses[i]);
+			arrivedCount--;
+		}
+		i++;
+	}
+
+	//Waiting shafts service their floor every tick
+	for (int floor = 0; floor < numberOfFloors; floor++) {
+		if (waitingShaftsOnFloor[floor] != 0) {
+			hallCalls.callMet(floor, MovementStatus::Waiting);
+		}
+	}
+
+	//Move every shaft in its direction, waiting shafts have a direction of 0
+	int32_t* movingPositionData = positions.data();
+	for (size_t i = 0; i < numberOfShafts; i++) {
+		movingPositionData[i] += directionData[i];
+	}
+}
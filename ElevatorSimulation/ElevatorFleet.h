@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "ElevatorState.h"
+#include "HallCallSet.h"
+
+namespace Elevator {
+
+	//Struct of arrays layout for a large number of elevator shafts, used for synthetic stress runs.
+	//The per tick values (position, direction and next stop) are kept in their own contiguous arrays,
+	//so that the move and arrive steps of a tick are simple loops the compiler can vectorize.
+	//Follows the same rules as ElevatorShaft, so a fleet ticks to the same state as a vector of shafts.
+	class ElevatorFleet {
+		public:
+			ElevatorFleet(int numberOfShafts, int numberOfFloors);
+
+			void requestFloor(size_t shaft, int floorNumber);				//Adds a floor to a shaft's stop sets
+			void simulationTick(HallCallSet& hallCalls);					//Moves every shaft one floor, clearing the calls on the floors that were serviced
+
+			size_t getNumberOfShafts() const;
+			int getCurrentPosition(size_t shaft) const;
+			MovementStatus getCurrentMovementStatus(size_t shaft) const;
+			int getNextFloorInQueue(size_t shaft) const;					//The next stop, or the current position if the shaft is waiting
+
+		private:
+			void updateCurrentStatus(size_t shaft);							//Recalculates the status, direction and next stop from the stop sets
+			void removeNextFloorFromQueue(size_t shaft);
+			void setWaiting(size_t shaft, bool waiting);					//Keeps the count of waiting shafts on each floor up to date
+
+			const int numberOfFloors;
+			const size_t wordsPerShaft;										//Stop set words for one shaft
+
+			//Hot arrays, read and written every tick
+			std::vector<int32_t> positions;
+			std::vector<int32_t> directions;								//+1 moving up, -1 moving down, 0 waiting
+			std::vector<int32_t> nextStops;									//Equal to the position while waiting, so waiting shafts service their floor every tick
+			std::vector<uint8_t> arrived;									//Scratch flags for the shafts that reached their next stop this tick
+
+			//Cold arrays, only touched when a shaft arrives or is given a request
+			std::vector<MovementStatus> statuses;
+			std::vector<uint64_t> floorsAboveStopWords;						//wordsPerShaft words for each shaft
+			std::vector<uint64_t> floorsBelowStopWords;
+			std::vector<int32_t> floorsAboveStopCounts;
+			std::vector<int32_t> floorsBelowStopCounts;
+			std::vector<size_t> pendingStatusUpdates;						//Shafts that were given requests since the last tick
+			std::vector<uint8_t> hasPendingStatusUpdate;
+			std::vector<int32_t> waitingShaftsOnFloor;						//Waiting shafts clear the calls on their floor each tick
+	};
+
+	//Inline member functions
+
+	inline size_t ElevatorFleet::getNumberOfShafts() const {
+		return positions.size();
+	}
+
+	inline int ElevatorFleet::getCurrentPosition(size_t shaft) const {
+		return positions[shaft];
+	}
+
+	inline MovementStatus ElevatorFleet::getCurrentMovementStatus(size_t shaft) const {
+		return statuses[shaft];
+	}
+
+	inline int ElevatorFleet::getNextFloorInQueue(size_t shaft) const {
+		return nextStops[shaft];
+	}
+}
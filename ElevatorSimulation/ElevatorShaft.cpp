@@ -6,12 +6,16 @@
 Elevator::ElevatorShaft::ElevatorShaft(int _shaftNumber, int numberOfFloors) : 
 	shaftNumber(_shaftNumber),
 	enabled(true),
+	highestStopAbove(-1),
+	lowestStopBelow(-1),
 	numberOfFloors(numberOfFloors)
 {
 	//An elevator must travel between at least two floors by definition.
 	assert(numberOfFloors >= 2);
 
 	//Default state is each elevator waiting at the bottom
+	elevatorState.floorsAboveStopSet.resize(numberOfFloors);
+	elevatorState.floorsBelowStopSet.resize(numberOfFloors);
 	elevatorState.currentPosition = 0;
 	elevatorState.movementStatus = Elevator::MovementStatus::Waiting;
 }
@@ -44,23 +48,23 @@ void Elevator::ElevatorShaft::disable() {
 	enabled = true;
 }
 
-//Checks if the priority queue is empty based on the movement status of the elevator
+//Checks if the stop set is empty based on the movement status of the elevator
 bool Elevator::ElevatorShaft::hasFloorsInCurrentDirectionQueue() const{
 	if (getCurrentMovementStatus() == MovementStatus::MovingUp) {
-		return !elevatorState.floorsAbovePriorityQueue.empty();
+		return !elevatorState.floorsAboveStopSet.empty();
 	}
-	return !elevatorState.floorsBelowPriorityQueue.empty();
+	return !elevatorState.floorsBelowStopSet.empty();
 }
 
-//Calculates what the current status of the elevator is, based on the priority queue states.
+//Calculates what the current status of the elevator is, based on the stop set states.
 Elevator::MovementStatus Elevator::ElevatorShaft::updateCurrentStatus() {
 	if (!enabled)
 		return MovementStatus::Disabled;
 
 	MovementStatus currentStatus = getCurrentMovementStatus();
 
-	size_t floorsAboveQueueSize = elevatorState.floorsAbovePriorityQueue.size();
-	size_t floorsBelowQueueSize = elevatorState.floorsBelowPriorityQueue.size();
+	size_t floorsAboveQueueSize = elevatorState.floorsAboveStopSet.size();
+	size_t floorsBelowQueueSize = elevatorState.floorsBelowStopSet.size();
 
 	//Both queues are empty, the elevator is waiting for a request
 	if (floorsAboveQueueSize == 0 && floorsBelowQueueSize == 0) {
@@ -86,32 +90,39 @@ Elevator::MovementStatus Elevator::ElevatorShaft::updateCurrentStatus() {
 	return changeDirection();
 }
 
-//Returns the next floor in the priority queues, based on which direction the elevator is moving
+//Returns the next floor in the stop sets, based on which direction the elevator is moving
 int Elevator::ElevatorShaft::getNextFloorInQueue() const {
 	if (getCurrentMovementStatus() == MovementStatus::MovingUp) {	
-		return numberOfFloors - elevatorState.floorsAbovePriorityQueue.top(); //When moving up, the priority is inverse of the floor number
+		return elevatorState.floorsAboveStopSet.lowest(); //When moving up, the closest floor above is next
 	}
 	if (getCurrentMovementStatus() == MovementStatus::MovingDown) {
-		return elevatorState.floorsBelowPriorityQueue.top();
+		return elevatorState.floorsBelowStopSet.highest();
 	}
 	return 0;
 }
 
 
-//Removes the next floor in the priority queues, if there is one to pop.
+//Removes the next floor in the stop sets, if there is one to remove.
 void Elevator::ElevatorShaft::removeNextFloorFromQueue() {
 	if (getCurrentMovementStatus() == MovementStatus::MovingUp) {
 
-		if (elevatorState.floorsAbovePriorityQueue.empty())
+		if (elevatorState.floorsAboveStopSet.empty())
 			return;
 
-		elevatorState.floorsAbovePriorityQueue.pop();
+		//The lowest floor is removed, so the highest only changes once the set is empty
+		elevatorState.floorsAboveStopSet.erase(elevatorState.floorsAboveStopSet.lowest());
+		if (elevatorState.floorsAboveStopSet.empty()) {
+			highestStopAbove = -1;
+		}
 	}
 	else if(getCurrentMovementStatus() == MovementStatus::MovingDown){
-		if (elevatorState.floorsBelowPriorityQueue.empty())
+		if (elevatorState.floorsBelowStopSet.empty())
 			return;
 
-		elevatorState.floorsBelowPriorityQueue.pop();
+		elevatorState.floorsBelowStopSet.erase(elevatorState.floorsBelowStopSet.highest());
+		if (elevatorState.floorsBelowStopSet.empty()) {
+			lowestStopBelow = -1;
+		}
 	}
 }
 
@@ -140,13 +151,27 @@ void Elevator::ElevatorShaft::moveElevator() {
 	}
 }
 
-//Assumes that the priority queue elements are unique
+//Moves the elevator floorCount floors in its direction at once, the same as calling moveElevator floorCount times.
+//Only valid while the elevator has no stop along the way, as nothing is serviced.
+void Elevator::ElevatorShaft::advanceFloors(int floorCount) {
+	MovementStatus currentStatus = getCurrentMovementStatus();
+	if (currentStatus == MovementStatus::MovingUp) {
+		elevatorState.currentPosition = clampFloor(elevatorState.currentPosition + floorCount);
+	}
+
+	if (currentStatus == MovementStatus::MovingDown) {
+		elevatorState.currentPosition = clampFloor(elevatorState.currentPosition - floorCount);
+	}
+}
+
+//The stop sets only hold each floor once, so a floor is only serviced once per visit
 //Returns true if the elevator serviced the floor at it's current position.
 bool Elevator::ElevatorShaft::gotoNextFloorInQueue() {
 	if (!enabled)
 		return false;
 
 	//Updates the MovementStatus state value
+	MovementStatus previousStatus = getCurrentMovementStatus();
 	updateCurrentStatus();
 
 	//If we are waiting, then we may have satisfied a call at the current floor.
@@ -157,9 +182,12 @@ bool Elevator::ElevatorShaft::gotoNextFloorInQueue() {
 	//We  are not waiting, where is the elevator off to next?
 	int nextFloor = getNextFloorInQueue();
 
+	//An elevator that was waiting here has its doors open, so it services the floor as it leaves.
+	//Otherwise a call made here, which it ignored as it was already at the floor, would never be met.
+	bool servicedFloor = previousStatus == MovementStatus::Waiting;
+
 	//Elevator was supposed to go to it's now current floor.
 	//This means it is responding to a request.
-	bool servicedFloor = false;
 	if (nextFloor == elevatorState.currentPosition) {
 		removeNextFloorFromQueue();
 		updateCurrentStatus(); //Recalculate the status as the queues have changed
@@ -171,38 +199,77 @@ bool Elevator::ElevatorShaft::gotoNextFloorInQueue() {
 	return servicedFloor;
 }
 
-//Takes a floor number, and add's it to the appropriate priority queue with an appropriate priority
+//Takes a floor number, and add's it to the stop set for the direction it is in
+//A floor that has already been requested is not added again
 void Elevator::ElevatorShaft::requestFloor(int floorNumber) {
 
-	//Ignore requests to the current floor
+	//Requests to the current floor are ignored if the elevator is waiting, or stopping here, as it services the floor on the next tick.
+	//Otherwise the elevator is passing the floor and has to come back for it, so it goes in the stop set behind the elevator.
 	if (floorNumber == elevatorState.currentPosition) {
+		MovementStatus currentStatus = getCurrentMovementStatus();
+		if (currentStatus == MovementStatus::MovingUp && getNextFloorInQueue() != floorNumber) {
+			insertStopBelow(floorNumber);
+		}
+		else if (currentStatus == MovementStatus::MovingDown && getNextFloorInQueue() != floorNumber) {
+			insertStopAbove(floorNumber);
+		}
 		return;
 	}
 
 	if (floorNumber > elevatorState.currentPosition) {
-		elevatorState.floorsAbovePriorityQueue.push(numberOfFloors - floorNumber); //Lower floors above should have a higher priority
+		insertStopAbove(floorNumber);
 	}
 
 	if (floorNumber < elevatorState.currentPosition) {
-		elevatorState.floorsBelowPriorityQueue.push(floorNumber);
+		insertStopBelow(floorNumber);
 	}
 }
 
-//Estimates the cost it would take the elevator to visit a given floor based on it's priority queues
-int Elevator::ElevatorShaft::costToVisitFloor(int floorNumber) {
-	if (floorNumber == elevatorState.currentPosition) {
+//Estimates the cost it would take the elevator to visit a given floor based on it's stop sets
+//The cost is the distance, plus the number of stops the elevator has between it's position and the floor
+int Elevator::ElevatorShaft::costToVisitFloor(int floorNumber) const {
+	int currentPosition = elevatorState.currentPosition;
+	if (floorNumber == currentPosition) {
 		return 0;
 	}
 
-	if (floorNumber > elevatorState.currentPosition) {
-		return floorNumber - elevatorState.currentPosition + elevatorState.floorsAbovePriorityQueue.size();
+	if (floorNumber > currentPosition) {
+		return floorNumber - currentPosition + static_cast<int>(elevatorState.floorsAboveStopSet.countInRange(currentPosition + 1, floorNumber - 1));
 	}
 
-	return elevatorState.currentPosition - floorNumber + elevatorState.floorsBelowPriorityQueue.size();
-
-	
+	return currentPosition - floorNumber + static_cast<int>(elevatorState.floorsBelowStopSet.countInRange(floorNumber + 1, currentPosition - 1));
 }
 
+//Replaces the whole state, e.g. from a checkpoint. Copies into the existing stop sets, so it does not allocate.
+bool Elevator::ElevatorShaft::restoreState(int currentPosition, MovementStatus movementStatus, bool _enabled, const uint64_t* floorsAboveWords, const uint64_t* floorsBelowWords) {
+	if (!canRestoreState(currentPosition, movementStatus, floorsAboveWords, floorsBelowWords)) {
+		return false;
+	}
+	elevatorState.currentPosition = currentPosition;
+	elevatorState.movementStatus = movementStatus;
+	elevatorState.floorsAboveStopSet.assignWords(floorsAboveWords);
+	elevatorState.floorsBelowStopSet.assignWords(floorsBelowWords);
+	highestStopAbove = elevatorState.floorsAboveStopSet.highest();
+	lowestStopBelow = elevatorState.floorsBelowStopSet.lowest();
+	enabled = _enabled;
+	return true;
+}
 
+//A state read from a file may be corrupt, and the position and stop sets are used as indexes.
+//Ticks keep the stops in the set above at or above the elevator, and those in the set below at or below it, and never leave a moving elevator
+//without a stop ahead of it. The event driven engine relies on that, so a state that breaks it is rejected too.
+bool Elevator::ElevatorShaft::canRestoreState(int currentPosition, MovementStatus movementStatus, const uint64_t* floorsAboveWords, const uint64_t* floorsBelowWords) const {
+	int statusValue = static_cast<int>(movementStatus);
+	if (currentPosition < 0 || currentPosition >= numberOfFloors
+		|| statusValue < static_cast<int>(MovementStatus::MovingUp) || statusValue > static_cast<int>(MovementStatus::Waiting)
+		|| !elevatorState.floorsAboveStopSet.areValidWords(floorsAboveWords) || !elevatorState.floorsBelowStopSet.areValidWords(floorsBelowWords)) {
+		return false;
+	}
 
-
+	int lowestStopAbove = findSetBitAtOrAbove(floorsAboveWords, elevatorState.floorsAboveStopSet.getWords().size(), 0);
+	int highestStopBelow = findSetBitAtOrBelow(floorsBelowWords, numberOfFloors - 1);
+	if ((lowestStopAbove >= 0 && lowestStopAbove < currentPosition) || highestStopBelow > currentPosition) {
+		return false;
+	}
+	return (movementStatus != MovementStatus::MovingUp || lowestStopAbove >= 0) && (movementStatus != MovementStatus::MovingDown || highestStopBelow >= 0);
+}
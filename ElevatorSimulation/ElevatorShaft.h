@@ -4,7 +4,6 @@
 #include <assert.h>
 #include <stdio.h>
 #include "Floor.h"
-#include <queue>
 #include <algorithm>
 
 
@@ -15,7 +14,8 @@ namespace Elevator {
 		public:
 			ElevatorShaft(int shaftNumber, int numberOfFloors);
 			const int shaftNumber;
-			ElevatorState getCurrentElevatorState() const;		//Returns the current state of the elevator (for display usage)
+			const ElevatorState& getCurrentElevatorState() const;	//Returns the current state of the elevator (for display usage)
+			int getCurrentPosition() const;						//Returns the floor the elevator is currently at
 			void setMovementStatus(MovementStatus status);		//Overrides the movement status of the elevator
 			void enable();										//Unused, enables and disables elevator input
 			void disable();
@@ -26,32 +26,133 @@ namespace Elevator {
 			MovementStatus getCurrentMovementStatus()const;		
 			bool hasFloorsInCurrentDirectionQueue()const;		//Returns true if there are more floors it needs to visit along its travelling direction
 			int getNextFloorInQueue() const;					//Returns the floor where the elevator is going to next
-			void removeNextFloorFromQueue();					//Removes the last floor from the priority queue
+			void removeNextFloorFromQueue();					//Removes the next floor from the stop sets
 			void moveElevator();								//Moves the elevator up or down one floor, depending on its movement status
-			void requestFloor(int floorNumber);					//Adds a floor to the priority queues
-			int costToVisitFloor(int floorNumber);				//Estimates the cost to visit a floor (as a measure of floors)
+			void advanceFloors(int floorCount);					//Moves the elevator floorCount floors at once, the same as calling moveElevator floorCount times
+			void requestFloor(int floorNumber);					//Adds a floor to the stop sets. Repeated requests for a floor are only stored once.
+			int costToVisitFloor(int floorNumber) const;		//Estimates the cost to visit a floor (as a measure of floors)
+			int etaToMeetCall(int floorNumber, MovementDirection direction) const;	//Floors travelled until the elevator meets a call, if the call were assigned to it now
+			bool isEnabled() const;
+			size_t getStopCount() const;						//How many floors are in both stop sets
+			int getHighestStopAbove() const;					//The end of the run up, or -1 if there is no stop above
+			int getLowestStopBelow() const;						//The end of the run down, or -1 if there is no stop below
+			//Replaces the whole state, e.g. from a checkpoint. The stop set words must be sized for this building.
+			//Returns false, leaving the state unchanged, if canRestoreState rejects it.
+			bool restoreState(int currentPosition, MovementStatus movementStatus, bool enabled, const uint64_t* floorsAboveWords, const uint64_t* floorsBelowWords);
+			//True if the position is in the building, the status is a MovementStatus, neither stop set has a floor past the top floor,
+			//each stop set only holds floors on its own side of the elevator, and a moving elevator has a stop ahead of it
+			bool canRestoreState(int currentPosition, MovementStatus movementStatus, const uint64_t* floorsAboveWords, const uint64_t* floorsBelowWords) const;
 
 		private:
 			ElevatorState elevatorState;
 			bool enabled;
 			int clampFloor(int floorNumber);
+			void insertStopAbove(int floorNumber);
+			void insertStopBelow(int floorNumber);
+
+			//The ends of the current run in each direction, where the elevator turns around: the highest floor in the above stop set and the lowest
+			//in the below stop set, or -1 if the set is empty. The ETA to every floor follows from these and the position, so they are the whole ETA table.
+			//They are updated as floors are requested and removed, and moving needs no update, as the ETAs are measured from the current position.
+			int highestStopAbove;
+			int lowestStopBelow;
 			const int numberOfFloors;
 
 	};
 
 	//Inline member functions
 
-	inline Elevator::ElevatorState Elevator::ElevatorShaft::getCurrentElevatorState() const {
+	inline const Elevator::ElevatorState& Elevator::ElevatorShaft::getCurrentElevatorState() const {
 		return elevatorState;
 	}
 
+	inline int Elevator::ElevatorShaft::getCurrentPosition() const {
+		return elevatorState.currentPosition;
+	}
+
 	inline void Elevator::ElevatorShaft::setMovementStatus(MovementStatus status) {
 		elevatorState.movementStatus = status;
 	}
 
+	inline bool Elevator::ElevatorShaft::isEnabled() const {
+		return enabled;
+	}
+
+	inline size_t Elevator::ElevatorShaft::getStopCount() const {
+		return elevatorState.floorsAboveStopSet.size() + elevatorState.floorsBelowStopSet.size();
+	}
+
+	inline int Elevator::ElevatorShaft::getHighestStopAbove() const {
+		return highestStopAbove;
+	}
+
+	inline int Elevator::ElevatorShaft::getLowestStopBelow() const {
+		return lowestStopBelow;
+	}
+
 	inline MovementStatus Elevator::ElevatorShaft::getCurrentMovementStatus() const{
 		return elevatorState.movementStatus;
 	}
 
+	inline void Elevator::ElevatorShaft::insertStopAbove(int floorNumber) {
+		elevatorState.floorsAboveStopSet.insert(floorNumber);
+		highestStopAbove = std::max(highestStopAbove, floorNumber);
+	}
+
+	inline void Elevator::ElevatorShaft::insertStopBelow(int floorNumber) {
+		elevatorState.floorsBelowStopSet.insert(floorNumber);
+		lowestStopBelow = lowestStopBelow < 0 ? floorNumber : std::min(lowestStopBelow, floorNumber);
+	}
+
+	//A call is met when the elevator services the floor and leaves in the call's direction, stays there waiting, or turns around there, as it is the end of
+	//the run in the call's direction. Servicing a floor takes no extra ticks, so the ETA is the floors travelled: to the end of the current run, then back.
+	//The stop sets are taken as they would be once the call's floor was requested, with no later inputs. A lookup, with no scan of the stop sets.
+	inline int Elevator::ElevatorShaft::etaToMeetCall(int floorNumber, MovementDirection direction) const {
+		assert(highestStopAbove == elevatorState.floorsAboveStopSet.highest() && lowestStopBelow == elevatorState.floorsBelowStopSet.lowest());
+		int position = elevatorState.currentPosition;
+		int distance = floorNumber > position ? floorNumber - position : position - floorNumber;
+		MovementStatus movementStatus = elevatorState.movementStatus;
+
+		//Add the floor to the run ends, as requestFloor would
+		bool stopAboveHere = elevatorState.floorsAboveStopSet.contains(position);
+		bool stopBelowHere = elevatorState.floorsBelowStopSet.contains(position);
+		int highestStop = highestStopAbove;
+		int lowestStop = lowestStopBelow;
+		if (floorNumber > position || (floorNumber == position && movementStatus == MovementStatus::MovingDown && !stopBelowHere)) {
+			highestStop = std::max(highestStop, floorNumber);
+			stopAboveHere = stopAboveHere || floorNumber == position;
+		}
+		else if (floorNumber < position || (floorNumber == position && movementStatus == MovementStatus::MovingUp && !stopAboveHere)) {
+			lowestStop = lowestStop < 0 ? floorNumber : std::min(lowestStop, floorNumber);
+			stopBelowHere = stopBelowHere || floorNumber == position;
+		}
+
+		if (highestStop < 0 && lowestStop < 0) {
+			return distance;		//Waiting on the floor, or disabled
+		}
+
+		//The direction it leaves in, chosen as updateCurrentStatus does, and whether the floor is still ahead of it.
+		//A floor it is on is ahead if it was waiting there, or is stopping there, as it services the floor as it leaves.
+		bool waiting = movementStatus == MovementStatus::Waiting;
+		bool goingUp = movementStatus == MovementStatus::MovingDown ? lowestStop < 0 : highestStop >= 0;
+		if (goingUp) {
+			bool ahead = floorNumber > position || (floorNumber == position && (waiting || stopAboveHere));
+			if (direction == MovementDirection::Up && ahead) {
+				return distance;
+			}
+			if (direction == MovementDirection::Down) {
+				return (highestStop - position) + (highestStop - floorNumber);
+			}
+			return (highestStop - position) + (highestStop - lowestStop) + (floorNumber - lowestStop);
+		}
+
+		bool ahead = floorNumber < position || (floorNumber == position && (waiting || stopBelowHere));
+		if (direction == MovementDirection::Down && ahead) {
+			return distance;
+		}
+		if (direction == MovementDirection::Up) {
+			return (position - lowestStop) + (floorNumber - lowestStop);
+		}
+		return (position - lowestStop) + (highestStop - lowestStop) + (highestStop - floorNumber);
+	}
 }
 
@@ -9,21 +9,371 @@
 #include <iostream>
 #include <thread>
 #include "SimulationInput.h"
+#include "BatchSimulation.h"
+#include "FleetBenchmark.h"
+#include "ParallelTickBenchmark.h"
+#include "SweepRunner.h"
+#include "TrafficSimulation.h"
+#include "EventLog.h"
+#include "EventLogReplay.h"
+#include "AsyncRenderer.h"
+#include "TickPacer.h"
+#include "ScriptSimulation.h"
+#include "ControlServer.h"
 
 
 #define ARG_COUNT 3
+#define BATCH_ARG_COUNT 6
+#define BATCH_MODE_ARG "--batch"
+#define EVENT_BATCH_MODE_ARG "--event-batch"
+#define FLEET_BENCHMARK_ARG_COUNT 5
+#define FLEET_BENCHMARK_MODE_ARG "--fleet-benchmark"
+#define TICK_SCALING_ARG_COUNT 6
+#define TICK_SCALING_MODE_ARG "--tick-scaling"
+#define SCRIPT_ARG_COUNT 5
+#define SCRIPT_MODE_ARG "--script"
+#define SERVE_ARG_COUNT 5
+#define SERVE_MODE_ARG "--serve"
+#define TRAFFIC_ARG_COUNT 7
+#define TRAFFIC_MODE_ARG "--traffic"
+#define SWEEP_ARG_COUNT 11
+#define SWEEP_MODE_ARG "--sweep"
+#define REPLAY_ARG_COUNT 4
+#define REPLAY_MODE_ARG "--replay"
+#define RECORD_ARG "--record"
+#define DISPATCH_ARG "--dispatch"
+#define LIVE_ARG "--live"
+#define LIVE_FRAMES_PER_SECOND 30
+#define SPEED_ARG "--speed"
+#define TRAFFIC_TICK_INTERVAL std::chrono::seconds(1)	//A traffic tick at a speed of 1 takes as long as an interactive one
 #define MINIMUM_FLOORS 2
 #define MINIMUM_SHAFTS 1
 
 
 void printUsageError() {
 	std::cerr << "Usage: ElevatorSimulation [NumberOfFloors] [Number of Shafts]" <<std::endl;
+	std::cerr << "       ElevatorSimulation [NumberOfFloors] [Number of Shafts] " << BATCH_MODE_ARG << " [ScenarioFile] [Number of Ticks]" << std::endl;
+	std::cerr << "       ElevatorSimulation [NumberOfFloors] [Number of Shafts] " << EVENT_BATCH_MODE_ARG << " [ScenarioFile] [Number of Ticks]" << std::endl;
+	std::cerr << "       ElevatorSimulation [NumberOfFloors] [Number of Shafts] " << FLEET_BENCHMARK_MODE_ARG << " [Number of Ticks]" << std::endl;
+	std::cerr << "       ElevatorSimulation [NumberOfFloors] [Number of Shafts] " << TICK_SCALING_MODE_ARG << " [Number of Ticks] [Maximum Threads]" << std::endl;
+	std::cerr << "       ElevatorSimulation [NumberOfFloors] [Number of Shafts] " << SCRIPT_MODE_ARG << " [ScriptFile]" << std::endl;
+	std::cerr << "       ElevatorSimulation [NumberOfFloors] [Number of Shafts] " << SERVE_MODE_ARG << " [SocketPath]" << std::endl;
+	std::cerr << "       ElevatorSimulation [NumberOfFloors] [Number of Shafts] " << TRAFFIC_MODE_ARG << " [UpPeak|Lunch|DownPeak|InterFloor|Day] [Seed] [Number of Ticks]" << std::endl;
+	std::cerr << "       ElevatorSimulation " << REPLAY_MODE_ARG << " [LogFile] [Number of Ticks, optional]" << std::endl;
+	std::cerr << "       ElevatorSimulation " << SWEEP_MODE_ARG << " [Min Floors] [Max Floors] [Floor Step] [Min Shafts] [Max Shafts] [Shaft Step] [Number of Seeds] [Number of Ticks] [Threads, 0 for all cores]" << std::endl;
+	std::cerr << "Interactive, batch, script, serve and traffic runs can add " << RECORD_ARG << " [LogFile] to log its inputs for replay." << std::endl;
+	std::cerr << "Any run except a replay can add " << DISPATCH_ARG << " [Stops|NearestCar|Collective|LeastLoaded|Destination] before " << RECORD_ARG << " to choose how calls are assigned." << std::endl;
+	std::cerr << "Traffic runs can add " << LIVE_ARG << " before " << DISPATCH_ARG << " and " << RECORD_ARG << " to watch the run, drawn on its own thread." << std::endl;
+	std::cerr << "Traffic and serve runs can add " << SPEED_ARG << " [" << Elevator::TickPacer::MINIMUM_SPEED << " to " << Elevator::TickPacer::MAXIMUM_SPEED
+		<< "] before " << LIVE_ARG << " to run in real time, at that many ticks per second." << std::endl;
+}
+
+//Parses a number of ticks argument. Prints an error and returns false if it is not valid.
+bool parseTickCount(const std::string& tickCountString, size_t& numberOfTicks) {
+	long long parsedTicks;
+	try {
+		parsedTicks = std::stoll(tickCountString);
+	}
+	catch (std::exception const& exception) {
+		std::cerr << "Unable to parse the number of ticks. ";
+		printUsageError();
+		return false;
+	}
+
+	if (parsedTicks < 0) {
+		std::cerr << "The number of ticks must not be negative. ";
+		printUsageError();
+		return false;
+	}
+
+	numberOfTicks = static_cast<size_t>(parsedTicks);
+	return true;
+}
+
+//Runs a scenario headless and prints the results. Returns the exit code.
+//The event driven engine gives the same results, but skips the ticks where nothing happens.
+int runBatchSimulation(Elevator::ElevatorController& controller, const std::string& scenarioPath, const std::string& tickCountString, bool eventDriven) {
+	size_t numberOfTicks;
+	if (!parseTickCount(tickCountString, numberOfTicks)) {
+		return -1;
+	}
+
+	BatchSimulation batchSimulation(&controller);
+	if (!batchSimulation.loadScenario(scenarioPath)) {
+		return -1;
+	}
+
+	if (eventDriven) {
+		batchSimulation.runEventDriven(numberOfTicks);
+	}
+	else {
+		batchSimulation.run(numberOfTicks);
+	}
+	batchSimulation.printSummary(std::cout);
+	return 0;
+}
+
+//Checks a script of interactive commands, then runs it headless and prints the results. Returns the exit code.
+//Nothing is run if any line of the script is malformed.
+int runScriptSimulation(Elevator::ElevatorController& controller, const std::string& scriptPath) {
+	ScriptSimulation scriptSimulation(&controller);
+	if (!scriptSimulation.loadScript(scriptPath) || !scriptSimulation.checkScript()) {
+		return -1;
+	}
+
+	scriptSimulation.run();
+	scriptSimulation.printSummary(std::cout);
+	return 0;
+}
+
+//Serves clients on a Unix domain socket until one of them asks it to stop, then prints the results. Returns the exit code.
+//A paced server ticks in real time, as well as running the ticks the clients ask for.
+int runControlServer(Elevator::ElevatorController& controller, const std::string& socketPath, double speedMultiplier) {
+	Elevator::TickPacer tickPacer(TRAFFIC_TICK_INTERVAL);
+	Elevator::TickPacer* tickPacerPtr = nullptr;
+	if (speedMultiplier > 0) {
+		tickPacer.setSpeed(speedMultiplier);
+		tickPacerPtr = &tickPacer;
+	}
+
+	ControlServer controlServer(&controller);
+	if (!controlServer.listen(socketPath)) {
+		return -1;
+	}
+	std::cout << "Listening on " << socketPath << std::endl;
+
+	controlServer.run(tickPacerPtr);
+	controlServer.printSummary(std::cout);
+	return 0;
+}
+
+//Runs generated passenger traffic and prints the results. Returns the exit code.
+//A live run is drawn by a render thread at a capped frame rate, so the simulation still runs as fast as it can.
+//A paced run holds each tick until it is due, and reports how far it fell behind.
+int runTrafficSimulation(Elevator::ElevatorController& controller, const std::string& profileName, const std::string& seedString, const std::string& tickCountString,
+	bool liveMode, double speedMultiplier) {
+	size_t numberOfTicks;
+	if (!parseTickCount(tickCountString, numberOfTicks)) {
+		return -1;
+	}
+
+	Elevator::TrafficProfile trafficProfile;
+	if (!Elevator::TrafficGenerator::profileFromName(profileName, trafficProfile)) {
+		std::cerr << "Unknown traffic profile: " << profileName << ". ";
+		printUsageError();
+		return -1;
+	}
+
+	unsigned long long seed;
+	try {
+		seed = std::stoull(seedString);
+	}
+	catch (std::exception const& exception) {
+		std::cerr << "Unable to parse the seed. ";
+		printUsageError();
+		return -1;
+	}
+
+	Elevator::TickPacer tickPacer(TRAFFIC_TICK_INTERVAL);
+	Elevator::TickPacer* tickPacerPtr = nullptr;
+	if (speedMultiplier > 0) {
+		tickPacer.setSpeed(speedMultiplier);
+		tickPacerPtr = &tickPacer;
+	}
+
+	TrafficSimulation trafficSimulation(&controller, trafficProfile, seed);
+	AsyncRenderer asyncRenderer(controller.simulationStateDisplay, LIVE_FRAMES_PER_SECOND);
+	if (liveMode) {
+		asyncRenderer.start(controller.getCurrentState());
+		controller.addEventListener(&asyncRenderer);
+	}
+	trafficSimulation.run(numberOfTicks, tickPacerPtr);
+	if (liveMode) {
+		controller.removeEventListener(&asyncRenderer);
+		asyncRenderer.stop(controller.getCurrentState(), controller.getCurrentTick());
+	}
+
+	trafficSimulation.printSummary(std::cout);
+	if (liveMode) {
+		std::cout << "Frames drawn: " << asyncRenderer.getFramesDrawn() << ", snapshots dropped: " << asyncRenderer.getSnapshotsDropped()
+			<< ", ticks not captured: " << asyncRenderer.getBatchesSkipped() << std::endl;
+	}
+	if (tickPacerPtr) {
+		std::cout << "Speed: " << tickPacer.getSpeed() << "x, overruns: " << tickPacer.getOverrunCount() << ", deadlines skipped: " << tickPacer.getSkippedDeadlineCount()
+			<< ", maximum lag: " << std::chrono::duration_cast<std::chrono::milliseconds>(tickPacer.getMaximumLag()).count() << "ms" << std::endl;
+	}
+	return 0;
+}
+
+//Compares the struct of arrays fleet against the controller, and prints the ticks per second of both. Returns the exit code.
+int runFleetBenchmark(Elevator::SimulationSettings simulationSettings, const std::string& tickCountString) {
+	size_t numberOfTicks;
+	if (!parseTickCount(tickCountString, numberOfTicks)) {
+		return -1;
+	}
+
+	FleetBenchmark fleetBenchmark(simulationSettings);
+	fleetBenchmark.run(numberOfTicks);
+	fleetBenchmark.printSummary(std::cout);
+	return 0;
+}
+
+//Runs the parallel tick from one thread up to maximumThreadString threads, and prints how it scales. Returns the exit code.
+int runTickScalingBenchmark(Elevator::SimulationSettings simulationSettings, const std::string& tickCountString, const std::string& maximumThreadString) {
+	size_t numberOfTicks;
+	if (!parseTickCount(tickCountString, numberOfTicks)) {
+		return -1;
+	}
+
+	int maximumThreadCount;
+	try {
+		maximumThreadCount = std::stoi(maximumThreadString);
+	}
+	catch (std::exception const& exception) {
+		maximumThreadCount = 0;
+	}
+	if (maximumThreadCount < 1) {
+		std::cerr << "The maximum number of threads must be at least 1. ";
+		printUsageError();
+		return -1;
+	}
+
+	ParallelTickBenchmark parallelTickBenchmark(simulationSettings);
+	parallelTickBenchmark.run(numberOfTicks, static_cast<size_t>(maximumThreadCount));
+	parallelTickBenchmark.printSummary(std::cout);
+	return 0;
+}
+
+//Parses the arguments of a sweep, which replace the usual floor and shaft counts, and runs it. Returns the exit code.
+int runSweep(char** argv, Elevator::DispatchPolicyType dispatchPolicy) {
+	int sweepArguments[SWEEP_ARG_COUNT - 2];
+	try {
+		for (int i = 0; i < SWEEP_ARG_COUNT - 2; i++) {
+			sweepArguments[i] = std::stoi(argv[i + 2]);
+		}
+	}
+	catch (std::exception const& exception) {
+		std::cerr << "Unable to parse string to integer value. ";
+		printUsageError();
+		return -1;
+	}
+
+	Elevator::SweepRange floorRange = { sweepArguments[0], sweepArguments[1], sweepArguments[2] };
+	Elevator::SweepRange shaftRange = { sweepArguments[3], sweepArguments[4], sweepArguments[5] };
+	int seedCount = sweepArguments[6];
+	int numberOfTicks = sweepArguments[7];
+	int threadCount = sweepArguments[8];
+
+	//Verify that the ranges are correct
+	if (floorRange.minimum < MINIMUM_FLOORS || shaftRange.minimum < MINIMUM_SHAFTS) {
+		std::cerr << "The sweep must have at least 2 floors and 1 elevator shaft. ";
+		printUsageError();
+		return -1;
+	}
+
+	if (floorRange.maximum < floorRange.minimum || shaftRange.maximum < shaftRange.minimum || floorRange.step < 1 || shaftRange.step < 1) {
+		std::cerr << "Each range maximum must be at least its minimum, with a step of at least 1. ";
+		printUsageError();
+		return -1;
+	}
+
+	if (seedCount < 1 || numberOfTicks < 0 || threadCount < 0) {
+		std::cerr << "The sweep needs at least 1 seed, and must not have a negative number of ticks or threads. ";
+		printUsageError();
+		return -1;
+	}
+
+	Elevator::SweepRunner sweepRunner(floorRange, shaftRange, static_cast<size_t>(seedCount), static_cast<size_t>(numberOfTicks), dispatchPolicy);
+	sweepRunner.run(static_cast<size_t>(threadCount));
+	sweepRunner.printResults(std::cout);
+	sweepRunner.printTiming(std::cerr);
+	return 0;
+}
+
+//Replays a recorded event log headless, up to a tick or the end of the log, and prints the results. Returns the exit code.
+int runReplay(const std::string& logPath, const std::string& tickCountString) {
+	Elevator::EventLogReader eventLogReader;
+	if (!eventLogReader.open(logPath)) {
+		return -1;
+	}
+
+	size_t numberOfTicks = eventLogReader.getEndTick();
+	if (!tickCountString.empty() && !parseTickCount(tickCountString, numberOfTicks)) {
+		return -1;
+	}
+
+	//Seeking starts from the nearest checkpoint stored beside the log, rather than replaying from the first tick
+	Elevator::ElevatorController controller(eventLogReader.getSimulationSettings());
+	EventLogReplay eventLogReplay(&controller, &eventLogReader);
+	eventLogReplay.seekTo(numberOfTicks);
+	eventLogReplay.printSummary(std::cout);
+	return 0;
 }
 
 int main(int argc, char** argv)
 {
+	//Recording can be added to the end of any mode's arguments
+	std::string eventLogPath;
+	if (argc > 2 && std::string(argv[argc - 2]) == RECORD_ARG) {
+		eventLogPath = argv[argc - 1];
+		argc -= 2;
+	}
+
+	//As can the dispatch policy. A replay always uses the policy it was recorded with.
+	Elevator::DispatchPolicyType dispatchPolicy = Elevator::DispatchPolicyType::Collective;
+	if (argc > 2 && std::string(argv[argc - 2]) == DISPATCH_ARG) {
+		if (!Elevator::dispatchPolicyFromName(argv[argc - 1], dispatchPolicy)) {
+			std::cerr << "Unknown dispatch policy: " << argv[argc - 1] << ". ";
+			printUsageError();
+			exit(-1);
+		}
+		argc -= 2;
+	}
+
+	//Only traffic runs use the live view
+	bool liveMode = false;
+	if (argc > 1 && std::string(argv[argc - 1]) == LIVE_ARG) {
+		liveMode = true;
+		argc -= 1;
+	}
+
+	//Traffic and serve runs can use real time pacing
+	double speedMultiplier = 0;
+	if (argc > 2 && std::string(argv[argc - 2]) == SPEED_ARG) {
+		try {
+			speedMultiplier = std::stod(argv[argc - 1]);
+		}
+		catch (std::exception const& exception) {
+			speedMultiplier = -1;
+		}
+		if (speedMultiplier < Elevator::TickPacer::MINIMUM_SPEED || speedMultiplier > Elevator::TickPacer::MAXIMUM_SPEED) {
+			std::cerr << "The speed must be between " << Elevator::TickPacer::MINIMUM_SPEED << " and " << Elevator::TickPacer::MAXIMUM_SPEED << ". ";
+			printUsageError();
+			exit(-1);
+		}
+		argc -= 2;
+	}
+
+	//A replay takes the building from the log
+	if ((argc == REPLAY_ARG_COUNT || argc == REPLAY_ARG_COUNT - 1) && std::string(argv[1]) == REPLAY_MODE_ARG && !liveMode && speedMultiplier == 0) {
+		return runReplay(argv[2], argc == REPLAY_ARG_COUNT ? argv[3] : "");
+	}
+
+	//A sweep covers many building configurations, so it does not take a single floor and shaft count
+	if (argc == SWEEP_ARG_COUNT && std::string(argv[1]) == SWEEP_MODE_ARG && !liveMode && speedMultiplier == 0) {
+		return runSweep(argv, dispatchPolicy);
+	}
+
 	//Check that enough arguments were supplied
-	if (argc != ARG_COUNT) {
+	std::string mode = argc > ARG_COUNT ? argv[3] : "";
+	bool batchMode = argc == BATCH_ARG_COUNT && (mode == BATCH_MODE_ARG || mode == EVENT_BATCH_MODE_ARG);
+	bool fleetBenchmarkMode = argc == FLEET_BENCHMARK_ARG_COUNT && mode == FLEET_BENCHMARK_MODE_ARG;
+	bool tickScalingMode = argc == TICK_SCALING_ARG_COUNT && mode == TICK_SCALING_MODE_ARG;
+	bool scriptMode = argc == SCRIPT_ARG_COUNT && mode == SCRIPT_MODE_ARG;
+	bool serveMode = argc == SERVE_ARG_COUNT && mode == SERVE_MODE_ARG;
+	bool trafficMode = argc == TRAFFIC_ARG_COUNT && mode == TRAFFIC_MODE_ARG;
+	if ((argc != ARG_COUNT && !batchMode && !fleetBenchmarkMode && !tickScalingMode && !scriptMode && !serveMode && !trafficMode)
+		|| (liveMode && !trafficMode) || (speedMultiplier > 0 && !trafficMode && !serveMode)) {
 		printUsageError();
 		exit(-1);
 	}
@@ -57,18 +407,55 @@ int main(int argc, char** argv)
 	Elevator::SimulationSettings simulationSettings;
 	simulationSettings.numberOfFloors = numberOfFloors;
 	simulationSettings.numberOfShafts = numberOfShafts;
+	simulationSettings.dispatchPolicy = dispatchPolicy;
+
+	//The benchmark creates its own controller and fleet
+	if (fleetBenchmarkMode) {
+		return runFleetBenchmark(simulationSettings, argv[4]);
+	}
+
+	if (tickScalingMode) {
+		return runTickScalingBenchmark(simulationSettings, argv[4], argv[5]);
+	}
 
 	//Create the controller 
 	Elevator::ElevatorController controller(simulationSettings);
 
-	//Create the simulation input handler
-	SimulationInput simulationInput(&controller);
+	Elevator::EventLogWriter eventLogWriter;
+	if (!eventLogPath.empty()) {
+		if (!eventLogWriter.open(eventLogPath, simulationSettings)) {
+			exit(-1);
+		}
+		controller.setEventLogWriter(&eventLogWriter);
+	}
 
-	//Display the default state. This allows the display to be refreshed properly
-	controller.simulationStateDisplay.displayState(controller.getCurrentState());
-	
-	//Enter the main input loop
-	simulationInput.enterInputLoop();
-	return 0;
+	//Batch runs skip the display and input handler completely
+	int exitCode = 0;
+	if (batchMode) {
+		exitCode = runBatchSimulation(controller, argv[4], argv[5], mode == EVENT_BATCH_MODE_ARG);
+	}
+	else if (scriptMode) {
+		exitCode = runScriptSimulation(controller, argv[4]);
+	}
+	else if (serveMode) {
+		exitCode = runControlServer(controller, argv[4], speedMultiplier);
+	}
+	else if (trafficMode) {
+		exitCode = runTrafficSimulation(controller, argv[4], argv[5], argv[6], liveMode, speedMultiplier);
+	}
+	else {
+		//Create the simulation input handler
+		SimulationInput simulationInput(&controller);
+
+		//Display the default state. This allows the display to be refreshed properly
+		controller.simulationStateDisplay.displayState(controller.getCurrentState());
+
+		//Enter the main input loop
+		simulationInput.enterInputLoop();
+	}
+
+	//Record when the session ended, so a replay simulates the same number of ticks
+	eventLogWriter.close(controller.getCurrentTick());
+	return exitCode;
 }
 
@@ -1,23 +1,50 @@
 #pragma once
-#include <queue>
+#include <cstddef>
+#include <atomic>
+#include "FloorStopSet.h"
 
 namespace Elevator {
 
 	//Defines common enums and types for use across the simulation
 	enum class MovementStatus {MovingUp = 0, MovingDown = 1, Disabled, Waiting};
 	enum class MovementDirection {Up = 0, Down = 1};
+	enum class DispatchPolicyType {Stops = 0, NearestCar = 1, Collective = 2, LeastLoaded = 3, Destination = 4};	//How hall calls are assigned to shafts, see DispatchPolicies.h
+
+	//True if a shaft that was moving in arrivalStatus leaves a floor moving the other way, so the floor is the end of its run
+	inline bool isTurnAround(MovementStatus arrivalStatus, MovementStatus leavingStatus) {
+		return (arrivalStatus == MovementStatus::MovingUp && leavingStatus == MovementStatus::MovingDown)
+			|| (arrivalStatus == MovementStatus::MovingDown && leavingStatus == MovementStatus::MovingUp);
+	}
+
+	//Counts how many times the state structures have been copied, on any thread, so copies made by the tick workers are seen too.
+	//Ticks and display refreshes should not copy the state, this makes that checkable. Moves are not counted.
+	//The moves are noexcept, so growing a vector of shafts moves them rather than copying.
+	struct StateCopyCounter {
+		StateCopyCounter() {}
+		StateCopyCounter(const StateCopyCounter&) { copyCount.fetch_add(1, std::memory_order_relaxed); }
+		StateCopyCounter(StateCopyCounter&&) noexcept {}
+		StateCopyCounter& operator=(const StateCopyCounter&) { copyCount.fetch_add(1, std::memory_order_relaxed); return *this; }
+		StateCopyCounter& operator=(StateCopyCounter&&) noexcept { return *this; }
+
+		static size_t getCopyCount() { return copyCount.load(std::memory_order_relaxed); }
+
+		private:
+			static std::atomic<size_t> copyCount;
+	};
 
 	struct ElevatorState {
 		MovementStatus movementStatus; //Is the elevator moving? If so, what direction. 
-		std::priority_queue<int> floorsAbovePriorityQueue;  //When moving up, which floor is next?
-		std::priority_queue<int> floorsBelowPriorityQueue;
+		FloorStopSet floorsAboveStopSet;  //When moving up, the lowest floor is next
+		FloorStopSet floorsBelowStopSet;  //When moving down, the highest floor is next
 		int currentPosition;
+		StateCopyCounter copyCounter;
 	};
 
 	class SimulationSettings {
 		public:
 			int numberOfFloors;
 			int numberOfShafts;
+			DispatchPolicyType dispatchPolicy = DispatchPolicyType::Collective;
 	};
 
 
@@ -0,0 +1,140 @@
+#include "stdafx.h"
+#include "EventDrivenSimulation.h"
+#include <algorithm>
+#include <functional>
+
+//Starts from the controller's current tick. The first tick is always a full tick, as the events have not been calculated yet.
+Elevator::EventDrivenSimulation::EventDrivenSimulation(ElevatorController* elevatorControllerPtr) :
+	elevatorControllerPtr(elevatorControllerPtr),
+	synchronizedTicks(elevatorControllerPtr->getCurrentState().elevatorShaftVector.size(), elevatorControllerPtr->getCurrentTick()),
+	currentTick(elevatorControllerPtr->getCurrentTick()),
+	eventCount(0),
+	fullTickNeeded(true)
+{
+}
+
+//Forgets every event, and starts again from the controller's current tick with a full tick
+void Elevator::EventDrivenSimulation::reset() {
+	eventQueue.clear();
+	currentTick = elevatorControllerPtr->getCurrentTick();
+	synchronizedTicks.assign(synchronizedTicks.size(), currentTick);
+	fullTickNeeded = true;
+}
+
+//Simulates up to the given tick, by jumping from event to event.
+//Every shaft is brought up to date with the tick before returning, so the state can be observed or changed.
+void Elevator::EventDrivenSimulation::advanceTo(size_t tick) {
+	if (currentTick < tick && fullTickNeeded) {
+		fullTick();
+	}
+
+	//Events are processed in tick order, with every event due on a tick taken at once.
+	//As in simulationTick, every due shaft stops for a call ahead of it before any shaft clears the calls it meets.
+	while (!eventQueue.empty() && eventQueue.front().first < tick) {
+		size_t eventTick = eventQueue.front().first;
+		dueShafts.clear();
+		while (!eventQueue.empty() && eventQueue.front().first == eventTick) {
+			dueShafts.push_back(eventQueue.front().second);
+			std::pop_heap(eventQueue.begin(), eventQueue.end(), std::greater<ShaftEvent>());
+			eventQueue.pop_back();
+		}
+
+		for (size_t i = 0; i < dueShafts.size(); i++) {
+			synchronizeShaft(dueShafts[i], eventTick);
+			elevatorControllerPtr->pickUpHallCallAhead(dueShafts[i]);
+		}
+		for (size_t i = 0; i < dueShafts.size(); i++) {
+			processEvent(std::make_pair(eventTick, dueShafts[i]));
+		}
+	}
+
+	if (currentTick < tick) {
+		currentTick = tick;
+	}
+
+	for (size_t i = 0; i < synchronizedTicks.size(); i++) {
+		synchronizeShaft(i, currentTick);
+	}
+	elevatorControllerPtr->setCurrentTick(currentTick);
+	elevatorControllerPtr->publishEvents();
+}
+
+//Simulates one tick for every shaft. This is needed after an input, as a waiting shaft may now service a call on its floor,
+//and every shaft's status is recalculated from its stop sets.
+void Elevator::EventDrivenSimulation::fullTick() {
+	for (size_t i = 0; i < synchronizedTicks.size(); i++) {
+		synchronizeShaft(i, currentTick);
+	}
+
+	elevatorControllerPtr->setCurrentTick(currentTick);
+	elevatorControllerPtr->simulationTick();
+	currentTick++;
+	eventCount += synchronizedTicks.size();
+	fullTickNeeded = false;
+
+	eventQueue.clear();
+	for (size_t i = 0; i < synchronizedTicks.size(); i++) {
+		synchronizedTicks[i] = currentTick;
+		scheduleShaft(i);
+	}
+}
+
+//Moves the shaft to the floor of its next stop, then simulates the tick on which it arrives
+void Elevator::EventDrivenSimulation::processEvent(const ShaftEvent& shaftEvent) {
+	size_t shaft = shaftEvent.second;
+	synchronizeShaft(shaft, shaftEvent.first);
+	elevatorControllerPtr->tickShaft(shaft, shaftEvent.first);
+	synchronizedTicks[shaft] = shaftEvent.first + 1;
+	eventCount++;
+	scheduleShaft(shaft);
+}
+
+//Moves a shaft for the ticks since it was last up to date.
+//No event is due before the tick, so the shaft has not reached a stop and can move all of the floors at once.
+void Elevator::EventDrivenSimulation::synchronizeShaft(size_t shaft, size_t tick) {
+	if (synchronizedTicks[shaft] >= tick) {
+		return;
+	}
+
+	elevatorControllerPtr->advanceShaft(shaft, static_cast<int>(tick - synchronizedTicks[shaft]));
+	synchronizedTicks[shaft] = tick;
+}
+
+//Adds an event for the tick on which a moving shaft reaches its next stop.
+//A moving shaft with a call ahead of it is ticked straight away instead, so it stops for the call. The calls ahead of a shaft only
+//change on inputs, which are followed by a full tick, and when it ticks, so otherwise nothing new appears before its next stop.
+//Waiting shafts have no events, as they do nothing until there is an input.
+//The exception is a shaft that went idle at a stop, where passengers boarded and requested floors. Its status is only recalculated
+//when it next ticks, on which it services the floor again as it leaves, so it is ticked straight away.
+void Elevator::EventDrivenSimulation::scheduleShaft(size_t shaft) {
+	const ElevatorShaft& elevatorShaft = elevatorControllerPtr->getCurrentState().elevatorShaftVector[shaft];
+	MovementStatus movementStatus = elevatorShaft.getCurrentMovementStatus();
+	if (movementStatus != MovementStatus::MovingUp && movementStatus != MovementStatus::MovingDown) {
+		const ElevatorState& elevatorState = elevatorShaft.getCurrentElevatorState();
+		if (movementStatus == MovementStatus::Waiting && (!elevatorState.floorsAboveStopSet.empty() || !elevatorState.floorsBelowStopSet.empty())) {
+			eventQueue.push_back(std::make_pair(synchronizedTicks[shaft], shaft));
+			std::push_heap(eventQueue.begin(), eventQueue.end(), std::greater<ShaftEvent>());
+		}
+		return;
+	}
+
+	if (elevatorControllerPtr->hasHallCallAhead(shaft)) {
+		eventQueue.push_back(std::make_pair(synchronizedTicks[shaft], shaft));
+		std::push_heap(eventQueue.begin(), eventQueue.end(), std::greater<ShaftEvent>());
+		return;
+	}
+
+	int floorsToNextStop = elevatorShaft.getNextFloorInQueue() - elevatorShaft.getCurrentPosition();
+	if (movementStatus == MovementStatus::MovingDown) {
+		floorsToNextStop = -floorsToNextStop;
+	}
+
+	//The next stop is always ahead of a moving shaft. If it is not, tick the shaft straight away rather than moving it past the stop.
+	assert(floorsToNextStop >= 0);
+	if (floorsToNextStop < 0) {
+		floorsToNextStop = 0;
+	}
+
+	eventQueue.push_back(std::make_pair(synchronizedTicks[shaft] + floorsToNextStop, shaft));
+	std::push_heap(eventQueue.begin(), eventQueue.end(), std::greater<ShaftEvent>());
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include "ElevatorController.h"
+
+namespace Elevator {
+
+	//Advances the simulation from event to event, instead of one tick at a time.
+	//Between inputs, a moving shaft does nothing but move one floor per tick until it reaches its next stop, and a waiting shaft does nothing at all.
+	//So each moving shaft only needs to be ticked when it arrives at getNextFloorInQueue(), or to stop for a call on its way,
+	//and is otherwise moved lazily with advanceShaft.
+	//The shafts are all brought up to date whenever the state is observed, giving the same state as calling simulationTick once per tick.
+	//Inputs (calls and floor requests) must be followed by stateChanged(), as they change the shafts' next stops.
+	class EventDrivenSimulation {
+		public:
+			EventDrivenSimulation(ElevatorController* elevatorControllerPtr);
+
+			void advanceTo(size_t tick);				//Simulates up to the given tick. Every shaft is up to date afterwards, so inputs can be applied.
+			void stateChanged();						//Must be called after an input, so the next tick is fully simulated and the events are recalculated
+			void reset();								//Starts again from the controller's current tick, e.g. after it restored a checkpoint
+			size_t getCurrentTick() const;				//Number of ticks simulated so far
+			size_t getEventCount() const;				//Number of shaft ticks actually simulated, including full ticks after inputs
+
+		private:
+			typedef std::pair<size_t, size_t> ShaftEvent;	//The tick on which a shaft reaches its next stop, and the shaft
+
+			void fullTick();							//Simulates one tick for every shaft, then recalculates every event
+			void processEvent(const ShaftEvent& shaftEvent);
+			void synchronizeShaft(size_t shaft, size_t tick);	//Brings a shaft's lazily moved position up to the given tick
+			void scheduleShaft(size_t shaft);			//Adds an event for when a moving shaft reaches its next stop
+
+			ElevatorController* elevatorControllerPtr;
+			std::vector<ShaftEvent> eventQueue;			//Min heap on the event tick, then the shaft
+			std::vector<size_t> synchronizedTicks;		//The tick each shaft's state is up to date with
+			std::vector<size_t> dueShafts;				//The shafts with an event on the tick being processed, in shaft order
+			size_t currentTick;
+			size_t eventCount;
+			bool fullTickNeeded;
+	};
+
+	//Inline member functions
+
+	inline size_t EventDrivenSimulation::getCurrentTick() const {
+		return currentTick;
+	}
+
+	inline size_t EventDrivenSimulation::getEventCount() const {
+		return eventCount;
+	}
+
+	inline void EventDrivenSimulation::stateChanged() {
+		fullTickNeeded = true;
+	}
+}
@@ -0,0 +1,435 @@
+#include "stdafx.h"
+#include "EventLog.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+#define EVENT_LOG_MAGIC "ELEVLOG2"
+#define EVENT_LOG_INDEX_MAGIC "ELEVIDX1"
+#define EVENT_LOG_CHECKPOINT_MAGIC "ELEVLCK1"
+#define EVENT_LOG_MAGIC_LENGTH 8
+#define EVENT_LOG_HEADER_SIZE 20					//Magic, then the number of floors, shafts and the dispatch policy as 32 bit values. The checkpoint file starts with the same.
+#define EVENT_LOG_CHECKPOINT_HEADER_SIZE 24			//The header, padded to 8 bytes so the checkpoints after it stay aligned
+#define EVENT_LOG_CHECKPOINT_ENTRY_SIZE 16			//Tick and size of a checkpoint as 64 bit values, before its bytes
+#define EVENT_LOG_CHECKPOINT_SUFFIX ".checkpoints"
+#define EVENT_LOG_CHECKPOINT_INTERVAL 4096			//Ticks between stored checkpoints, a multiple of the index interval
+#define EVENT_LOG_MINIMUM_FLOORS 2					//The smallest building the controller can simulate
+#define EVENT_LOG_MINIMUM_SHAFTS 1
+#define EVENT_LOG_FOOTER_SIZE 32					//Index offset, end tick and index entry count as 64 bit values, then the magic
+#define EVENT_LOG_INDEX_ENTRY_SIZE 16
+#define EVENT_LOG_INDEX_INTERVAL 1024				//Ticks between index entries
+#define EVENT_LOG_RECORD_TYPE_BITS 2
+#define EVENT_LOG_WRITE_BUFFER_SIZE 65536
+#define VARINT_MAXIMUM_BYTES 10
+
+
+//Appends an unsigned value, 7 bits per byte, with the high bit set on every byte except the last
+static void appendVarint(std::vector<uint8_t>& buffer, uint64_t value) {
+	while (value >= 0x80) {
+		buffer.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	buffer.push_back(static_cast<uint8_t>(value));
+}
+
+//Appends a fixed size little endian value, so logs can be moved between machines
+static void appendFixed(std::vector<uint8_t>& buffer, uint64_t value, size_t byteCount) {
+	for (size_t i = 0; i < byteCount; i++) {
+		buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+	}
+}
+
+static uint64_t readFixed(const uint8_t* data, size_t byteCount) {
+	uint64_t value = 0;
+	for (size_t i = 0; i < byteCount; i++) {
+		value |= static_cast<uint64_t>(data[i]) << (8 * i);
+	}
+	return value;
+}
+
+//Appends the magic and the building, as both the log and its checkpoint file start
+static void appendHeader(std::vector<uint8_t>& buffer, const char* magic, const Elevator::SimulationSettings& simulationSettings) {
+	buffer.insert(buffer.end(), magic, magic + EVENT_LOG_MAGIC_LENGTH);
+	appendFixed(buffer, static_cast<uint32_t>(simulationSettings.numberOfFloors), 4);
+	appendFixed(buffer, static_cast<uint32_t>(simulationSettings.numberOfShafts), 4);
+	appendFixed(buffer, static_cast<uint32_t>(simulationSettings.dispatchPolicy), 4);
+}
+
+std::string Elevator::getEventLogCheckpointPath(const std::string& logPath) {
+	return logPath + EVENT_LOG_CHECKPOINT_SUFFIX;
+}
+
+
+Elevator::EventLogWriter::EventLogWriter() :
+	nextCheckpointTick(EVENT_LOG_CHECKPOINT_INTERVAL),
+	bytesWritten(0),
+	lastRecordTick(0),
+	nextIndexTick(EVENT_LOG_INDEX_INTERVAL),
+	recordCount(0)
+{
+}
+
+Elevator::EventLogWriter::~EventLogWriter() {
+	if (isOpen()) {
+		close(lastRecordTick);
+	}
+}
+
+//Creates the log file and its checkpoint file, and writes their headers. Returns false if either could not be created.
+bool Elevator::EventLogWriter::open(const std::string& logPath, const SimulationSettings& simulationSettings) {
+	std::string checkpointPath = getEventLogCheckpointPath(logPath);
+	logFile.open(logPath, std::ios::binary | std::ios::trunc);
+	checkpointFile.open(checkpointPath, std::ios::binary | std::ios::trunc);
+	if (!logFile.is_open() || !checkpointFile.is_open()) {
+		std::cerr << "Unable to create event log: " << (logFile.is_open() ? checkpointPath : logPath) << std::endl;
+		logFile.close();
+		checkpointFile.close();
+		return false;
+	}
+
+	writeBuffer.clear();
+	writeBuffer.reserve(EVENT_LOG_WRITE_BUFFER_SIZE + 3 * VARINT_MAXIMUM_BYTES);	//A record is at most three varints past a full buffer
+	appendHeader(writeBuffer, EVENT_LOG_CHECKPOINT_MAGIC, simulationSettings);
+	writeBuffer.resize(EVENT_LOG_CHECKPOINT_HEADER_SIZE, 0);
+	checkpointFile.write(reinterpret_cast<const char*>(writeBuffer.data()), writeBuffer.size());
+	writeBuffer.clear();
+	appendHeader(writeBuffer, EVENT_LOG_MAGIC, simulationSettings);
+
+	nextCheckpointTick = EVENT_LOG_CHECKPOINT_INTERVAL;
+	bytesWritten = 0;
+	lastRecordTick = 0;
+	nextIndexTick = EVENT_LOG_INDEX_INTERVAL;
+	recordCount = 0;
+	indexEntries.clear();
+	return true;
+}
+
+//Writes the record header. The first record on or after each index interval gets an index entry pointing at it.
+void Elevator::EventLogWriter::beginRecord(size_t tick, EventLogRecordType recordType) {
+	assert(tick >= lastRecordTick);
+	if (tick >= nextIndexTick) {
+		EventLogIndexEntry indexEntry = { lastRecordTick, bytesWritten + writeBuffer.size() };
+		indexEntries.push_back(indexEntry);
+		nextIndexTick = (tick / EVENT_LOG_INDEX_INTERVAL + 1) * EVENT_LOG_INDEX_INTERVAL;
+	}
+
+	appendVarint(writeBuffer, static_cast<uint64_t>(tick - lastRecordTick) << EVENT_LOG_RECORD_TYPE_BITS | static_cast<uint64_t>(recordType));
+	lastRecordTick = tick;
+	recordCount++;
+}
+
+void Elevator::EventLogWriter::logCall(size_t tick, int floor, MovementDirection direction) {
+	beginRecord(tick, EventLogRecordType::Call);
+	appendVarint(writeBuffer, static_cast<uint64_t>(floor) << 1 | (direction == MovementDirection::Down ? 1 : 0));
+	flushBuffer();
+}
+
+void Elevator::EventLogWriter::logRequestFloor(size_t tick, int shaft, int floor) {
+	beginRecord(tick, EventLogRecordType::RequestFloor);
+	appendVarint(writeBuffer, static_cast<uint64_t>(shaft));
+	appendVarint(writeBuffer, static_cast<uint64_t>(floor));
+	flushBuffer();
+}
+
+void Elevator::EventLogWriter::logPassenger(size_t tick, int originFloor, int destinationFloor) {
+	beginRecord(tick, EventLogRecordType::Passenger);
+	appendVarint(writeBuffer, static_cast<uint64_t>(originFloor));
+	appendVarint(writeBuffer, static_cast<uint64_t>(destinationFloor));
+	flushBuffer();
+}
+
+//The checkpoints are written straight to their own file, so the log's buffer only ever holds records.
+//A checkpoint is only taken once an interval is reached, as the event driven engine does not simulate every tick.
+void Elevator::EventLogWriter::logCheckpoint(size_t tick, const SimulationCheckpoint& checkpoint) {
+	uint64_t entryHeader[2] = { static_cast<uint64_t>(tick), static_cast<uint64_t>(checkpoint.size()) };
+	checkpointFile.write(reinterpret_cast<const char*>(entryHeader), sizeof(entryHeader));
+	checkpointFile.write(static_cast<const char*>(checkpoint.getBytes()), checkpoint.size());
+	nextCheckpointTick = (tick / EVENT_LOG_CHECKPOINT_INTERVAL + 1) * EVENT_LOG_CHECKPOINT_INTERVAL;
+}
+
+//Only writes once the buffer is full, so most records never touch the file
+void Elevator::EventLogWriter::flushBuffer() {
+	if (writeBuffer.size() < EVENT_LOG_WRITE_BUFFER_SIZE) {
+		return;
+	}
+	logFile.write(reinterpret_cast<const char*>(writeBuffer.data()), writeBuffer.size());
+	bytesWritten += writeBuffer.size();
+	writeBuffer.clear();
+}
+
+//Records the end of the session, then writes the index and the footer that points to it
+void Elevator::EventLogWriter::close(size_t endTick) {
+	if (!isOpen()) {
+		return;
+	}
+
+	if (endTick > lastRecordTick) {
+		beginRecord(endTick, EventLogRecordType::Tick);
+	}
+
+	uint64_t indexOffset = bytesWritten + writeBuffer.size();
+	for (size_t i = 0; i < indexEntries.size(); i++) {
+		appendFixed(writeBuffer, indexEntries[i].tick, 8);
+		appendFixed(writeBuffer, indexEntries[i].offset, 8);
+	}
+	appendFixed(writeBuffer, indexOffset, 8);
+	appendFixed(writeBuffer, lastRecordTick, 8);
+	appendFixed(writeBuffer, indexEntries.size(), 8);
+	writeBuffer.insert(writeBuffer.end(), EVENT_LOG_INDEX_MAGIC, EVENT_LOG_INDEX_MAGIC + EVENT_LOG_MAGIC_LENGTH);
+
+	logFile.write(reinterpret_cast<const char*>(writeBuffer.data()), writeBuffer.size());
+	bytesWritten += writeBuffer.size();
+	writeBuffer.clear();
+	logFile.close();
+	checkpointFile.close();
+}
+
+
+Elevator::EventLogReader::EventLogReader() :
+	mappedData(nullptr),
+	mappedSize(0),
+	recordsBegin(0),
+	recordsEnd(0),
+	position(0),
+	positionTick(0),
+	endTick(0),
+	closed(false)
+{
+}
+
+Elevator::EventLogReader::~EventLogReader() {
+	close();
+}
+
+//Maps the whole file, then reads the header and the index, and finds the checkpoints beside it.
+//Returns false, printing why, if it is not a valid log, or if its header holds a building the controller could not be created for.
+bool Elevator::EventLogReader::open(const std::string& logPath) {
+	close();
+
+	if (!mappedFile.open(logPath)) {
+		std::cerr << "Unable to open event log: " << logPath << std::endl;
+		return false;
+	}
+	mappedData = mappedFile.getData();
+	mappedSize = mappedFile.getSize();
+
+	if (mappedSize < EVENT_LOG_HEADER_SIZE || std::memcmp(mappedData, EVENT_LOG_MAGIC, EVENT_LOG_MAGIC_LENGTH) != 0) {
+		std::cerr << "Not an event log: " << logPath << std::endl;
+		close();
+		return false;
+	}
+
+	//The counts are stored unsigned, so a count too large for an int reads as negative and is rejected with the rest
+	uint64_t dispatchPolicy = readFixed(mappedData + EVENT_LOG_MAGIC_LENGTH + 8, 4);
+	simulationSettings.numberOfFloors = static_cast<int>(readFixed(mappedData + EVENT_LOG_MAGIC_LENGTH, 4));
+	simulationSettings.numberOfShafts = static_cast<int>(readFixed(mappedData + EVENT_LOG_MAGIC_LENGTH + 4, 4));
+	simulationSettings.dispatchPolicy = static_cast<DispatchPolicyType>(dispatchPolicy);
+	if (simulationSettings.numberOfFloors < EVENT_LOG_MINIMUM_FLOORS || simulationSettings.numberOfShafts < EVENT_LOG_MINIMUM_SHAFTS
+		|| dispatchPolicy > static_cast<uint64_t>(DispatchPolicyType::Destination)) {
+		std::cerr << "The event log's building is not valid: " << logPath << std::endl;
+		close();
+		return false;
+	}
+	recordsBegin = EVENT_LOG_HEADER_SIZE;
+
+	//A closed log ends with the footer, which points to the index after the records
+	closed = false;
+	if (mappedSize >= recordsBegin + EVENT_LOG_FOOTER_SIZE
+		&& std::memcmp(mappedData + mappedSize - EVENT_LOG_MAGIC_LENGTH, EVENT_LOG_INDEX_MAGIC, EVENT_LOG_MAGIC_LENGTH) == 0) {
+		const uint8_t* footer = mappedData + mappedSize - EVENT_LOG_FOOTER_SIZE;
+		uint64_t indexOffset = readFixed(footer, 8);
+		uint64_t entryCount = readFixed(footer + 16, 8);
+		if (indexOffset >= recordsBegin && indexOffset + entryCount * EVENT_LOG_INDEX_ENTRY_SIZE == mappedSize - EVENT_LOG_FOOTER_SIZE) {
+			recordsEnd = static_cast<size_t>(indexOffset);
+			endTick = static_cast<size_t>(readFixed(footer + 8, 8));
+			indexEntries.resize(static_cast<size_t>(entryCount));
+			for (size_t i = 0; i < indexEntries.size(); i++) {
+				indexEntries[i].tick = readFixed(mappedData + indexOffset + i * EVENT_LOG_INDEX_ENTRY_SIZE, 8);
+				indexEntries[i].offset = readFixed(mappedData + indexOffset + i * EVENT_LOG_INDEX_ENTRY_SIZE + 8, 8);
+			}
+			closed = true;
+		}
+	}
+
+	if (!closed) {
+		rebuildIndex();
+	}
+	openCheckpoints(getEventLogCheckpointPath(logPath));
+	seek(0);
+	return true;
+}
+
+void Elevator::EventLogReader::close() {
+	mappedFile.close();
+	mappedData = nullptr;
+	mappedSize = 0;
+	indexEntries.clear();
+	checkpointFile.close();
+	checkpointEntries.clear();
+}
+
+//A log whose checkpoint file is missing, or was written for another building, is still replayed, only from the beginning.
+//Checkpoints are appended as the session runs, so the last one may have been cut short by a crash.
+void Elevator::EventLogReader::openCheckpoints(const std::string& checkpointPath) {
+	checkpointEntries.clear();
+	if (!checkpointFile.open(checkpointPath)) {
+		return;
+	}
+
+	const uint8_t* checkpointData = checkpointFile.getData();
+	size_t checkpointSize = checkpointFile.getSize();
+	if (checkpointSize < EVENT_LOG_CHECKPOINT_HEADER_SIZE || std::memcmp(checkpointData, EVENT_LOG_CHECKPOINT_MAGIC, EVENT_LOG_MAGIC_LENGTH) != 0
+		|| std::memcmp(checkpointData + EVENT_LOG_MAGIC_LENGTH, mappedData + EVENT_LOG_MAGIC_LENGTH, EVENT_LOG_HEADER_SIZE - EVENT_LOG_MAGIC_LENGTH) != 0) {
+		checkpointFile.close();
+		return;
+	}
+
+	size_t offset = EVENT_LOG_CHECKPOINT_HEADER_SIZE;
+	while (checkpointSize - offset >= EVENT_LOG_CHECKPOINT_ENTRY_SIZE) {
+		uint64_t entryHeader[2];
+		std::memcpy(entryHeader, checkpointData + offset, sizeof(entryHeader));
+		if (entryHeader[1] > checkpointSize - offset - EVENT_LOG_CHECKPOINT_ENTRY_SIZE
+			|| (!checkpointEntries.empty() && entryHeader[0] <= checkpointEntries.back().tick)) {
+			break;
+		}
+		CheckpointEntry checkpointEntry = { static_cast<size_t>(entryHeader[0]), offset + EVENT_LOG_CHECKPOINT_ENTRY_SIZE, static_cast<size_t>(entryHeader[1]) };
+		checkpointEntries.push_back(checkpointEntry);
+		offset = checkpointEntry.offset + checkpointEntry.byteSize;
+	}
+}
+
+const Elevator::EventLogReader::CheckpointEntry* Elevator::EventLogReader::findCheckpointEntry(size_t tick) const {
+	std::vector<CheckpointEntry>::const_iterator checkpointEntry = std::upper_bound(checkpointEntries.begin(), checkpointEntries.end(), tick,
+		[](size_t entryTick, const CheckpointEntry& entry) {
+			return entryTick < entry.tick;
+		});
+	if (checkpointEntry == checkpointEntries.begin()) {
+		return nullptr;
+	}
+	return &*(checkpointEntry - 1);
+}
+
+bool Elevator::EventLogReader::findCheckpoint(size_t tick, size_t& checkpointTick) const {
+	const CheckpointEntry* checkpointEntry = findCheckpointEntry(tick);
+	if (checkpointEntry == nullptr) {
+		return false;
+	}
+	checkpointTick = checkpointEntry->tick;
+	return true;
+}
+
+//Copies the checkpoint's bytes, as restoring reads from a SimulationCheckpoint. Its storage is reused, so loading again does not allocate.
+bool Elevator::EventLogReader::loadCheckpoint(size_t tick, SimulationCheckpoint& checkpoint) const {
+	const CheckpointEntry* checkpointEntry = findCheckpointEntry(tick);
+	if (checkpointEntry == nullptr) {
+		return false;
+	}
+	checkpoint.clear();
+	checkpoint.writeBytes(checkpointFile.getData() + checkpointEntry->offset, checkpointEntry->byteSize);
+	return true;
+}
+
+//Scans the records of a log that was not closed, adding the index entries the writer would have, and stopping before a partly written record
+void Elevator::EventLogReader::rebuildIndex() {
+	recordsEnd = mappedSize;
+	position = recordsBegin;
+	positionTick = 0;
+	endTick = 0;
+	indexEntries.clear();
+
+	size_t nextIndexTick = EVENT_LOG_INDEX_INTERVAL;
+	size_t recordStart = position;
+	size_t previousTick = positionTick;
+	EventLogRecord eventLogRecord;
+	while (next(eventLogRecord)) {
+		if (eventLogRecord.tick >= nextIndexTick) {
+			EventLogIndexEntry indexEntry = { previousTick, recordStart };
+			indexEntries.push_back(indexEntry);
+			nextIndexTick = (eventLogRecord.tick / EVENT_LOG_INDEX_INTERVAL + 1) * EVENT_LOG_INDEX_INTERVAL;
+		}
+		recordStart = position;
+		previousTick = positionTick;
+		endTick = eventLogRecord.tick;
+	}
+	recordsEnd = recordStart;
+}
+
+//Moves to the first record on or after tick. The scan starts from the last index entry before tick, rather than the start of the log.
+void Elevator::EventLogReader::seek(size_t tick) {
+	position = recordsBegin;
+	positionTick = 0;
+
+	//Find the last entry whose records all come after an earlier tick
+	std::vector<EventLogIndexEntry>::const_iterator indexEntry = std::lower_bound(indexEntries.begin(), indexEntries.end(), tick,
+		[](const EventLogIndexEntry& entry, size_t entryTick) {
+			return entry.tick < entryTick;
+		});
+	if (indexEntry != indexEntries.begin()) {
+		indexEntry--;
+		position = static_cast<size_t>(indexEntry->offset);
+		positionTick = static_cast<size_t>(indexEntry->tick);
+	}
+
+	//Skip the records before tick
+	size_t recordStart = position;
+	size_t recordStartTick = positionTick;
+	EventLogRecord eventLogRecord;
+	while (next(eventLogRecord)) {
+		if (eventLogRecord.tick >= tick) {
+			position = recordStart;
+			positionTick = recordStartTick;
+			return;
+		}
+		recordStart = position;
+		recordStartTick = positionTick;
+	}
+}
+
+//Returns false if the records end partway through the varint
+bool Elevator::EventLogReader::readVarint(uint64_t& value) {
+	value = 0;
+	for (int shift = 0; position < recordsEnd && shift < 7 * VARINT_MAXIMUM_BYTES; shift += 7) {
+		uint8_t byte = mappedData[position++];
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//Decodes the next record. Returns false at the end of the log, or at a record that was only partly written.
+bool Elevator::EventLogReader::next(EventLogRecord& eventLogRecord) {
+	if (position >= recordsEnd) {
+		return false;
+	}
+
+	size_t recordStart = position;
+	uint64_t recordHeader, firstArgument = 0, secondArgument = 0;
+	bool complete = readVarint(recordHeader);
+	EventLogRecordType recordType = static_cast<EventLogRecordType>(recordHeader & ((1 << EVENT_LOG_RECORD_TYPE_BITS) - 1));
+	if (complete && recordType != EventLogRecordType::Tick) {
+		complete = readVarint(firstArgument);
+		if (complete && recordType != EventLogRecordType::Call) {
+			complete = readVarint(secondArgument);
+		}
+	}
+	if (!complete) {
+		position = recordStart;
+		return false;
+	}
+
+	positionTick += static_cast<size_t>(recordHeader >> EVENT_LOG_RECORD_TYPE_BITS);
+	eventLogRecord.recordType = recordType;
+	eventLogRecord.tick = positionTick;
+	eventLogRecord.direction = MovementDirection::Up;
+	eventLogRecord.secondArgument = static_cast<int>(secondArgument);
+	if (recordType == EventLogRecordType::Call) {
+		eventLogRecord.firstArgument = static_cast<int>(firstArgument >> 1);
+		eventLogRecord.direction = (firstArgument & 1) ? MovementDirection::Down : MovementDirection::Up;
+	}
+	else {
+		eventLogRecord.firstArgument = static_cast<int>(firstArgument);
+	}
+	return true;
+}
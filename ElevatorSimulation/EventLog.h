@@ -0,0 +1,162 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include "ElevatorState.h"
+#include "MappedFile.h"
+#include "SimulationCheckpoint.h"
+
+namespace Elevator {
+
+	//A compact binary log of the inputs that reached the controller, which can be replayed to recreate a session.
+	//The log starts with a header holding the number of floors and shafts and the dispatch policy, followed by the records.
+	//Each record starts with a varint holding the ticks since the previous record and the record type, followed by its packed arguments as varints:
+	//	Call			floor << 1 | 1 if calling down
+	//	RequestFloor	shaft, floor
+	//	Passenger		origin floor, destination floor
+	//	Tick			no arguments, only marks the passage of time up to the end of the session
+	//Every EVENT_LOG_INDEX_INTERVAL ticks, an index entry records where the records after that tick start. The index is written after the
+	//records when the log is closed. A log that was never closed, e.g. after a crash, can still be read, and its index is rebuilt on open.
+	//Every EVENT_LOG_CHECKPOINT_INTERVAL ticks, the controller's checkpoint is appended to a second file beside the log, named with
+	//EVENT_LOG_CHECKPOINT_SUFFIX, so a replay can start from the nearest one. Each is the state at the start of its tick, after that tick's inputs.
+	//The checkpoints are in the machine's native layout, like SimulationCheckpoint files, and a replay that cannot restore one starts from the beginning.
+	enum class EventLogRecordType : uint8_t {
+		Call = 0,
+		RequestFloor = 1,
+		Passenger = 2,
+		Tick = 3
+	};
+
+	std::string getEventLogCheckpointPath(const std::string& logPath);	//The file beside a log that holds its checkpoints
+
+	//A decoded record. Floors are 0 based, as in the controller.
+	struct EventLogRecord {
+		EventLogRecordType recordType;
+		size_t tick;						//The tick before which the input was applied
+		int firstArgument;					//Floor for Call, shaft for RequestFloor, origin floor for Passenger
+		int secondArgument;					//Unused for Call, floor for RequestFloor, destination floor for Passenger
+		MovementDirection direction;		//Only used for Call
+	};
+
+	//Every record after offset is on a later tick than tick, and every record before it is on tick or earlier
+	struct EventLogIndexEntry {
+		uint64_t tick;
+		uint64_t offset;
+	};
+
+	//Appends the inputs to a log file. Records are buffered, and written in large blocks.
+	class EventLogWriter {
+		public:
+			EventLogWriter();
+			~EventLogWriter();							//Closes the log, if it is still open
+
+			bool open(const std::string& logPath, const SimulationSettings& simulationSettings);	//Returns false if the file could not be created
+			void logCall(size_t tick, int floor, MovementDirection direction);
+			void logRequestFloor(size_t tick, int shaft, int floor);
+			void logPassenger(size_t tick, int originFloor, int destinationFloor);
+			bool isCheckpointDue(size_t tick) const;	//True once a tick reaches the next checkpoint interval
+			void logCheckpoint(size_t tick, const SimulationCheckpoint& checkpoint);	//Appends the state at the start of tick to the checkpoint file
+			void close(size_t endTick);					//Records the end of the session, and writes the index
+			bool isOpen() const;
+			size_t getRecordCount() const;
+
+		private:
+			void beginRecord(size_t tick, EventLogRecordType recordType);	//Writes the record header, adding an index entry if the record crosses an interval
+			void flushBuffer();
+
+			std::ofstream logFile;
+			std::ofstream checkpointFile;
+			size_t nextCheckpointTick;
+			std::vector<uint8_t> writeBuffer;
+			uint64_t bytesWritten;						//Offset of the start of writeBuffer in the file
+			size_t lastRecordTick;
+			size_t nextIndexTick;
+			size_t recordCount;
+			std::vector<EventLogIndexEntry> indexEntries;
+	};
+
+	//Reads a log through a memory mapping of the whole file, so records are decoded straight from the page cache without copying or parsing text
+	class EventLogReader {
+		public:
+			EventLogReader();
+			~EventLogReader();
+
+			//Maps the file and reads the header and index, and the checkpoints beside it if there are any.
+			//Returns false, printing why, if it is not a valid log, or its building could not be simulated.
+			bool open(const std::string& logPath);
+			void close();
+			const SimulationSettings& getSimulationSettings() const;
+			size_t getEndTick() const;					//The last tick of the session
+			size_t getIndexEntryCount() const;
+			size_t getCheckpointCount() const;
+			bool wasClosed() const;						//False if the index had to be rebuilt
+
+			bool findCheckpoint(size_t tick, size_t& checkpointTick) const;	//Sets checkpointTick to the latest stored checkpoint at or before tick. Returns false if there is none.
+			bool loadCheckpoint(size_t tick, SimulationCheckpoint& checkpoint) const;	//Copies the latest stored checkpoint at or before tick. Returns false if there is none.
+
+			void seek(size_t tick);						//Moves to the first record on or after tick, starting from the nearest index entry
+			bool next(EventLogRecord& eventLogRecord);	//Decodes the next record. Returns false at the end of the log.
+
+		private:
+			//Where a stored checkpoint is in the checkpoint file
+			struct CheckpointEntry {
+				size_t tick;
+				size_t offset;
+				size_t byteSize;
+			};
+
+			bool readVarint(uint64_t& value);			//Returns false if the records end partway through the varint
+			void rebuildIndex();						//Scans the records of a log that was not closed
+			void openCheckpoints(const std::string& checkpointPath);	//Finds the checkpoints for the same building, stopping at one that was only partly written
+			const CheckpointEntry* findCheckpointEntry(size_t tick) const;	//The latest checkpoint at or before tick, or nullptr
+
+			MappedFile mappedFile;
+			const uint8_t* mappedData;					//The mapped file's data and size, or nullptr and 0 when closed
+			size_t mappedSize;
+			SimulationSettings simulationSettings;
+			size_t recordsBegin;
+			size_t recordsEnd;
+			size_t position;
+			size_t positionTick;						//Tick of the last record decoded, which the next record's tick is relative to
+			size_t endTick;
+			bool closed;
+			std::vector<EventLogIndexEntry> indexEntries;
+			MappedFile checkpointFile;
+			std::vector<CheckpointEntry> checkpointEntries;	//In tick order
+	};
+
+	//Inline member functions
+
+	inline bool EventLogWriter::isOpen() const {
+		return logFile.is_open();
+	}
+
+	inline size_t EventLogWriter::getRecordCount() const {
+		return recordCount;
+	}
+
+	inline bool EventLogWriter::isCheckpointDue(size_t tick) const {
+		return tick >= nextCheckpointTick && isOpen();
+	}
+
+	inline const SimulationSettings& EventLogReader::getSimulationSettings() const {
+		return simulationSettings;
+	}
+
+	inline size_t EventLogReader::getEndTick() const {
+		return endTick;
+	}
+
+	inline size_t EventLogReader::getIndexEntryCount() const {
+		return indexEntries.size();
+	}
+
+	inline size_t EventLogReader::getCheckpointCount() const {
+		return checkpointEntries.size();
+	}
+
+	inline bool EventLogReader::wasClosed() const {
+		return closed;
+	}
+}
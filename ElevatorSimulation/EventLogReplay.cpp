@@ -0,0 +1,205 @@
+#include "stdafx.h"
+#include "EventLogReplay.h"
+#include <algorithm>
+
+#define REPLAY_CHECKPOINT_INTERVAL 4096 //Ticks between checkpoints at first, a multiple of the log's index interval
+#define REPLAY_MAXIMUM_CHECKPOINTS 64 //The replay's own checkpoints kept in memory
+
+EventLogReplay::EventLogReplay(Elevator::ElevatorController* elevatorControllerPtr, Elevator::EventLogReader* eventLogReaderPtr) :
+	elevatorControllerPtr(elevatorControllerPtr),
+	eventLogReaderPtr(eventLogReaderPtr),
+	eventDrivenSimulation(elevatorControllerPtr),
+	hasPendingRecord(false),
+	checkpointInterval(REPLAY_CHECKPOINT_INTERVAL),
+	recordsApplied(0),
+	recordsRejected(0),
+	checkpointsRestored(0),
+	storedCheckpointsRestored(0),
+	elapsedTime(0)
+{
+	//Nobody is watching a replay, so skip the display and the wait between ticks
+	elevatorControllerPtr->setDisplayEnabled(false);
+	eventLogReaderPtr->seek(elevatorControllerPtr->getCurrentTick());
+
+	//The starting state, before the first tick's records, so any tick can be sought
+	takeCheckpoint(elevatorControllerPtr->getCurrentTick());
+}
+
+//Saves the current state. nextRecordTick is where the log has to be read from to carry on from it.
+void EventLogReplay::takeCheckpoint(size_t nextRecordTick) {
+	if (replayCheckpoints.size() == REPLAY_MAXIMUM_CHECKPOINTS) {
+		thinCheckpoints();
+	}
+	replayCheckpoints.push_back(ReplayCheckpoint());
+	ReplayCheckpoint& replayCheckpoint = replayCheckpoints.back();
+	replayCheckpoint.tick = getCurrentTick();
+	replayCheckpoint.nextRecordTick = nextRecordTick;
+	elevatorControllerPtr->saveCheckpoint(replayCheckpoint.simulationCheckpoint);
+}
+
+//The first checkpoint is the starting state, so it is always kept
+void EventLogReplay::thinCheckpoints() {
+	size_t keptCount = 0;
+	for (size_t i = 0; i < replayCheckpoints.size(); i += 2) {
+		std::swap(replayCheckpoints[keptCount], replayCheckpoints[i]);
+		keptCount++;
+	}
+	replayCheckpoints.resize(keptCount);
+	checkpointInterval *= 2;
+}
+
+//Applies a record to the controller, through the same methods that logged it. Returns false if the record does not fit the controller's building.
+bool EventLogReplay::applyRecord(const Elevator::EventLogRecord& eventLogRecord) {
+	switch (eventLogRecord.recordType) {
+	case Elevator::EventLogRecordType::Call:
+		if (!elevatorControllerPtr->isValidFloorNumber(eventLogRecord.firstArgument)) {
+			return false;
+		}
+		elevatorControllerPtr->callElevator(eventLogRecord.firstArgument, eventLogRecord.direction);
+		return true;
+	case Elevator::EventLogRecordType::RequestFloor:
+		if (!elevatorControllerPtr->isValidShaftNumber(eventLogRecord.firstArgument)
+			|| !elevatorControllerPtr->isValidFloorNumber(eventLogRecord.secondArgument)) {
+			return false;
+		}
+		elevatorControllerPtr->requestFloor(eventLogRecord.firstArgument, eventLogRecord.secondArgument);
+		return true;
+	case Elevator::EventLogRecordType::Passenger:
+		if (!elevatorControllerPtr->isValidFloorNumber(eventLogRecord.firstArgument)
+			|| !elevatorControllerPtr->isValidFloorNumber(eventLogRecord.secondArgument)) {
+			return false;
+		}
+		elevatorControllerPtr->addPassenger(eventLogRecord.firstArgument, eventLogRecord.secondArgument);
+		return true;
+	default:
+		//Tick records only mark the passage of time
+		return true;
+	}
+}
+
+//Simulates up to tick, applying the records up to and including those on tick, and taking checkpoints along the way.
+void EventLogReplay::replayTo(size_t tick) {
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	//Stop at each checkpoint tick past the last checkpoint, or past a stored checkpoint that was restored beyond it, so they stay in tick order.
+	//The state there includes the records on that tick, so the log carries on after it.
+	size_t lastCheckpointTick = std::max(replayCheckpoints.back().tick, getCurrentTick());
+	size_t checkpointTick = (lastCheckpointTick / checkpointInterval + 1) * checkpointInterval;
+	while (checkpointTick <= tick) {
+		replayRecordsTo(checkpointTick);
+		takeCheckpoint(checkpointTick + 1);
+		checkpointTick = (checkpointTick / checkpointInterval + 1) * checkpointInterval;
+	}
+	replayRecordsTo(tick);
+
+	elapsedTime = std::chrono::steady_clock::now() - startTime;
+}
+
+//Starts from whichever is latest at or before tick: the current tick, the replay's own checkpoints, or those stored beside the log.
+//The log is then read from the first record after the checkpoint, which the reader finds from its nearest index entry.
+void EventLogReplay::seekTo(size_t tick) {
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	std::vector<ReplayCheckpoint>::iterator replayCheckpoint = std::upper_bound(replayCheckpoints.begin(), replayCheckpoints.end(), tick,
+		[](size_t seekTick, const ReplayCheckpoint& checkpoint) {
+			return seekTick < checkpoint.tick;
+		});
+	replayCheckpoint--;
+
+	bool restoringOwn = tick < getCurrentTick() || replayCheckpoint->tick > getCurrentTick();
+	size_t startTick = restoringOwn ? replayCheckpoint->tick : getCurrentTick();
+
+	//A stored checkpoint the controller rejects, e.g. one written on another machine, leaves the state as it was, so the replay falls back to its own
+	size_t storedTick = 0;
+	bool restoredStored = eventLogReaderPtr->findCheckpoint(tick, storedTick) && storedTick > startTick
+		&& eventLogReaderPtr->loadCheckpoint(storedTick, storedCheckpoint) && restoreCheckpoint(storedCheckpoint, storedTick + 1);
+	if (restoredStored) {
+		storedCheckpointsRestored++;
+	}
+	else if (restoringOwn) {
+		restoreCheckpoint(replayCheckpoint->simulationCheckpoint, replayCheckpoint->nextRecordTick);
+	}
+	std::chrono::duration<double> restoreTime = std::chrono::steady_clock::now() - startTime;
+
+	replayTo(tick);
+	elapsedTime += restoreTime;
+}
+
+bool EventLogReplay::restoreCheckpoint(Elevator::SimulationCheckpoint& simulationCheckpoint, size_t nextRecordTick) {
+	if (!elevatorControllerPtr->restoreCheckpoint(simulationCheckpoint)) {
+		return false;
+	}
+	eventDrivenSimulation.reset();
+	eventLogReaderPtr->seek(nextRecordTick);
+	hasPendingRecord = false;
+	checkpointsRestored++;
+	return true;
+}
+
+//Simulates up to tick, applying the records up to and including those on tick.
+//Records on the same tick are applied in the order they were logged, before that tick is simulated, as they were recorded.
+//So the state afterwards is the recorded session's state at tick, including any inputs made on it.
+void EventLogReplay::replayRecordsTo(size_t tick) {
+	Elevator::EventLogRecord eventLogRecord;
+	while (hasPendingRecord || eventLogReaderPtr->next(eventLogRecord)) {
+		if (hasPendingRecord) {
+			eventLogRecord = pendingRecord;
+			hasPendingRecord = false;
+		}
+
+		if (eventLogRecord.tick > tick) {
+			pendingRecord = eventLogRecord;
+			hasPendingRecord = true;
+			break;
+		}
+
+		eventDrivenSimulation.advanceTo(eventLogRecord.tick);
+		if (eventLogRecord.recordType == Elevator::EventLogRecordType::Tick) {
+			continue;
+		}
+		if (applyRecord(eventLogRecord)) {
+			recordsApplied++;
+		}
+		else {
+			recordsRejected++;
+		}
+		eventDrivenSimulation.stateChanged();
+	}
+	eventDrivenSimulation.advanceTo(tick);
+}
+
+//Prints the state reached, and how fast the log was replayed
+void EventLogReplay::printSummary(std::ostream& outStream) const {
+	const Elevator::SimulationState& simulationState = elevatorControllerPtr->getCurrentState();
+
+	size_t outstandingHallCalls = simulationState.hallCalls.size();
+
+	size_t movingShafts = 0;
+	for (size_t i = 0; i < simulationState.elevatorShaftVector.size(); i++) {
+		Elevator::MovementStatus movementStatus = simulationState.elevatorShaftVector[i].getCurrentMovementStatus();
+		if (movementStatus == Elevator::MovementStatus::MovingUp || movementStatus == Elevator::MovementStatus::MovingDown) {
+			movingShafts++;
+		}
+	}
+
+	double elapsedSeconds = elapsedTime.count();
+	outStream << "Replay complete." << std::endl;
+	outStream << "Floors: " << simulationState.simulationSettings.numberOfFloors
+		<< ", Shafts: " << simulationState.simulationSettings.numberOfShafts
+		<< ", Dispatch: " << Elevator::getDispatchPolicyName(simulationState.simulationSettings.dispatchPolicy) << std::endl;
+	outStream << "Ticks: " << getCurrentTick() << " of " << eventLogReaderPtr->getEndTick() << " recorded" << std::endl;
+	outStream << "Records applied: " << recordsApplied << " (" << recordsRejected << " rejected)" << std::endl;
+	outStream << "Checkpoints kept: " << replayCheckpoints.size() << ", stored with the log: " << eventLogReaderPtr->getCheckpointCount()
+		<< ", restored: " << checkpointsRestored << " (" << storedCheckpointsRestored << " stored)" << std::endl;
+	if (!eventLogReaderPtr->wasClosed()) {
+		outStream << "The log was not closed, its index was rebuilt" << std::endl;
+	}
+	outStream << "Outstanding hall calls: " << outstandingHallCalls << std::endl;
+	outStream << "Shafts still moving: " << movingShafts << std::endl;
+	outStream << "Elapsed seconds: " << elapsedSeconds << std::endl;
+
+	const Elevator::PassengerTracker& passengerTracker = elevatorControllerPtr->getPassengerTracker();
+	if (passengerTracker.hasPassengers() || passengerTracker.getBuildingWaitHistogram().getCount() > 0) {
+		passengerTracker.printStatistics(outStream);
+	}
+}
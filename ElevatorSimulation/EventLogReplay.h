@@ -0,0 +1,74 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include "ElevatorController.h"
+#include "EventLog.h"
+#include "EventDrivenSimulation.h"
+#include "SimulationCheckpoint.h"
+
+//A checkpoint taken during a replay, and the tick of the first record that was not yet applied when it was taken
+struct ReplayCheckpoint {
+	size_t tick;
+	size_t nextRecordTick;
+	Elevator::SimulationCheckpoint simulationCheckpoint;
+};
+
+//Replays a recorded event log into a controller as fast as possible. The records are decoded straight from the mapped file,
+//and the event driven engine skips the ticks between them where nothing happens, so no text is parsed and no idle tick is simulated.
+//The replayed state is the same as the recorded session's state at every tick.
+//Seeking to a tick restores the latest checkpoint before it, and the log is read from its nearest index entry, so a seek does not replay from the start.
+//The checkpoints stored beside the log when it was recorded let a new replay jump straight to any tick. The replay also takes its own as it moves
+//forward, every REPLAY_CHECKPOINT_INTERVAL ticks, for logs without them. Those are capped at REPLAY_MAXIMUM_CHECKPOINTS: once the cap is reached,
+//every other one is dropped and the interval doubles, so they still cover the whole replay.
+class EventLogReplay
+{
+	public:
+		EventLogReplay(Elevator::ElevatorController* elevatorControllerPtr, Elevator::EventLogReader* eventLogReaderPtr);
+
+		void replayTo(size_t tick);								//Simulates up to tick, applying the records up to and including those on it. Continues from where the last replay stopped.
+		void seekTo(size_t tick);								//Moves to any tick, restoring a checkpoint first if that is closer than replaying from the current tick
+		size_t getCurrentTick() const;
+		size_t getCheckpointCount() const;
+		size_t getStoredCheckpointsRestored() const;			//How many seeks started from a checkpoint stored beside the log
+		//Prints the state reached, and how long the last replay or seek took.
+		//After a checkpoint has been restored, the passenger statistics only cover the ticks since that checkpoint.
+		void printSummary(std::ostream& outStream) const;
+
+	private:
+		void replayRecordsTo(size_t tick);						//Replays without taking checkpoints
+		void takeCheckpoint(size_t nextRecordTick);
+		void thinCheckpoints();									//Drops every other checkpoint after the first, and doubles the interval
+		bool restoreCheckpoint(Elevator::SimulationCheckpoint& simulationCheckpoint, size_t nextRecordTick);	//Returns false, leaving the replay where it was, if the controller rejects it
+		bool applyRecord(const Elevator::EventLogRecord& eventLogRecord);	//Returns false if the record does not fit the controller's building
+
+		Elevator::ElevatorController* elevatorControllerPtr;
+		Elevator::EventLogReader* eventLogReaderPtr;
+		Elevator::EventDrivenSimulation eventDrivenSimulation;
+		Elevator::EventLogRecord pendingRecord;					//A record read past the end of the last replay, applied first by the next one
+		bool hasPendingRecord;
+		std::vector<ReplayCheckpoint> replayCheckpoints;		//In tick order
+		size_t checkpointInterval;								//Ticks between the replay's own checkpoints
+		Elevator::SimulationCheckpoint storedCheckpoint;		//The last checkpoint loaded from beside the log, reused for each
+
+		//Results of the replays so far
+		size_t recordsApplied;
+		size_t recordsRejected;
+		size_t checkpointsRestored;
+		size_t storedCheckpointsRestored;
+		std::chrono::duration<double> elapsedTime;				//Of the last replay or seek
+};
+
+//Inline member functions
+
+inline size_t EventLogReplay::getCurrentTick() const {
+	return eventDrivenSimulation.getCurrentTick();
+}
+
+inline size_t EventLogReplay::getCheckpointCount() const {
+	return replayCheckpoints.size();
+}
+
+inline size_t EventLogReplay::getStoredCheckpointsRestored() const {
+	return storedCheckpointsRestored;
+}
@@ -0,0 +1,101 @@
+#include "stdafx.h"
+#include "FleetBenchmark.h"
+
+#define FLEET_BENCHMARK_SEED 20170401
+#define REQUEST_INTERVAL 16				//How many ticks between each batch of requests
+#define REQUESTS_PER_SHAFT_DIVISOR 4	//Each batch gives roughly one in this many shafts a request
+
+
+FleetBenchmark::FleetBenchmark(Elevator::SimulationSettings settings) :
+	simulationSettings(settings),
+	ticksRun(0),
+	controllerElapsedTime(0),
+	fleetElapsedTime(0),
+	mismatchedShafts(0)
+{
+}
+
+//Fills floorRequests with the next batch of random requests
+void FleetBenchmark::generateRequests(std::mt19937& randomGenerator) {
+	std::uniform_int_distribution<int> floorDistribution(0, simulationSettings.numberOfFloors - 1);
+	std::uniform_int_distribution<int> selectionDistribution(0, REQUESTS_PER_SHAFT_DIVISOR - 1);
+
+	floorRequests.clear();
+	for (int shaft = 0; shaft < simulationSettings.numberOfShafts; shaft++) {
+		if (selectionDistribution(randomGenerator) == 0) {
+			floorRequests.push_back(std::make_pair(static_cast<size_t>(shaft), floorDistribution(randomGenerator)));
+		}
+	}
+}
+
+//Runs both layouts for a number of ticks. Only the requests and ticks are timed, not generating the requests.
+void FleetBenchmark::run(size_t numberOfTicks) {
+	ticksRun = numberOfTicks;
+
+	//The current layout, a vector of ElevatorShaft inside the controller
+	Elevator::ElevatorController controller(simulationSettings);
+	controller.setDisplayEnabled(false);
+	std::mt19937 controllerRandomGenerator(FLEET_BENCHMARK_SEED);
+	controllerElapsedTime = std::chrono::duration<double>(0);
+
+	for (size_t tick = 0; tick < numberOfTicks; tick++) {
+		if (tick % REQUEST_INTERVAL == 0) {
+			generateRequests(controllerRandomGenerator);
+		}
+
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		if (tick % REQUEST_INTERVAL == 0) {
+			for (size_t i = 0; i < floorRequests.size(); i++) {
+				controller.requestFloor(static_cast<int>(floorRequests[i].first), floorRequests[i].second);
+			}
+		}
+		controller.simulationTick();
+		controllerElapsedTime += std::chrono::steady_clock::now() - startTime;
+	}
+
+	//The struct of arrays layout, with its own hall calls
+	Elevator::ElevatorFleet fleet(simulationSettings.numberOfShafts, simulationSettings.numberOfFloors);
+	Elevator::HallCallSet hallCalls(simulationSettings.numberOfFloors);
+	std::mt19937 fleetRandomGenerator(FLEET_BENCHMARK_SEED);
+	fleetElapsedTime = std::chrono::duration<double>(0);
+
+	for (size_t tick = 0; tick < numberOfTicks; tick++) {
+		if (tick % REQUEST_INTERVAL == 0) {
+			generateRequests(fleetRandomGenerator);
+		}
+
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		if (tick % REQUEST_INTERVAL == 0) {
+			for (size_t i = 0; i < floorRequests.size(); i++) {
+				fleet.requestFloor(floorRequests[i].first, floorRequests[i].second);
+			}
+		}
+		fleet.simulationTick(hallCalls);
+		fleetElapsedTime += std::chrono::steady_clock::now() - startTime;
+	}
+
+	//Both layouts should have ended up in the same place
+	const std::vector<Elevator::ElevatorShaft>& elevatorShafts = controller.getCurrentState().elevatorShaftVector;
+	mismatchedShafts = 0;
+	for (size_t i = 0; i < elevatorShafts.size(); i++) {
+		if (elevatorShafts[i].getCurrentPosition() != fleet.getCurrentPosition(i)
+			|| elevatorShafts[i].getCurrentMovementStatus() != fleet.getCurrentMovementStatus(i)) {
+			mismatchedShafts++;
+		}
+	}
+}
+
+//Prints the ticks per second of both layouts
+void FleetBenchmark::printSummary(std::ostream& outStream) const {
+	double controllerSeconds = controllerElapsedTime.count();
+	double fleetSeconds = fleetElapsedTime.count();
+	double controllerTicksPerSecond = controllerSeconds > 0 ? ticksRun / controllerSeconds : 0;
+	double fleetTicksPerSecond = fleetSeconds > 0 ? ticksRun / fleetSeconds : 0;
+
+	outStream << "Fleet benchmark complete." << std::endl;
+	outStream << "Floors: " << simulationSettings.numberOfFloors << ", Shafts: " << simulationSettings.numberOfShafts << ", Ticks: " << ticksRun << std::endl;
+	outStream << "ElevatorController ticks per second: " << controllerTicksPerSecond << std::endl;
+	outStream << "ElevatorFleet ticks per second: " << fleetTicksPerSecond << std::endl;
+	outStream << "Speedup: " << (controllerTicksPerSecond > 0 ? fleetTicksPerSecond / controllerTicksPerSecond : 0) << "x" << std::endl;
+	outStream << "Shafts with a different final state: " << mismatchedShafts << std::endl;
+}
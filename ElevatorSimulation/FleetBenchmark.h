@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include "ElevatorState.h"
+#include "ElevatorController.h"
+#include "ElevatorFleet.h"
+
+//Compares the ticks per second of the struct of arrays ElevatorFleet against the ElevatorController's vector of shafts.
+//Both layouts are given the same random requests, and their final states are compared to check that they agree.
+class FleetBenchmark
+{
+	public:
+		FleetBenchmark(Elevator::SimulationSettings settings);
+
+		void run(size_t numberOfTicks);					//Runs both layouts for a number of ticks
+		void printSummary(std::ostream& outStream) const;
+
+	private:
+		void generateRequests(std::mt19937& randomGenerator);	//Fills floorRequests with the next batch of random requests
+
+		const Elevator::SimulationSettings simulationSettings;
+		std::vector<std::pair<size_t, int>> floorRequests;		//Shaft and floor pairs
+
+		size_t ticksRun;
+		std::chrono::duration<double> controllerElapsedTime;
+		std::chrono::duration<double> fleetElapsedTime;
+		size_t mismatchedShafts;								//Shafts whose final state differs between the layouts
+};
@@ -0,0 +1,87 @@
+#include "stdafx.h"
+#include "FloorStopSet.h"
+#include <algorithm>
+
+#define BITS_PER_WORD 64
+
+//Creates an empty set, which must be resized before it can hold floors
+Elevator::FloorStopSet::FloorStopSet() :
+	floorCount(0),
+	numberOfFloors(0)
+{}
+
+//Creates an empty set for a building with a given number of floors
+Elevator::FloorStopSet::FloorStopSet(int numberOfFloors) :
+	floorCount(0),
+	numberOfFloors(0)
+{
+	resize(numberOfFloors);
+}
+
+//Sizes the set for a building, removing all floors
+void Elevator::FloorStopSet::resize(int _numberOfFloors) {
+	assert(_numberOfFloors >= 0);
+	numberOfFloors = _numberOfFloors;
+	words.assign((numberOfFloors + BITS_PER_WORD - 1) / BITS_PER_WORD, 0);
+	floorCount = 0;
+}
+
+//Removes all floors, keeping the size
+void Elevator::FloorStopSet::clear() {
+	std::fill(words.begin(), words.end(), 0);
+	floorCount = 0;
+}
+
+//Replaces the raw bits, counting the floors again. Bits past the top floor must be clear.
+void Elevator::FloorStopSet::assignWords(const uint64_t* sourceWords) {
+	std::copy(sourceWords, sourceWords + words.size(), words.begin());
+	floorCount = 0;
+	for (size_t i = 0; i < words.size(); i++) {
+		floorCount += countSetBits(words[i]);
+	}
+}
+
+//Only the last word can hold bits past the top floor
+bool Elevator::FloorStopSet::areValidWords(const uint64_t* sourceWords) const {
+	int floorsInLastWord = numberOfFloors % BITS_PER_WORD;
+	if (words.empty() || floorsInLastWord == 0) {
+		return true;
+	}
+	return (sourceWords[words.size() - 1] >> floorsInLastWord) == 0;
+}
+
+//Returns the lowest floor in the set that is >= floorNumber, or -1 if there is none
+int Elevator::FloorStopSet::findNextAtOrAbove(int floorNumber) const {
+	if (floorNumber < 0) {
+		floorNumber = 0;
+	}
+	if (floorNumber >= numberOfFloors || floorCount == 0) {
+		return -1;
+	}
+	return findSetBitAtOrAbove(words.data(), words.size(), floorNumber);
+}
+
+//Returns the highest floor in the set that is <= floorNumber, or -1 if there is none
+int Elevator::FloorStopSet::findNextAtOrBelow(int floorNumber) const {
+	if (floorNumber >= numberOfFloors) {
+		floorNumber = numberOfFloors - 1;
+	}
+	if (floorNumber < 0 || floorCount == 0) {
+		return -1;
+	}
+	return findSetBitAtOrBelow(words.data(), floorNumber);
+}
+
+//Counts the floors in the set between lowFloor and highFloor, inclusive
+size_t Elevator::FloorStopSet::countInRange(int lowFloor, int highFloor) const {
+	if (lowFloor < 0) {
+		lowFloor = 0;
+	}
+	if (highFloor >= numberOfFloors) {
+		highFloor = numberOfFloors - 1;
+	}
+	if (lowFloor > highFloor || floorCount == 0) {
+		return 0;
+	}
+	return countSetBitsInRange(words.data(), lowFloor, highFloor);
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <assert.h>
+#include "BitOperations.h"
+
+namespace Elevator {
+
+	//A set of floors, stored as one bit per floor.
+	//Inserting and removing are constant time, and a floor can only be in the set once.
+	//Finding the next floor above or below a given floor scans a word (64 floors) at a time.
+	class FloorStopSet {
+		public:
+			FloorStopSet();
+			explicit FloorStopSet(int numberOfFloors);
+
+			void resize(int numberOfFloors);					//Sizes the set for a building, removing all floors
+			void clear();										//Removes all floors
+
+			bool insert(int floorNumber);						//Adds a floor. Returns false if it was already in the set.
+			bool erase(int floorNumber);						//Removes a floor. Returns false if it was not in the set.
+			bool contains(int floorNumber) const;
+			bool empty() const;
+			size_t size() const;								//How many floors are in the set
+
+			int findNextAtOrAbove(int floorNumber) const;		//Returns the lowest floor in the set that is >= floorNumber, or -1 if there is none
+			int findNextAtOrBelow(int floorNumber) const;		//Returns the highest floor in the set that is <= floorNumber, or -1 if there is none
+			int lowest() const;									//Returns the lowest floor in the set, or -1 if it is empty
+			int highest() const;								//Returns the highest floor in the set, or -1 if it is empty
+			size_t countInRange(int lowFloor, int highFloor) const;	//Counts the floors in the set between lowFloor and highFloor, inclusive
+
+			int getNumberOfFloors() const;
+			const std::vector<uint64_t>& getWords() const;		//The raw bits, 64 floors per word
+			void assignWords(const uint64_t* sourceWords);		//Replaces the raw bits with the same number of words, e.g. from a checkpoint
+			bool areValidWords(const uint64_t* sourceWords) const;	//True if the words have no bits past the top floor, so they can be assigned
+
+		private:
+			std::vector<uint64_t> words;
+			size_t floorCount;									//How many floors are in the set
+			int numberOfFloors;
+	};
+
+	//Inline member functions
+
+	inline bool FloorStopSet::insert(int floorNumber) {
+		assert(floorNumber >= 0 && floorNumber < numberOfFloors);
+		uint64_t& word = words[floorNumber >> 6];
+		uint64_t bit = 1ULL << (floorNumber & 63);
+		if (word & bit) {
+			return false;
+		}
+		word |= bit;
+		floorCount++;
+		return true;
+	}
+
+	inline bool FloorStopSet::erase(int floorNumber) {
+		assert(floorNumber >= 0 && floorNumber < numberOfFloors);
+		uint64_t& word = words[floorNumber >> 6];
+		uint64_t bit = 1ULL << (floorNumber & 63);
+		if (!(word & bit)) {
+			return false;
+		}
+		word &= ~bit;
+		floorCount--;
+		return true;
+	}
+
+	inline bool FloorStopSet::contains(int floorNumber) const {
+		if (floorNumber < 0 || floorNumber >= numberOfFloors) {
+			return false;
+		}
+		return (words[floorNumber >> 6] >> (floorNumber & 63)) & 1;
+	}
+
+	inline bool FloorStopSet::empty() const {
+		return floorCount == 0;
+	}
+
+	inline size_t FloorStopSet::size() const {
+		return floorCount;
+	}
+
+	inline int FloorStopSet::lowest() const {
+		return findNextAtOrAbove(0);
+	}
+
+	inline int FloorStopSet::highest() const {
+		return findNextAtOrBelow(numberOfFloors - 1);
+	}
+
+	inline int FloorStopSet::getNumberOfFloors() const {
+		return numberOfFloors;
+	}
+
+	inline const std::vector<uint64_t>& FloorStopSet::getWords() const {
+		return words;
+	}
+}
@@ -0,0 +1,46 @@
+#include "stdafx.h"
+#include "HallCallSet.h"
+
+//Creates an empty set, which must be resized before it can hold calls
+Elevator::HallCallSet::HallCallSet()
+{}
+
+//Creates a set with no calls for a building with a given number of floors
+Elevator::HallCallSet::HallCallSet(int numberOfFloors) :
+	upCalls(numberOfFloors),
+	downCalls(numberOfFloors)
+{}
+
+//Sizes the set for a building, clearing every call
+void Elevator::HallCallSet::resize(int numberOfFloors) {
+	upCalls.resize(numberOfFloors);
+	downCalls.resize(numberOfFloors);
+}
+
+//Clears every call, keeping the size
+void Elevator::HallCallSet::clear() {
+	upCalls.clear();
+	downCalls.clear();
+}
+
+//Sets the call for a direction. The floors at either end of the building only have the button that leads into it.
+bool Elevator::HallCallSet::call(int floorNumber, MovementDirection direction) {
+	if (direction == MovementDirection::Up) {
+		return floorNumber < upCalls.getNumberOfFloors() - 1 && upCalls.insert(floorNumber);
+	}
+	return floorNumber > 0 && downCalls.insert(floorNumber);
+}
+
+//Clears the call in the direction a shaft leaves the floor in. A waiting shaft meets the calls in both directions.
+void Elevator::HallCallSet::callMet(int floorNumber, MovementStatus elevatorStatus) {
+	if (elevatorStatus == MovementStatus::MovingDown) {
+		downCalls.erase(floorNumber);
+	}
+	else if (elevatorStatus == MovementStatus::MovingUp) {
+		upCalls.erase(floorNumber);
+	}
+	else {
+		downCalls.erase(floorNumber);
+		upCalls.erase(floorNumber);
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "ElevatorState.h"
+#include "FloorStopSet.h"
+
+namespace Elevator {
+
+	//The building's hall calls, packed as one bit per floor for each direction.
+	//The bottom floor has no down button and the top floor has no up button, so calls for those are ignored.
+	//A moving shaft finds the next call ahead of it in its direction a word (64 floors) at a time, so passing shafts can stop for calls on their way.
+	class HallCallSet {
+		public:
+			HallCallSet();
+			explicit HallCallSet(int numberOfFloors);
+
+			void resize(int numberOfFloors);					//Sizes the set for a building, clearing every call
+			void clear();										//Clears every call
+
+			bool call(int floorNumber, MovementDirection direction);	//Returns true if the floor was not already calling, and has a button for the direction
+			bool isCalling(int floorNumber, MovementDirection direction) const;
+			bool isCallingForUp(int floorNumber) const;
+			bool isCallingForDown(int floorNumber) const;
+			bool callMet(int floorNumber, MovementDirection direction);	//Clears a call. Returns false if the floor was not calling.
+			void callMet(int floorNumber, MovementStatus elevatorStatus);	//Clears the call in the direction a shaft leaves in, or both for a waiting shaft
+			size_t size() const;								//How many calls are outstanding, counting each direction
+
+			//The nearest call ahead of a shaft at position, strictly before nextStop, made in the direction the shaft is travelling.
+			//Returns -1 if there is none. A shaft that stops there still has nextStop ahead, so it leaves in the call's direction.
+			int findCallAhead(int position, MovementDirection direction, int nextStop) const;
+
+			const FloorStopSet& getUpCalls() const;
+			const FloorStopSet& getDownCalls() const;
+
+		private:
+			FloorStopSet upCalls;
+			FloorStopSet downCalls;
+	};
+
+	//Inline member functions
+
+	inline bool HallCallSet::isCallingForUp(int floorNumber) const {
+		return upCalls.contains(floorNumber);
+	}
+
+	inline bool HallCallSet::isCallingForDown(int floorNumber) const {
+		return downCalls.contains(floorNumber);
+	}
+
+	inline bool HallCallSet::isCalling(int floorNumber, MovementDirection direction) const {
+		return direction == MovementDirection::Up ? upCalls.contains(floorNumber) : downCalls.contains(floorNumber);
+	}
+
+	inline bool HallCallSet::callMet(int floorNumber, MovementDirection direction) {
+		return direction == MovementDirection::Up ? upCalls.erase(floorNumber) : downCalls.erase(floorNumber);
+	}
+
+	inline size_t HallCallSet::size() const {
+		return upCalls.size() + downCalls.size();
+	}
+
+	inline int HallCallSet::findCallAhead(int position, MovementDirection direction, int nextStop) const {
+		if (direction == MovementDirection::Up) {
+			if (nextStop <= position + 1) {
+				return -1;
+			}
+			int floorNumber = upCalls.findNextAtOrAbove(position + 1);
+			return floorNumber >= 0 && floorNumber < nextStop ? floorNumber : -1;
+		}
+
+		if (nextStop >= position - 1) {
+			return -1;
+		}
+		int floorNumber = downCalls.findNextAtOrBelow(position - 1);
+		return floorNumber > nextStop ? floorNumber : -1;
+	}
+
+	inline const FloorStopSet& HallCallSet::getUpCalls() const {
+		return upCalls;
+	}
+
+	inline const FloorStopSet& HallCallSet::getDownCalls() const {
+		return downCalls;
+	}
+}
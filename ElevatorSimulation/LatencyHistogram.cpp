@@ -0,0 +1,67 @@
+#include "stdafx.h"
+#include "LatencyHistogram.h"
+#include "BitOperations.h"
+#include <algorithm>
+
+
+Elevator::LatencyHistogram::LatencyHistogram() {
+	clear();
+}
+
+void Elevator::LatencyHistogram::clear() {
+	std::fill(bucketCounts, bucketCounts + BUCKET_COUNT, 0);
+	count = 0;
+	maximum = 0;
+	total = 0;
+}
+
+void Elevator::LatencyHistogram::record(size_t value) {
+	bucketCounts[bucketIndex(value)]++;
+	count++;
+	maximum = std::max(maximum, value);
+	total += static_cast<double>(value);
+}
+
+//Small values have a bucket each. Larger values are bucketed by their highest set bit, then by the SUB_BUCKET_BITS bits below it.
+int Elevator::LatencyHistogram::bucketIndex(size_t value) {
+	if (value < SUB_BUCKET_COUNT) {
+		return static_cast<int>(value);
+	}
+
+	int highestBit = findLastSetBit(static_cast<uint64_t>(value));
+	if (highestBit >= LARGEST_VALUE_BITS) {
+		return BUCKET_COUNT - 1;
+	}
+
+	int shift = highestBit - SUB_BUCKET_BITS;
+	return (shift + 1) * SUB_BUCKET_COUNT + static_cast<int>(value >> shift) - SUB_BUCKET_COUNT;
+}
+
+//The inverse of bucketIndex, returning the highest value that falls in the bucket
+size_t Elevator::LatencyHistogram::bucketHighestValue(int bucket) {
+	if (bucket < SUB_BUCKET_COUNT) {
+		return static_cast<size_t>(bucket);
+	}
+
+	int shift = bucket / SUB_BUCKET_COUNT - 1;
+	size_t lowestValue = static_cast<size_t>(bucket % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT) << shift;
+	return lowestValue + (static_cast<size_t>(1) << shift) - 1;
+}
+
+//Finds the bucket holding the value at the percentile's rank, counting from the lowest bucket
+size_t Elevator::LatencyHistogram::getPercentile(double percentile) const {
+	if (count == 0) {
+		return 0;
+	}
+
+	uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * count + 0.5);
+	rank = std::max<uint64_t>(rank, 1);
+	uint64_t countSoFar = 0;
+	for (int i = 0; i < BUCKET_COUNT; i++) {
+		countSoFar += bucketCounts[i];
+		if (countSoFar >= rank) {
+			return std::min(bucketHighestValue(i), maximum);
+		}
+	}
+	return maximum;
+}
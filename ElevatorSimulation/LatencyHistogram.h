@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace Elevator {
+
+	//Counts latencies (in ticks) in buckets that grow logarithmically, so the memory used is fixed however many values are recorded.
+	//Values below 2^SUB_BUCKET_BITS have a bucket each. Above that, each power of two is split into 2^SUB_BUCKET_BITS buckets,
+	//so a percentile is never more than 1 / 2^SUB_BUCKET_BITS away from the true value. The maximum is kept exactly.
+	class LatencyHistogram {
+		public:
+			LatencyHistogram();
+
+			void record(size_t value);
+			void clear();
+			size_t getCount() const;
+			size_t getMaximum() const;
+			double getMean() const;
+			size_t getPercentile(double percentile) const;		//Returns the highest value in the bucket that holds the percentile (0 to 100), capped at the maximum
+
+			static const int SUB_BUCKET_BITS = 4;
+			static const int LARGEST_VALUE_BITS = 32;			//Larger values are counted in the last bucket
+			static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+			static const int BUCKET_COUNT = (LARGEST_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+		private:
+			static int bucketIndex(size_t value);
+			static size_t bucketHighestValue(int bucket);
+
+			uint64_t bucketCounts[BUCKET_COUNT];
+			size_t count;
+			size_t maximum;
+			double total;
+	};
+
+	//Inline member functions
+
+	inline size_t LatencyHistogram::getCount() const {
+		return count;
+	}
+
+	inline size_t LatencyHistogram::getMaximum() const {
+		return maximum;
+	}
+
+	inline double LatencyHistogram::getMean() const {
+		return count > 0 ? total / count : 0;
+	}
+}
@@ -0,0 +1,90 @@
+#include "stdafx.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+Elevator::MappedFile::MappedFile() :
+	mappedData(nullptr),
+	mappedSize(0)
+#ifdef _WIN32
+	, fileHandle(INVALID_HANDLE_VALUE),
+	mappingHandle(nullptr)
+#endif
+{
+}
+
+Elevator::MappedFile::~MappedFile() {
+	close();
+}
+
+//Maps the whole file. An empty file cannot be mapped, so it opens with no data.
+bool Elevator::MappedFile::open(const std::string& filePath) {
+	close();
+
+#ifdef _WIN32
+	fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(fileHandle, &fileSize);
+	mappedSize = static_cast<size_t>(fileSize.QuadPart);
+	if (mappedSize > 0) {
+		mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mappingHandle != nullptr) {
+			mappedData = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+		}
+	}
+#else
+	int fileDescriptor = ::open(filePath.c_str(), O_RDONLY);
+	if (fileDescriptor < 0) {
+		return false;
+	}
+	struct stat fileStatus;
+	fstat(fileDescriptor, &fileStatus);
+	mappedSize = static_cast<size_t>(fileStatus.st_size);
+	if (mappedSize > 0) {
+		void* mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		if (mapping != MAP_FAILED) {
+			mappedData = static_cast<const uint8_t*>(mapping);
+			madvise(mapping, mappedSize, MADV_SEQUENTIAL);
+		}
+	}
+	::close(fileDescriptor);				//The mapping keeps the file open
+#endif
+
+	if (mappedData == nullptr) {
+		mappedSize = 0;
+	}
+	return true;
+}
+
+void Elevator::MappedFile::close() {
+#ifdef _WIN32
+	if (mappedData != nullptr) {
+		UnmapViewOfFile(mappedData);
+	}
+	if (mappingHandle != nullptr) {
+		CloseHandle(mappingHandle);
+		mappingHandle = nullptr;
+	}
+	if (fileHandle != INVALID_HANDLE_VALUE) {
+		CloseHandle(fileHandle);
+		fileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (mappedData != nullptr) {
+		munmap(const_cast<uint8_t*>(mappedData), mappedSize);
+	}
+#endif
+	mappedData = nullptr;
+	mappedSize = 0;
+}
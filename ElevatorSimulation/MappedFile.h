@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace Elevator {
+
+	//A read only memory mapping of a whole file, so it can be read straight from the page cache without copying it into buffers.
+	//The file is read front to back, so the mapping asks for aggressive read ahead where the platform supports it.
+	class MappedFile {
+		public:
+			MappedFile();
+			~MappedFile();
+
+			bool open(const std::string& filePath);		//Returns false if the file could not be opened. An empty file opens, with no data.
+			void close();
+			const uint8_t* getData() const;				//nullptr if nothing is mapped
+			size_t getSize() const;
+
+		private:
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			const uint8_t* mappedData;
+			size_t mappedSize;
+#ifdef _WIN32
+			void* fileHandle;
+			void* mappingHandle;
+#endif
+	};
+
+	//Inline member functions
+	inline const uint8_t* MappedFile::getData() const {
+		return mappedData;
+	}
+
+	inline size_t MappedFile::getSize() const {
+		return mappedSize;
+	}
+}
@@ -0,0 +1,99 @@
+#include "stdafx.h"
+#include "ParallelTickBenchmark.h"
+
+#define PARALLEL_BENCHMARK_SEED 20170402
+#define REQUEST_INTERVAL 16				//How many ticks between each batch of calls and requests
+#define REQUESTS_PER_SHAFT_DIVISOR 4	//Each batch gives roughly one in this many shafts a request
+#define CALLS_PER_BATCH 64
+
+
+ParallelTickBenchmark::ParallelTickBenchmark(Elevator::SimulationSettings settings) :
+	simulationSettings(settings),
+	ticksRun(0)
+{
+}
+
+//Runs one thread count, returning the controller so that its final state can be compared. Only the calls, requests and ticks are timed.
+std::unique_ptr<Elevator::ElevatorController> ParallelTickBenchmark::runWithThreads(size_t numberOfTicks, size_t threadCount, double& ticksPerSecond) {
+	std::unique_ptr<Elevator::ElevatorController> controllerPtr(new Elevator::ElevatorController(simulationSettings));
+	Elevator::ElevatorController& controller = *controllerPtr;
+	controller.setDisplayEnabled(false);
+	controller.setWorkerThreadCount(threadCount);
+
+	std::mt19937 randomGenerator(PARALLEL_BENCHMARK_SEED);
+	std::uniform_int_distribution<int> floorDistribution(0, simulationSettings.numberOfFloors - 1);
+	std::uniform_int_distribution<int> selectionDistribution(0, REQUESTS_PER_SHAFT_DIVISOR - 1);
+	std::uniform_int_distribution<int> directionDistribution(0, 1);
+	std::chrono::duration<double> elapsedTime(0);
+
+	for (size_t tick = 0; tick < numberOfTicks; tick++) {
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		if (tick % REQUEST_INTERVAL == 0) {
+			for (int shaft = 0; shaft < simulationSettings.numberOfShafts; shaft++) {
+				if (selectionDistribution(randomGenerator) == 0) {
+					controller.requestFloor(shaft, floorDistribution(randomGenerator));
+				}
+			}
+			for (int i = 0; i < CALLS_PER_BATCH; i++) {
+				int floor = floorDistribution(randomGenerator);
+				controller.callElevator(floor, directionDistribution(randomGenerator) == 0 ? Elevator::MovementDirection::Up : Elevator::MovementDirection::Down);
+			}
+		}
+		controller.simulationTick();
+		elapsedTime += std::chrono::steady_clock::now() - startTime;
+	}
+
+	ticksPerSecond = elapsedTime.count() > 0 ? numberOfTicks / elapsedTime.count() : 0;
+	controller.setWorkerThreadCount(1);
+	return controllerPtr;
+}
+
+//Compares everything the tick writes: positions, statuses, stop sets and floor calls
+bool ParallelTickBenchmark::statesMatch(const Elevator::SimulationState& first, const Elevator::SimulationState& second) {
+	if (first.elevatorShaftVector.size() != second.elevatorShaftVector.size() || first.floorsVector.size() != second.floorsVector.size()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < first.elevatorShaftVector.size(); i++) {
+		const Elevator::ElevatorState& firstShaft = first.elevatorShaftVector[i].getCurrentElevatorState();
+		const Elevator::ElevatorState& secondShaft = second.elevatorShaftVector[i].getCurrentElevatorState();
+		if (firstShaft.currentPosition != secondShaft.currentPosition
+			|| firstShaft.movementStatus != secondShaft.movementStatus
+			|| firstShaft.floorsAboveStopSet.getWords() != secondShaft.floorsAboveStopSet.getWords()
+			|| firstShaft.floorsBelowStopSet.getWords() != secondShaft.floorsBelowStopSet.getWords()) {
+			return false;
+		}
+	}
+
+	return first.hallCalls.getUpCalls().getWords() == second.hallCalls.getUpCalls().getWords()
+		&& first.hallCalls.getDownCalls().getWords() == second.hallCalls.getDownCalls().getWords();
+}
+
+//Runs every thread count from 1 to maximumThreadCount
+void ParallelTickBenchmark::run(size_t numberOfTicks, size_t maximumThreadCount) {
+	ticksRun = numberOfTicks;
+	ticksPerSecondByThreadCount.clear();
+	matchesSingleThread.clear();
+
+	double ticksPerSecond;
+	std::unique_ptr<Elevator::ElevatorController> singleThreadController = runWithThreads(numberOfTicks, 1, ticksPerSecond);
+	ticksPerSecondByThreadCount.push_back(ticksPerSecond);
+	matchesSingleThread.push_back(true);
+
+	for (size_t threadCount = 2; threadCount <= maximumThreadCount; threadCount++) {
+		std::unique_ptr<Elevator::ElevatorController> controller = runWithThreads(numberOfTicks, threadCount, ticksPerSecond);
+		ticksPerSecondByThreadCount.push_back(ticksPerSecond);
+		matchesSingleThread.push_back(statesMatch(singleThreadController->getCurrentState(), controller->getCurrentState()));
+	}
+}
+
+//Prints the ticks per second and speedup for each thread count
+void ParallelTickBenchmark::printSummary(std::ostream& outStream) const {
+	outStream << "Parallel tick benchmark complete." << std::endl;
+	outStream << "Floors: " << simulationSettings.numberOfFloors << ", Shafts: " << simulationSettings.numberOfShafts << ", Ticks: " << ticksRun << std::endl;
+	outStream << "Threads\tTicks per second\tSpeedup\tMatches 1 thread" << std::endl;
+	for (size_t i = 0; i < ticksPerSecondByThreadCount.size(); i++) {
+		double speedup = ticksPerSecondByThreadCount[0] > 0 ? ticksPerSecondByThreadCount[i] / ticksPerSecondByThreadCount[0] : 0;
+		outStream << (i + 1) << "\t" << ticksPerSecondByThreadCount[i] << "\t\t" << speedup << "\t" << (matchesSingleThread[i] ? "yes" : "NO") << std::endl;
+	}
+}
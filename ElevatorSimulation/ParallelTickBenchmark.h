@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+#include <random>
+#include <iostream>
+#include <memory>
+#include "ElevatorState.h"
+#include "ElevatorController.h"
+
+//Measures how simulationTick scales from one worker thread up to a maximum number of threads.
+//Every thread count is given the same random calls and requests, and its final state is compared with the single threaded run.
+class ParallelTickBenchmark
+{
+	public:
+		ParallelTickBenchmark(Elevator::SimulationSettings settings);
+
+		void run(size_t numberOfTicks, size_t maximumThreadCount);
+		void printSummary(std::ostream& outStream) const;
+
+	private:
+		std::unique_ptr<Elevator::ElevatorController> runWithThreads(size_t numberOfTicks, size_t threadCount, double& ticksPerSecond);
+		static bool statesMatch(const Elevator::SimulationState& first, const Elevator::SimulationState& second);
+
+		const Elevator::SimulationSettings simulationSettings;
+		size_t ticksRun;
+		std::vector<double> ticksPerSecondByThreadCount;	//Index 0 is one thread
+		std::vector<bool> matchesSingleThread;
+};
@@ -0,0 +1,298 @@
+#include "stdafx.h"
+#include "PassengerTracker.h"
+#include <iomanip>
+#include <cstring>
+#include <algorithm>
+
+#define WAITING_UP_INDEX(floor) (2 * (floor))
+#define WAITING_DOWN_INDEX(floor) (2 * (floor) + 1)
+
+
+Elevator::PassengerTracker::PassengerTracker(int numberOfFloors, int numberOfShafts) :
+	firstFreePassenger(NO_PASSENGER),
+	waitingPassengerCount(0),
+	ridingPassengerCount(0),
+	floorWaitHistograms(numberOfFloors),
+	floorJourneyHistograms(numberOfFloors)
+{
+	floorsToRequest.reserve(numberOfFloors);
+	floorRequested.assign(numberOfFloors, false);
+	PassengerList emptyList = { NO_PASSENGER, NO_PASSENGER, 0 };
+	waitingPassengers.assign(2 * numberOfFloors, emptyList);
+	ridingPassengers.assign(numberOfShafts, emptyList);
+}
+
+//Stores a passenger in the first free slot, only growing the pool when every slot is in use
+uint32_t Elevator::PassengerTracker::addToPool(const Passenger& passenger) {
+	uint32_t passengerSlot = firstFreePassenger;
+	if (passengerSlot == NO_PASSENGER) {
+		passengerSlot = static_cast<uint32_t>(passengerPool.size());
+		passengerPool.push_back(passenger);
+		nextPassengers.push_back(firstFreePassenger); //NO_PASSENGER, as there are no free slots
+		return passengerSlot;
+	}
+
+	firstFreePassenger = nextPassengers[passengerSlot];
+	passengerPool[passengerSlot] = passenger;
+	nextPassengers[passengerSlot] = NO_PASSENGER;
+	return passengerSlot;
+}
+
+//Adds a passenger's slot to the end of a list
+void Elevator::PassengerTracker::appendPassenger(PassengerList& passengerList, uint32_t passengerSlot) {
+	nextPassengers[passengerSlot] = NO_PASSENGER;
+	if (passengerList.lastPassenger == NO_PASSENGER) {
+		passengerList.firstPassenger = passengerSlot;
+	}
+	else {
+		nextPassengers[passengerList.lastPassenger] = passengerSlot;
+	}
+	passengerList.lastPassenger = passengerSlot;
+	passengerList.passengerCount++;
+}
+
+void Elevator::PassengerTracker::releasePassenger(uint32_t passengerSlot) {
+	nextPassengers[passengerSlot] = firstFreePassenger;
+	firstFreePassenger = passengerSlot;
+}
+
+//Adds a passenger waiting at their origin floor, to travel in the direction of their destination
+void Elevator::PassengerTracker::addPassenger(int originFloor, int destinationFloor, size_t tick) {
+	Passenger passenger = { originFloor, destinationFloor, tick, tick };
+	appendPassenger(waitingPassengers[destinationFloor > originFloor ? WAITING_UP_INDEX(originFloor) : WAITING_DOWN_INDEX(originFloor)], addToPool(passenger));
+	waitingPassengerCount++;
+}
+
+//Riders for the floor get off, then the waiting passengers whose call the shaft met get on.
+//The status is the same one passed to HallCallSet::callMet, so passengers board exactly when their call is cleared.
+const std::vector<int>& Elevator::PassengerTracker::floorServiced(size_t shaft, int floor, MovementStatus movementStatus, int shaftPosition, size_t tick) {
+	for (size_t i = 0; i < floorsToRequest.size(); i++) {
+		floorRequested[floorsToRequest[i]] = false;
+	}
+	floorsToRequest.clear();
+
+	//Unlink the riders for the floor, keeping the order of the others
+	PassengerList& riders = ridingPassengers[shaft];
+	uint32_t previousSlot = NO_PASSENGER;
+	uint32_t passengerSlot = riders.firstPassenger;
+	while (passengerSlot != NO_PASSENGER) {
+		uint32_t nextSlot = nextPassengers[passengerSlot];
+		if (passengerPool[passengerSlot].destinationFloor != floor) {
+			previousSlot = passengerSlot;
+			passengerSlot = nextSlot;
+			continue;
+		}
+
+		passengerArrived(passengerPool[passengerSlot], tick);
+		if (previousSlot == NO_PASSENGER) {
+			riders.firstPassenger = nextSlot;
+		}
+		else {
+			nextPassengers[previousSlot] = nextSlot;
+		}
+		if (riders.lastPassenger == passengerSlot) {
+			riders.lastPassenger = previousSlot;
+		}
+		riders.passengerCount--;
+		ridingPassengerCount--;
+		releasePassenger(passengerSlot);
+		passengerSlot = nextSlot;
+	}
+
+	if (movementStatus != MovementStatus::MovingDown) {
+		boardWaitingPassengers(waitingPassengers[WAITING_UP_INDEX(floor)], shaft, shaftPosition, tick);
+	}
+	if (movementStatus != MovementStatus::MovingUp) {
+		boardWaitingPassengers(waitingPassengers[WAITING_DOWN_INDEX(floor)], shaft, shaftPosition, tick);
+	}
+	return floorsToRequest;
+}
+
+//Moves waiting passengers onto a shaft, and adds their destinations to the floors to request, if they are not already there.
+//The passengers keep their slots, and are only relinked into the shaft's list.
+void Elevator::PassengerTracker::boardWaitingPassengers(PassengerList& waitingList, size_t shaft, int shaftPosition, size_t tick) {
+	uint32_t passengerSlot = waitingList.firstPassenger;
+	while (passengerSlot != NO_PASSENGER) {
+		uint32_t nextSlot = nextPassengers[passengerSlot];
+		Passenger& passenger = passengerPool[passengerSlot];
+		passenger.boardingTick = tick;
+		buildingWaitHistogram.record(tick - passenger.arrivalTick);
+		floorWaitHistograms[passenger.originFloor].record(tick - passenger.arrivalTick);
+
+		//The shaft has already moved on this tick. A request for its current floor would be ignored, so the passenger is already there.
+		if (passenger.destinationFloor == shaftPosition) {
+			passengerArrived(passenger, tick);
+			releasePassenger(passengerSlot);
+		}
+		else {
+			appendPassenger(ridingPassengers[shaft], passengerSlot);
+			ridingPassengerCount++;
+			//The stop set would ignore a second request for the same floor, so each destination is only returned once
+			if (!floorRequested[passenger.destinationFloor]) {
+				floorRequested[passenger.destinationFloor] = true;
+				floorsToRequest.push_back(passenger.destinationFloor);
+			}
+		}
+		passengerSlot = nextSlot;
+	}
+
+	waitingPassengerCount -= waitingList.passengerCount;
+	PassengerList emptyList = { NO_PASSENGER, NO_PASSENGER, 0 };
+	waitingList = emptyList;
+}
+
+void Elevator::PassengerTracker::passengerArrived(const Passenger& passenger, size_t tick) {
+	buildingJourneyHistogram.record(tick - passenger.arrivalTick);
+	floorJourneyHistograms[passenger.originFloor].record(tick - passenger.arrivalTick);
+}
+
+//Removes every passenger, and clears the histograms. The pool's storage is kept.
+void Elevator::PassengerTracker::clear() {
+	PassengerList emptyList = { NO_PASSENGER, NO_PASSENGER, 0 };
+	std::fill(waitingPassengers.begin(), waitingPassengers.end(), emptyList);
+	std::fill(ridingPassengers.begin(), ridingPassengers.end(), emptyList);
+	passengerPool.clear();
+	nextPassengers.clear();
+	firstFreePassenger = NO_PASSENGER;
+	waitingPassengerCount = 0;
+	ridingPassengerCount = 0;
+
+	buildingWaitHistogram.clear();
+	buildingJourneyHistogram.clear();
+	for (size_t i = 0; i < floorWaitHistograms.size(); i++) {
+		floorWaitHistograms[i].clear();
+		floorJourneyHistograms[i].clear();
+	}
+}
+
+//Passengers are plain values, so each list is its size followed by the bytes of each passenger in order.
+//Each passenger is a multiple of 8 bytes, so this is the same as writing the list as one block.
+void Elevator::PassengerTracker::savePassengers(SimulationCheckpoint& checkpoint, const PassengerList& passengerList) const {
+	static_assert(sizeof(Passenger) % 8 == 0, "Passengers written one at a time must not be padded");
+	checkpoint.write(static_cast<uint64_t>(passengerList.passengerCount));
+	for (uint32_t passengerSlot = passengerList.firstPassenger; passengerSlot != NO_PASSENGER; passengerSlot = nextPassengers[passengerSlot]) {
+		checkpoint.writeBytes(&passengerPool[passengerSlot], sizeof(Passenger));
+	}
+}
+
+//Adds the passengers to the pool, which clear() emptied but kept the storage of, so restoring the same checkpoint again does not allocate
+bool Elevator::PassengerTracker::restorePassengers(SimulationCheckpoint& checkpoint, PassengerList& passengerList) {
+	uint64_t passengerCount;
+	if (!checkpoint.read(passengerCount)) {
+		return false;
+	}
+	if (passengerCount == 0) {
+		return true;
+	}
+
+	const char* source = static_cast<const char*>(checkpoint.readBytes(static_cast<size_t>(passengerCount) * sizeof(Passenger)));
+	if (source == nullptr) {
+		return false;
+	}
+	for (size_t i = 0; i < passengerCount; i++) {
+		Passenger passenger;
+		std::memcpy(&passenger, source + i * sizeof(Passenger), sizeof(Passenger));
+		appendPassenger(passengerList, addToPool(passenger));
+	}
+	return true;
+}
+
+void Elevator::PassengerTracker::saveCheckpoint(SimulationCheckpoint& checkpoint) const {
+	for (size_t i = 0; i < waitingPassengers.size(); i++) {
+		savePassengers(checkpoint, waitingPassengers[i]);
+	}
+	for (size_t i = 0; i < ridingPassengers.size(); i++) {
+		savePassengers(checkpoint, ridingPassengers[i]);
+	}
+}
+
+//The passengers' floors are used as indexes into the lists and histograms, so a corrupt checkpoint is caught here, before anything is restored
+bool Elevator::PassengerTracker::canRestoreCheckpoint(SimulationCheckpoint& checkpoint, size_t tick) const {
+	size_t passengerTotal = 0;
+	for (size_t i = 0; i < waitingPassengers.size() + ridingPassengers.size(); i++) {
+		uint64_t passengerCount;
+		if (!checkpoint.read(passengerCount) || passengerCount > checkpoint.remainingSize() / sizeof(Passenger)) {
+			return false;
+		}
+		passengerTotal += static_cast<size_t>(passengerCount);
+		if (passengerTotal >= NO_PASSENGER) {
+			return false;
+		}
+
+		const char* source = static_cast<const char*>(checkpoint.readBytes(static_cast<size_t>(passengerCount) * sizeof(Passenger)));
+		for (size_t j = 0; j < passengerCount; j++) {
+			Passenger passenger;
+			std::memcpy(&passenger, source + j * sizeof(Passenger), sizeof(Passenger));
+			if (!isValidPassenger(passenger, i, tick)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+//A waiting passenger must be in the list for their origin floor and direction. Boarding is no earlier than the call, and neither is after the tick.
+bool Elevator::PassengerTracker::isValidPassenger(const Passenger& passenger, size_t listIndex, size_t tick) const {
+	int numberOfFloors = static_cast<int>(floorWaitHistograms.size());
+	if (passenger.originFloor < 0 || passenger.originFloor >= numberOfFloors || passenger.destinationFloor < 0 || passenger.destinationFloor >= numberOfFloors
+		|| passenger.originFloor == passenger.destinationFloor || passenger.arrivalTick > passenger.boardingTick || passenger.boardingTick > tick) {
+		return false;
+	}
+	if (listIndex < waitingPassengers.size()) {
+		bool goingUp = passenger.destinationFloor > passenger.originFloor;
+		return listIndex == static_cast<size_t>(goingUp ? WAITING_UP_INDEX(passenger.originFloor) : WAITING_DOWN_INDEX(passenger.originFloor));
+	}
+	return true;
+}
+
+bool Elevator::PassengerTracker::restoreCheckpoint(SimulationCheckpoint& checkpoint) {
+	clear();
+	for (size_t i = 0; i < waitingPassengers.size(); i++) {
+		if (!restorePassengers(checkpoint, waitingPassengers[i])) {
+			clear();
+			return false;
+		}
+		waitingPassengerCount += waitingPassengers[i].passengerCount;
+	}
+	for (size_t i = 0; i < ridingPassengers.size(); i++) {
+		if (!restorePassengers(checkpoint, ridingPassengers[i])) {
+			clear();
+			return false;
+		}
+		ridingPassengerCount += ridingPassengers[i].passengerCount;
+	}
+	return true;
+}
+
+void Elevator::PassengerTracker::printHistogramRow(std::ostream& outStream, const char* label, const LatencyHistogram& latencyHistogram) {
+	outStream << std::setw(10) << label
+		<< std::setw(10) << latencyHistogram.getCount()
+		<< std::setw(8) << latencyHistogram.getPercentile(50)
+		<< std::setw(8) << latencyHistogram.getPercentile(90)
+		<< std::setw(8) << latencyHistogram.getPercentile(99)
+		<< std::setw(8) << latencyHistogram.getMaximum() << std::endl;
+}
+
+//Prints the wait and journey percentiles, in ticks, for the building and then for each origin floor that has had passengers.
+//Floors are printed 1 based, matching the commands.
+void Elevator::PassengerTracker::printStatistics(std::ostream& outStream) const {
+	outStream << "Passengers waiting: " << waitingPassengerCount << ", riding: " << ridingPassengerCount << std::endl;
+	outStream << std::setw(10) << "Floor" << std::setw(10) << "Count" << std::setw(8) << "p50" << std::setw(8) << "p90"
+		<< std::setw(8) << "p99" << std::setw(8) << "Max" << std::endl;
+
+	outStream << "Wait ticks:" << std::endl;
+	printHistogramRow(outStream, "All", buildingWaitHistogram);
+	for (size_t i = 0; i < floorWaitHistograms.size(); i++) {
+		if (floorWaitHistograms[i].getCount() > 0) {
+			printHistogramRow(outStream, std::to_string(i + 1).c_str(), floorWaitHistograms[i]);
+		}
+	}
+
+	outStream << "Journey ticks:" << std::endl;
+	printHistogramRow(outStream, "All", buildingJourneyHistogram);
+	for (size_t i = 0; i < floorJourneyHistograms.size(); i++) {
+		if (floorJourneyHistograms[i].getCount() > 0) {
+			printHistogramRow(outStream, std::to_string(i + 1).c_str(), floorJourneyHistograms[i]);
+		}
+	}
+}
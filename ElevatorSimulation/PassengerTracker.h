@@ -0,0 +1,108 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include "ElevatorState.h"
+#include "LatencyHistogram.h"
+#include "SimulationCheckpoint.h"
+
+namespace Elevator {
+
+	//A passenger from the moment they call an elevator, until they arrive at their destination
+	struct Passenger {
+		int originFloor;
+		int destinationFloor;
+		size_t arrivalTick;			//When the passenger called the elevator
+		size_t boardingTick;		//When an elevator serviced their call
+	};
+
+	//Follows each passenger from their hall call, to boarding the elevator that meets the call, to arriving at their destination.
+	//Wait time is from the call to boarding, and journey time is from the call to the destination.
+	//Both go into histograms for the building and for each origin floor. Only passengers still travelling are stored.
+	//Every waiting and riding passenger lives in one pool, linked into a list per floor and direction or per shaft. A passenger's slot is
+	//reused once they arrive, so the pool stops growing once it holds the most passengers travelling at once, whichever floors they are on.
+	class PassengerTracker {
+		public:
+			PassengerTracker(int numberOfFloors, int numberOfShafts);
+
+			void addPassenger(int originFloor, int destinationFloor, size_t tick);	//Adds a passenger waiting at their origin floor
+			bool hasPassengers() const;									//Returns true if any passenger is waiting or riding
+
+			//Called when a shaft services a floor. Riders for the floor get off, and passengers waiting in the direction of the
+			//movement status (or both directions when waiting) get on. Returns the destinations the shaft needs to request.
+			//Passengers whose destination is where the shaft already is arrive straight away.
+			const std::vector<int>& floorServiced(size_t shaft, int floor, MovementStatus movementStatus, int shaftPosition, size_t tick);
+
+			void clear();												//Removes every passenger, and clears the histograms
+			void saveCheckpoint(SimulationCheckpoint& checkpoint) const;	//Appends the waiting and riding passengers
+			//Reads past the passengers in the checkpoint without restoring them. Returns false if it ends early, or if any passenger
+			//is on a floor outside the building, in the wrong list for their floors, or has times after the checkpoint's tick.
+			bool canRestoreCheckpoint(SimulationCheckpoint& checkpoint, size_t tick) const;
+			//Replaces the passengers with those in the checkpoint, and clears the histograms, so they only cover what happens after the restore.
+			//The checkpoint must have passed canRestoreCheckpoint. Returns false if it ends early, leaving no passengers.
+			bool restoreCheckpoint(SimulationCheckpoint& checkpoint);
+			void printStatistics(std::ostream& outStream) const;		//Prints the percentiles for the building, then each floor with passengers
+
+			const LatencyHistogram& getBuildingWaitHistogram() const;
+			const LatencyHistogram& getBuildingJourneyHistogram() const;
+			size_t getWaitingPassengerCount() const;
+			size_t getRidingPassengerCount() const;
+
+		private:
+			//A list of passengers in the pool, in the order they were added
+			struct PassengerList {
+				uint32_t firstPassenger;
+				uint32_t lastPassenger;
+				size_t passengerCount;
+			};
+
+			static const uint32_t NO_PASSENGER = 0xFFFFFFFF;			//Ends a list, and the free slots
+
+			uint32_t addToPool(const Passenger& passenger);				//Stores a passenger in a free slot, and returns the slot
+			void appendPassenger(PassengerList& passengerList, uint32_t passengerSlot);
+			void releasePassenger(uint32_t passengerSlot);				//Frees a passenger's slot, for the next passenger
+			void boardWaitingPassengers(PassengerList& waitingList, size_t shaft, int shaftPosition, size_t tick);
+			void passengerArrived(const Passenger& passenger, size_t tick);
+			void savePassengers(SimulationCheckpoint& checkpoint, const PassengerList& passengerList) const;
+			bool restorePassengers(SimulationCheckpoint& checkpoint, PassengerList& passengerList);
+			bool isValidPassenger(const Passenger& passenger, size_t listIndex, size_t tick) const;	//listIndex counts the waiting lists, then the riding lists
+			static void printHistogramRow(std::ostream& outStream, const char* label, const LatencyHistogram& latencyHistogram);
+
+			std::vector<Passenger> passengerPool;						//Every waiting and riding passenger, and the free slots
+			std::vector<uint32_t> nextPassengers;						//The next slot in the same list, for each slot in the pool
+			uint32_t firstFreePassenger;
+			std::vector<PassengerList> waitingPassengers;				//Two per floor, up then down
+			std::vector<PassengerList> ridingPassengers;				//One per shaft
+			std::vector<int> floorsToRequest;							//Returned by floorServiced. Each floor is in it at most once, so it never outgrows its reserve.
+			std::vector<char> floorRequested;							//True for the floors in floorsToRequest, by floor
+			size_t waitingPassengerCount;
+			size_t ridingPassengerCount;
+
+			LatencyHistogram buildingWaitHistogram;
+			LatencyHistogram buildingJourneyHistogram;
+			std::vector<LatencyHistogram> floorWaitHistograms;			//By origin floor
+			std::vector<LatencyHistogram> floorJourneyHistograms;
+	};
+
+	//Inline member functions
+
+	inline bool PassengerTracker::hasPassengers() const {
+		return waitingPassengerCount + ridingPassengerCount > 0;
+	}
+
+	inline const LatencyHistogram& PassengerTracker::getBuildingWaitHistogram() const {
+		return buildingWaitHistogram;
+	}
+
+	inline const LatencyHistogram& PassengerTracker::getBuildingJourneyHistogram() const {
+		return buildingJourneyHistogram;
+	}
+
+	inline size_t PassengerTracker::getWaitingPassengerCount() const {
+		return waitingPassengerCount;
+	}
+
+	inline size_t PassengerTracker::getRidingPassengerCount() const {
+		return ridingPassengerCount;
+	}
+}
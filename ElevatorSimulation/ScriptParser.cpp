@@ -0,0 +1,150 @@
+#include "stdafx.h"
+#include "ScriptParser.h"
+#include <limits>
+
+#define SCRIPT_COMMENT_CHARACTER '#'
+#define INT_MAXIMUM_DIGITS 10
+
+
+//Builds the command table from the same command strings as the interactive input
+ScriptParser::ScriptParser() {
+	for (size_t i = 0; i < COMMAND_TABLE_SIZE; i++) {
+		commandTable[i].name = nullptr;
+		commandTable[i].nameLength = 0;
+		commandTable[i].commandType = ScriptCommandType::Exit;
+	}
+
+	addCommand(CALL_COMMAND, ScriptCommandType::Call);
+	addCommand(REQUEST_FLOOR_COMMAND, ScriptCommandType::RequestFloor);
+	addCommand(PASSENGER_COMMAND, ScriptCommandType::Passenger);
+	addCommand(TICK_COMMAND, ScriptCommandType::Tick);
+	addCommand(STATS_COMMAND, ScriptCommandType::Stats);
+	addCommand(SAVE_COMMAND, ScriptCommandType::Save);
+	addCommand(RESTORE_COMMAND, ScriptCommandType::Restore);
+	addCommand(EXIT_COMMAND, ScriptCommandType::Exit);
+}
+
+//Adds a command to the first free slot from its hash onwards
+void ScriptParser::addCommand(const char* name, ScriptCommandType commandType) {
+	size_t nameLength = std::strlen(name);
+	size_t slot = hashCommandName(name, nameLength);
+	while (commandTable[slot].name != nullptr) {
+		slot = (slot + 1) & (COMMAND_TABLE_SIZE - 1);
+	}
+	commandTable[slot].name = name;
+	commandTable[slot].nameLength = nameLength;
+	commandTable[slot].commandType = commandType;
+}
+
+//The names are a few characters long, so comparing them in a loop beats a call to memcmp
+static bool commandNameEquals(const char* name, size_t nameLength, const TokenView& token) {
+	if (token.length != nameLength) {
+		return false;
+	}
+	for (size_t i = 0; i < nameLength; i++) {
+		if (name[i] != token.begin[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//Probes from the token's hash until the command or an empty slot is found
+bool ScriptParser::findCommand(const TokenView& token, ScriptCommandType& commandType) const {
+	size_t slot = hashCommandName(token.begin, token.length);
+	while (commandTable[slot].name != nullptr) {
+		if (commandNameEquals(commandTable[slot].name, commandTable[slot].nameLength, token)) {
+			commandType = commandTable[slot].commandType;
+			return true;
+		}
+		slot = (slot + 1) & (COMMAND_TABLE_SIZE - 1);
+	}
+	return false;
+}
+
+//Reads the next token as decimal digits, with an optional minus sign, converting it as the digits are found rather than finding the end of the token first
+bool ScriptParser::parseIntArgument(const char*& position, const char* lineEnd, int& value) {
+	if (isAtLineEnd(position, lineEnd)) {
+		return false;
+	}
+
+	bool negative = *position == '-';
+	if (negative) {
+		position++;
+	}
+
+	//At most 10 digits fit in an int, so the value cannot overflow before the range check
+	const char* digitsBegin = position;
+	const char* digitsLimit = lineEnd - position > INT_MAXIMUM_DIGITS ? position + INT_MAXIMUM_DIGITS : lineEnd;
+	long long parsedValue = 0;
+	for (; position < digitsLimit; position++) {
+		unsigned int digit = static_cast<unsigned int>(*position - '0');
+		if (digit > 9) {
+			break;
+		}
+		parsedValue = parsedValue * 10 + digit;
+	}
+
+	//The token must be digits all the way to the next separator
+	if (position == digitsBegin || (position < lineEnd && !isTokenSeparator(*position))) {
+		return false;
+	}
+
+	parsedValue = negative ? -parsedValue : parsedValue;
+	if (parsedValue < std::numeric_limits<int>::min() || parsedValue > std::numeric_limits<int>::max()) {
+		return false;
+	}
+	value = static_cast<int>(parsedValue);
+	return true;
+}
+
+//Parses a single line of a script, in the same form as the interactive commands, e.g. Call 10 Down.
+//Unlike the interactive input, anything after the last argument makes the line malformed.
+ScriptLineType ScriptParser::parseLine(const char* lineBegin, const char* lineEnd, ScriptCommand& scriptCommand) const {
+	const char* position = lineBegin;
+	TokenView commandToken;
+	if (!nextToken(position, lineEnd, commandToken) || commandToken.begin[0] == SCRIPT_COMMENT_CHARACTER) {
+		return ScriptLineType::Blank;
+	}
+	if (!findCommand(commandToken, scriptCommand.commandType)) {
+		return ScriptLineType::Malformed;
+	}
+
+	//Each argument is read straight from the line, in the form the command expects, and then the rest of the line must be empty
+	TokenView directionToken;
+	bool parsed = false;
+	switch (scriptCommand.commandType) {
+	case ScriptCommandType::Call:
+		if (parseIntArgument(position, lineEnd, scriptCommand.firstArgument) && nextToken(position, lineEnd, directionToken) && isAtLineEnd(position, lineEnd)) {
+			if (directionToken.equals(CALL_DIRECTION_UP, sizeof(CALL_DIRECTION_UP) - 1)) {
+				scriptCommand.direction = Elevator::MovementDirection::Up;
+				parsed = true;
+			}
+			else if (directionToken.equals(CALL_DIRECTION_DOWN, sizeof(CALL_DIRECTION_DOWN) - 1)) {
+				scriptCommand.direction = Elevator::MovementDirection::Down;
+				parsed = true;
+			}
+		}
+		break;
+	case ScriptCommandType::RequestFloor:
+	case ScriptCommandType::Passenger:
+		parsed = parseIntArgument(position, lineEnd, scriptCommand.firstArgument) && parseIntArgument(position, lineEnd, scriptCommand.secondArgument)
+			&& isAtLineEnd(position, lineEnd);
+		break;
+	case ScriptCommandType::Tick:
+		//Default of 1 tick if no number is given
+		scriptCommand.firstArgument = 1;
+		parsed = isAtLineEnd(position, lineEnd)
+			|| (parseIntArgument(position, lineEnd, scriptCommand.firstArgument) && scriptCommand.firstArgument >= 0 && isAtLineEnd(position, lineEnd));
+		break;
+	case ScriptCommandType::Save:
+	case ScriptCommandType::Restore:
+		parsed = nextToken(position, lineEnd, scriptCommand.pathArgument) && isAtLineEnd(position, lineEnd);
+		break;
+	case ScriptCommandType::Stats:
+	case ScriptCommandType::Exit:
+		parsed = isAtLineEnd(position, lineEnd);
+		break;
+	}
+	return parsed ? ScriptLineType::Command : ScriptLineType::Malformed;
+}
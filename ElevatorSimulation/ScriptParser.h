@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "ElevatorState.h"
+#include "SimulationCommands.h"
+
+//A run of characters inside a buffer, pointing into it rather than copying it out.
+//The project targets C++14, so this stands in for std::string_view.
+struct TokenView {
+	const char* begin;
+	size_t length;
+
+	bool equals(const char* text, size_t textLength) const;
+	std::string toString() const;
+};
+
+//The commands a script can contain. These are the interactive commands, except the ones that control a paced run.
+enum class ScriptCommandType : uint8_t {
+	Call,
+	RequestFloor,
+	Passenger,
+	Tick,
+	Stats,
+	Save,
+	Restore,
+	Exit
+};
+
+//A parsed script line. Arguments are as written, so floors are still 1 based.
+struct ScriptCommand {
+	ScriptCommandType commandType;
+	int firstArgument;						//Floor for Call, shaft for RequestFloor, origin floor for Passenger, ticks for Tick
+	int secondArgument;						//Floor for RequestFloor, destination floor for Passenger
+	Elevator::MovementDirection direction;	//Only used for Call
+	TokenView pathArgument;					//Only used for Save and Restore, points into the script
+};
+
+enum class ScriptLineType {
+	Command,
+	Blank,									//Empty, only whitespace, or a comment starting with #
+	Malformed
+};
+
+//Parses script lines straight out of a buffer. Nothing is allocated per line: tokens point into the buffer,
+//numbers are converted as they are read, in the same pass that finds their end, and the command is found in a small hash table built once from the command strings.
+class ScriptParser
+{
+	public:
+		ScriptParser();
+
+		ScriptLineType parseLine(const char* lineBegin, const char* lineEnd, ScriptCommand& scriptCommand) const;	//lineEnd is one past the last character, excluding the newline
+
+		static bool nextToken(const char*& position, const char* lineEnd, TokenView& token);	//Skips spaces, tabs and carriage returns. Returns false if there are no more tokens.
+		static bool parseIntArgument(const char*& position, const char* lineEnd, int& value);	//Reads the next token as a number. Returns false unless the whole token is a number that fits in an int.
+		static bool isAtLineEnd(const char*& position, const char* lineEnd);					//Skips spaces, tabs and carriage returns. Returns true if nothing else is left.
+
+	private:
+		struct CommandTableEntry {
+			const char* name;				//nullptr for an empty slot
+			size_t nameLength;
+			ScriptCommandType commandType;
+		};
+
+		void addCommand(const char* name, ScriptCommandType commandType);
+		bool findCommand(const TokenView& token, ScriptCommandType& commandType) const;
+		static size_t hashCommandName(const char* name, size_t nameLength);
+
+		static const size_t COMMAND_TABLE_SIZE = 32;	//A power of two, several times the number of commands so most lookups hit on the first slot
+		CommandTableEntry commandTable[COMMAND_TABLE_SIZE];
+};
+
+//Inline member functions
+
+inline bool TokenView::equals(const char* text, size_t textLength) const {
+	return length == textLength && std::memcmp(begin, text, length) == 0;
+}
+
+inline std::string TokenView::toString() const {
+	return std::string(begin, length);
+}
+
+//Spaces, tabs and carriage returns separate the tokens
+inline bool isTokenSeparator(char character) {
+	return character == ' ' || character == '\t' || character == '\r';
+}
+
+inline bool ScriptParser::isAtLineEnd(const char*& position, const char* lineEnd) {
+	while (position < lineEnd && isTokenSeparator(*position)) {
+		position++;
+	}
+	return position == lineEnd;
+}
+
+inline bool ScriptParser::nextToken(const char*& position, const char* lineEnd, TokenView& token) {
+	if (isAtLineEnd(position, lineEnd)) {
+		return false;
+	}
+
+	token.begin = position;
+	while (position < lineEnd && !isTokenSeparator(*position)) {
+		position++;
+	}
+	token.length = static_cast<size_t>(position - token.begin);
+	return true;
+}
+
+//The name's length and its first and last characters are enough to tell the commands apart, and cheap to read
+inline size_t ScriptParser::hashCommandName(const char* name, size_t nameLength) {
+	return (nameLength * 7 + static_cast<unsigned char>(name[0]) * 3 + static_cast<unsigned char>(name[nameLength - 1])) & (COMMAND_TABLE_SIZE - 1);
+}
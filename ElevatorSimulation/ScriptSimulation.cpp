@@ -0,0 +1,164 @@
+#include "stdafx.h"
+#include "ScriptSimulation.h"
+#include <cstring>
+
+#define MAXIMUM_REPORTED_LINES 20		//Lines printed for each kind of problem, so a bad multi-million line script does not flood the console
+
+
+ScriptSimulation::ScriptSimulation(Elevator::ElevatorController* elevatorControllerPtr) :
+	elevatorControllerPtr(elevatorControllerPtr),
+	linesParsed(0),
+	malformedLines(0),
+	parseTime(0),
+	ticksRun(0),
+	commandsExecuted(0),
+	commandsRejected(0),
+	elapsedTime(0)
+{
+	//Nobody is watching a script run, so skip the display and the wait between ticks
+	elevatorControllerPtr->setDisplayEnabled(false);
+}
+
+bool ScriptSimulation::loadScript(const std::string& scriptPath) {
+	if (!scriptFile.open(scriptPath)) {
+		std::cerr << "Unable to open script file: " << scriptPath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+//Parses every line before anything is run, so a script with a mistake near its end does not run half way
+bool ScriptSimulation::checkScript() {
+	linesParsed = 0;
+	malformedLines = 0;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	const char* scriptData = reinterpret_cast<const char*>(scriptFile.getData());
+	const char* scriptEnd = scriptData + scriptFile.getSize();
+	ScriptCommand scriptCommand;
+	for (const char* lineBegin = scriptData; lineBegin < scriptEnd; ) {
+		const char* lineEnd = static_cast<const char*>(std::memchr(lineBegin, '\n', scriptEnd - lineBegin));
+		lineEnd = lineEnd ? lineEnd : scriptEnd;
+		linesParsed++;
+
+		if (scriptParser.parseLine(lineBegin, lineEnd, scriptCommand) == ScriptLineType::Malformed) {
+			if (malformedLines < MAXIMUM_REPORTED_LINES) {
+				std::cerr << "Invalid script command on line " << linesParsed << ": " << std::string(lineBegin, lineEnd) << std::endl;
+			}
+			malformedLines++;
+		}
+		lineBegin = lineEnd + 1;
+	}
+
+	parseTime = std::chrono::steady_clock::now() - startTime;
+	if (malformedLines > MAXIMUM_REPORTED_LINES) {
+		std::cerr << "... and " << malformedLines - MAXIMUM_REPORTED_LINES << " more invalid lines." << std::endl;
+	}
+	return malformedLines == 0;
+}
+
+//Executes a script command against the controller, after validating the arguments.
+//Floors are 1 based in the script, matching the interactive commands.
+bool ScriptSimulation::executeCommand(const ScriptCommand& scriptCommand) {
+	switch (scriptCommand.commandType) {
+	case ScriptCommandType::Call:
+		if (!elevatorControllerPtr->isValidFloorNumber(scriptCommand.firstArgument - 1)) {
+			return false;
+		}
+		elevatorControllerPtr->callElevator(scriptCommand.firstArgument - 1, scriptCommand.direction);
+		return true;
+	case ScriptCommandType::RequestFloor:
+		if (!elevatorControllerPtr->isValidShaftNumber(scriptCommand.firstArgument)
+			|| !elevatorControllerPtr->isValidFloorNumber(scriptCommand.secondArgument - 1)) {
+			return false;
+		}
+		elevatorControllerPtr->requestFloor(scriptCommand.firstArgument, scriptCommand.secondArgument - 1);
+		return true;
+	case ScriptCommandType::Passenger:
+		if (!elevatorControllerPtr->isValidFloorNumber(scriptCommand.firstArgument - 1)
+			|| !elevatorControllerPtr->isValidFloorNumber(scriptCommand.secondArgument - 1)
+			|| scriptCommand.firstArgument == scriptCommand.secondArgument) {
+			return false;
+		}
+		elevatorControllerPtr->addPassenger(scriptCommand.firstArgument - 1, scriptCommand.secondArgument - 1);
+		return true;
+	case ScriptCommandType::Tick:
+		elevatorControllerPtr->simulationTick(static_cast<size_t>(scriptCommand.firstArgument));
+		ticksRun += scriptCommand.firstArgument;
+		return true;
+	case ScriptCommandType::Stats:
+		elevatorControllerPtr->getPassengerTracker().printStatistics(std::cout);
+		return true;
+	case ScriptCommandType::Save:
+	case ScriptCommandType::Restore: {
+		Elevator::SimulationCheckpoint checkpoint;
+		if (scriptCommand.commandType == ScriptCommandType::Save) {
+			elevatorControllerPtr->saveCheckpoint(checkpoint);
+			return checkpoint.saveToFile(scriptCommand.pathArgument.toString());
+		}
+		return checkpoint.loadFromFile(scriptCommand.pathArgument.toString()) && elevatorControllerPtr->restoreCheckpoint(checkpoint);
+	}
+	default:
+		return true;
+	}
+}
+
+//Runs the script from the start. Malformed lines are skipped, though checkScript should have rejected the script first.
+void ScriptSimulation::run() {
+	ticksRun = 0;
+	commandsExecuted = 0;
+	commandsRejected = 0;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	const char* scriptData = reinterpret_cast<const char*>(scriptFile.getData());
+	const char* scriptEnd = scriptData + scriptFile.getSize();
+	ScriptCommand scriptCommand;
+	size_t lineNumber = 0;
+	for (const char* lineBegin = scriptData; lineBegin < scriptEnd; ) {
+		const char* lineEnd = static_cast<const char*>(std::memchr(lineBegin, '\n', scriptEnd - lineBegin));
+		lineEnd = lineEnd ? lineEnd : scriptEnd;
+		lineNumber++;
+		const char* nextLineBegin = lineEnd + 1;
+
+		if (scriptParser.parseLine(lineBegin, lineEnd, scriptCommand) == ScriptLineType::Command) {
+			if (scriptCommand.commandType == ScriptCommandType::Exit) {
+				break;
+			}
+
+			if (executeCommand(scriptCommand)) {
+				commandsExecuted++;
+			}
+			else {
+				if (commandsRejected < MAXIMUM_REPORTED_LINES) {
+					std::cerr << "Rejected script command on line " << lineNumber << ": " << std::string(lineBegin, lineEnd) << std::endl;
+				}
+				commandsRejected++;
+			}
+		}
+		lineBegin = nextLineBegin;
+	}
+
+	elapsedTime = std::chrono::steady_clock::now() - startTime;
+}
+
+//Prints the results of the last check and run
+void ScriptSimulation::printSummary(std::ostream& outStream) const {
+	const Elevator::SimulationSettings& simulationSettings = elevatorControllerPtr->getCurrentState().simulationSettings;
+	double parseSeconds = parseTime.count();
+	double scriptMegabytes = scriptFile.getSize() / (1024.0 * 1024.0);
+	double elapsedSeconds = elapsedTime.count();
+
+	outStream << "Script run complete." << std::endl;
+	outStream << "Floors: " << simulationSettings.numberOfFloors << ", Shafts: " << simulationSettings.numberOfShafts
+		<< ", Dispatch: " << Elevator::getDispatchPolicyName(simulationSettings.dispatchPolicy) << std::endl;
+	outStream << "Lines: " << linesParsed << ", parsed at " << (parseSeconds > 0 ? scriptMegabytes / parseSeconds : 0) << " MB/s" << std::endl;
+	outStream << "Commands executed: " << commandsExecuted << " (" << commandsRejected << " rejected)" << std::endl;
+	outStream << "Ticks: " << ticksRun << std::endl;
+	outStream << "Elapsed seconds: " << elapsedSeconds << std::endl;
+	outStream << "Ticks per second: " << (elapsedSeconds > 0 ? ticksRun / elapsedSeconds : 0) << std::endl;
+
+	const Elevator::PassengerTracker& passengerTracker = elevatorControllerPtr->getPassengerTracker();
+	if (passengerTracker.hasPassengers() || passengerTracker.getBuildingWaitHistogram().getCount() > 0) {
+		passengerTracker.printStatistics(outStream);
+	}
+}
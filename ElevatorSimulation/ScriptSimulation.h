@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <iostream>
+#include <chrono>
+#include "ElevatorState.h"
+#include "ElevatorController.h"
+#include "MappedFile.h"
+#include "ScriptParser.h"
+
+//Runs a script of interactive commands headless, for scripts too long to type or to pipe through the interactive input.
+//The script is memory mapped and parsed in place, one command per line:
+//	Call 10 Down
+//	Tick 12
+//	RequestFloor 0 2
+//Tick runs its ticks back to back, and Exit ends the script early. Empty lines, and lines starting with # are ignored.
+class ScriptSimulation
+{
+	public:
+		ScriptSimulation(Elevator::ElevatorController* elevatorControllerPtr);
+
+		bool loadScript(const std::string& scriptPath);		//Maps the script. Returns false if it could not be opened.
+		bool checkScript();									//Parses every line without running it, printing each malformed line. Returns false if there were any.
+		void run();											//Runs the script until its end, or an Exit command
+		void printSummary(std::ostream& outStream) const;	//Prints the results of the last check and run
+
+	private:
+		bool executeCommand(const ScriptCommand& scriptCommand);	//Returns false if the arguments are out of range
+
+		Elevator::ElevatorController* elevatorControllerPtr;
+		Elevator::MappedFile scriptFile;
+		ScriptParser scriptParser;
+
+		//Results of the last check and run
+		size_t linesParsed;
+		size_t malformedLines;
+		std::chrono::duration<double> parseTime;
+		size_t ticksRun;
+		size_t commandsExecuted;
+		size_t commandsRejected;
+		std::chrono::duration<double> elapsedTime;
+};
@@ -1,2 +1,4 @@
 #include "stdafx.h"
-#include "SimState.h"
\ No newline at end of file
+#include "SimState.h"
+
+std::atomic<size_t> Elevator::StateCopyCounter::copyCount(0);
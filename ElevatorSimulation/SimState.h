@@ -1,5 +1,7 @@
 #pragma once
 #include "ElevatorShaft.h"
+#include "HallCallSet.h"
+#include <type_traits>
 
 namespace Elevator {
 	//Core state for representing all of the floors and elevators
@@ -7,6 +9,11 @@ namespace Elevator {
 	struct SimulationState {
 		std::vector<ElevatorShaft> elevatorShaftVector;
 		std::vector<Floor>floorsVector;
+		HallCallSet hallCalls;				//The up and down call buttons of every floor
 		SimulationSettings simulationSettings;
+		StateCopyCounter copyCounter;
 	};
+
+	//Growing the shaft vector must move the shafts, or it would count as copies of the state
+	static_assert(std::is_nothrow_move_constructible<ElevatorShaft>::value, "ElevatorShaft must be nothrow move constructible");
 }
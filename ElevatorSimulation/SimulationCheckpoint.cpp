@@ -0,0 +1,88 @@
+#include "stdafx.h"
+#include "SimulationCheckpoint.h"
+#include <fstream>
+#include <iostream>
+
+#define CHECKPOINT_ALIGNMENT 8
+
+//Rounds a number of bytes up to whole words
+static size_t paddedSize(size_t byteCount) {
+	return (byteCount + CHECKPOINT_ALIGNMENT - 1) / CHECKPOINT_ALIGNMENT * CHECKPOINT_ALIGNMENT;
+}
+
+
+Elevator::SimulationCheckpoint::SimulationCheckpoint() :
+	byteSize(0),
+	readPosition(0)
+{
+}
+
+//Empties the checkpoint. The storage is kept, so saving the same building again does not allocate.
+void Elevator::SimulationCheckpoint::clear() {
+	byteSize = 0;
+	readPosition = 0;
+}
+
+//Appends the bytes, padded with zeros to a multiple of 8 so the next value starts aligned
+void Elevator::SimulationCheckpoint::writeBytes(const void* source, size_t byteCount) {
+	size_t newSize = byteSize + paddedSize(byteCount);
+	if (newSize / CHECKPOINT_ALIGNMENT > data.size()) {
+		data.resize(newSize / CHECKPOINT_ALIGNMENT);
+	}
+
+	uint8_t* destination = reinterpret_cast<uint8_t*>(data.data()) + byteSize;
+	std::memcpy(destination, source, byteCount);
+	std::memset(destination + byteCount, 0, newSize - byteSize - byteCount);
+	byteSize = newSize;
+}
+
+//Returns the next bytes, and moves past them and their padding. Returns nullptr if the checkpoint ends first.
+const void* Elevator::SimulationCheckpoint::readBytes(size_t byteCount) {
+	size_t paddedCount = paddedSize(byteCount);
+	if (paddedCount > byteSize - readPosition) {
+		return nullptr;
+	}
+
+	const void* source = reinterpret_cast<const uint8_t*>(data.data()) + readPosition;
+	readPosition += paddedCount;
+	return source;
+}
+
+bool Elevator::SimulationCheckpoint::saveToFile(const std::string& checkpointPath) const {
+	std::ofstream checkpointFile(checkpointPath, std::ios::binary | std::ios::trunc);
+	if (!checkpointFile.is_open()) {
+		std::cerr << "Unable to create checkpoint file: " << checkpointPath << std::endl;
+		return false;
+	}
+	checkpointFile.write(reinterpret_cast<const char*>(data.data()), byteSize);
+	return !checkpointFile.fail();
+}
+
+//Reads the whole file with one read, straight into the checkpoint's storage
+bool Elevator::SimulationCheckpoint::loadFromFile(const std::string& checkpointPath) {
+	std::ifstream checkpointFile(checkpointPath, std::ios::binary | std::ios::ate);
+	if (!checkpointFile.is_open()) {
+		std::cerr << "Unable to open checkpoint file: " << checkpointPath << std::endl;
+		return false;
+	}
+
+	std::streamoff fileSize = checkpointFile.tellg();
+	if (fileSize < 0 || fileSize % CHECKPOINT_ALIGNMENT != 0) {
+		std::cerr << "Not a checkpoint file: " << checkpointPath << std::endl;
+		return false;
+	}
+
+	clear();
+	byteSize = static_cast<size_t>(fileSize);
+	if (byteSize / CHECKPOINT_ALIGNMENT > data.size()) {
+		data.resize(byteSize / CHECKPOINT_ALIGNMENT);
+	}
+	checkpointFile.seekg(0);
+	checkpointFile.read(reinterpret_cast<char*>(data.data()), byteSize);
+	if (checkpointFile.fail()) {
+		std::cerr << "Unable to read checkpoint file: " << checkpointPath << std::endl;
+		byteSize = 0;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <assert.h>
+
+namespace Elevator {
+
+	//A snapshot of the simulation, stored as one flat block of bytes, so it can be written to or read from a file in a single operation.
+	//The controller writes its state in with ElevatorController::saveCheckpoint, and reads it back with restoreCheckpoint.
+	//Every value is padded to 8 bytes, so the blocks of stop set words inside stay aligned.
+	//Saving again into the same checkpoint reuses its storage, so repeated saves and restores do not allocate.
+	//The layout is native to the machine, so a checkpoint file is only meant to be read on the machine that wrote it.
+	class SimulationCheckpoint {
+		public:
+			SimulationCheckpoint();
+
+			void clear();											//Empties the checkpoint, keeping its storage
+			void writeBytes(const void* source, size_t byteCount);	//Appends the bytes, padded to a multiple of 8
+			const void* readBytes(size_t byteCount);				//Returns the next bytes and skips past them, or nullptr if the checkpoint ends first
+			template<typename T> void write(const T& value);		//Appends a plain value
+			template<typename T> bool read(T& value);				//Reads the next plain value. Returns false if the checkpoint ends first.
+			void rewind();											//Reads start from the beginning again
+			size_t getReadPosition() const;							//Where the next read starts, to seek back to
+			void seek(size_t readPosition);							//Reads start from a position returned by getReadPosition
+			size_t size() const;									//Size in bytes
+			const void* getBytes() const;							//The whole checkpoint, size() bytes, e.g. to write it out
+			size_t remainingSize() const;							//Bytes left to read
+
+			bool saveToFile(const std::string& checkpointPath) const;	//Returns false, printing why, if the file could not be written
+			bool loadFromFile(const std::string& checkpointPath);		//Reads the whole file at once. Returns false, printing why, if it could not be read.
+
+		private:
+			std::vector<uint64_t> data;								//Stored as words, so the start of the data is 8 byte aligned
+			size_t byteSize;
+			size_t readPosition;
+	};
+
+	//Inline member functions
+
+	template<typename T> inline void SimulationCheckpoint::write(const T& value) {
+		writeBytes(&value, sizeof(T));
+	}
+
+	template<typename T> inline bool SimulationCheckpoint::read(T& value) {
+		const void* source = readBytes(sizeof(T));
+		if (source == nullptr) {
+			return false;
+		}
+		std::memcpy(&value, source, sizeof(T));
+		return true;
+	}
+
+	inline void SimulationCheckpoint::rewind() {
+		readPosition = 0;
+	}
+
+	inline size_t SimulationCheckpoint::getReadPosition() const {
+		return readPosition;
+	}
+
+	inline void SimulationCheckpoint::seek(size_t _readPosition) {
+		assert(_readPosition <= byteSize);
+		readPosition = _readPosition;
+	}
+
+	inline const void* SimulationCheckpoint::getBytes() const {
+		return data.data();
+	}
+
+	inline size_t SimulationCheckpoint::size() const {
+		return byteSize;
+	}
+
+	inline size_t SimulationCheckpoint::remainingSize() const {
+		return byteSize - readPosition;
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include "ElevatorState.h"
+
+//Define the command strings shared by the interactive input and the batch scenarios
+#define EXIT_COMMAND "Exit"
+#define CALL_COMMAND "Call"
+#define CALL_DIRECTION_UP "Up"
+#define CALL_DIRECTION_DOWN "Down"
+#define REQUEST_FLOOR_COMMAND "RequestFloor"
+#define TICK_COMMAND "Tick"
+#define PASSENGER_COMMAND "Passenger"
+#define STATS_COMMAND "Stats"
+#define SAVE_COMMAND "Save"
+#define RESTORE_COMMAND "Restore"
+
+//Only the interactive input controls multi-tick runs
+#define PAUSE_COMMAND "Pause"
+#define RESUME_COMMAND "Resume"
+#define STOP_COMMAND "Stop"
+#define SPEED_COMMAND "Speed"
+#define SPEED_UNPACED "Unpaced"
+
+//Parse the command direction of "Up" or "Down" into a MovementDirection, stored in direction if successfull.
+//Returns true if successful.
+inline bool commandStringToDirection(const std::string& directionString, Elevator::MovementDirection& direction) {
+	if (directionString == CALL_DIRECTION_UP) {
+		direction = Elevator::MovementDirection::Up;
+		return true;
+	}
+
+	if (directionString == CALL_DIRECTION_DOWN) {
+		direction = Elevator::MovementDirection::Down;
+		return true;
+	}
+
+	return false;
+}
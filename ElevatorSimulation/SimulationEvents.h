@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "ElevatorState.h"
+#include "SimState.h"
+
+namespace Elevator {
+
+	//The kinds of change the controller makes to the simulation state
+	enum class SimulationEventType : uint8_t {
+		ShaftMoved,			//A shaft moved to floor, from the floor in value
+		StatusChanged,		//A shaft's movement status changed to the MovementStatus in value
+		StopAdded,			//A floor was added to a shaft's stop sets
+		StopRemoved,		//A shaft stopped at a floor, removing it from its stop sets
+		CallSet,			//A floor started calling in the MovementDirection in value
+		CallCleared,		//A floor's call in the MovementDirection in value was met
+		StateReplaced		//Anything may have changed, e.g. a checkpoint was restored, so the whole state has to be read again
+	};
+
+	//A single change. Floor events leave the shaft unused.
+	struct SimulationEvent {
+		SimulationEventType eventType;
+		uint32_t shaft;
+		int32_t floor;
+		int32_t value;
+	};
+
+	//The changes made since the last batch, in the order they were made.
+	//A batch is published after each tick, and after each input, so a view can show a call as soon as it is made.
+	struct SimulationEventBatch {
+		size_t tick;						//The controller's tick when the batch was published
+		std::vector<SimulationEvent> simulationEvents;
+	};
+
+	//Receives each batch of changes. The state is passed as it is after the batch, for listeners that need more than the changes.
+	//Listeners are called on the thread that ticks the controller, and must not call back into it.
+	class SimulationEventListener {
+		public:
+			virtual ~SimulationEventListener() {}
+			virtual void simulationEventsPublished(const SimulationEventBatch& eventBatch, const SimulationState& simulationState) = 0;
+	};
+}
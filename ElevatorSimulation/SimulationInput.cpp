@@ -1,38 +1,24 @@
 #include "stdafx.h"
 #include "SimulationInput.h"
-
-//Define the command strings
-#define EXIT_COMMAND "Exit"
-#define CALL_COMMAND "Call"
-#define CALL_DIRECTION_UP "Up"
-#define CALL_DIRECTION_DOWN "Down"
-#define REQUEST_FLOOR_COMMAND "RequestFloor"
-#define TICK_COMMAND "Tick"
-
-SimulationInput::SimulationInput(Elevator::ElevatorController* elevatorControllerPtr) : elevatorControllerPtr(elevatorControllerPtr)
+#include "Tracing.h"
+
+#define COMMAND_QUEUE_CAPACITY 64
+#define TICK_INTERVAL std::chrono::seconds(1)			//How long each tick of a multi-tick run takes at a speed of 1, so the display can be watched
+#define INPUT_POLL_INTERVAL std::chrono::milliseconds(10)	//How often the queue is checked while waiting for the next tick or command
+
+SimulationInput::SimulationInput(Elevator::ElevatorController* elevatorControllerPtr) : 
+	elevatorControllerPtr(elevatorControllerPtr),
+	commandQueue(COMMAND_QUEUE_CAPACITY),
+	inputClosed(false),
+	ticksRemaining(0),
+	runPaused(false),
+	tickPacer(TICK_INTERVAL)
 {
 }
 SimulationInput::~SimulationInput()
 {
 }
 
-//Parse the command direction of "Up" or "Down" into a MovementDirection, stored in direction if successfull.
-//Returns true if successful.
-bool commandStringToDirection(std::string& directionString, Elevator::MovementDirection& direction) {
-	if (directionString == CALL_DIRECTION_UP) {
-		direction = Elevator::MovementDirection::Up;
-		return true;
-	}
-
-
-	if (directionString == CALL_DIRECTION_DOWN) {
-		direction = Elevator::MovementDirection::Down;
-		return true;
-	}
-
-	return false;
-}
-
 //Parse a string into a integer using an open string stream.
 //Returns true if successful
 bool SimulationInput::parseInt(std::istringstream& inStringStream, int& value) {
@@ -43,6 +29,7 @@ bool SimulationInput::parseInt(std::istringstream& inStringStream, int& value) {
 //Parses a given command, and attempts to parse the command arguments.
 //If the command was parsed successfuly, it executes it with the arguments.
 bool SimulationInput::parseAndExecuteCommand(std::istringstream& inStringStream, std::string& input, std::string& command) {
+	TRACE_SCOPE("parseAndExecuteCommand");
 	//Exit command is handled by the main input loop. Alternative would be to have this method return a function pointer to the relevant action with args filled out.
 	if (command == EXIT_COMMAND) {
 		return true;
@@ -57,15 +44,91 @@ bool SimulationInput::parseAndExecuteCommand(std::istringstream& inStringStream,
 
 		//Parse how many ticks
 		int tickCount;
-		if (!parseInt(inStringStream, tickCount)) {
+		if (!parseInt(inStringStream, tickCount) || tickCount < 0) {
 			return false;
 		}
 
-		//Command is valid
-		elevatorControllerPtr->simulationTick(tickCount);
+		//The ticks are run by the input loop, one per interval, so commands can still be given. A run that is already going is extended.
+		if (ticksRemaining == 0) {
+			tickPacer.start(std::chrono::steady_clock::now());
+		}
+		ticksRemaining += tickCount;
+		return true;
+	}
+
+	if (command == PAUSE_COMMAND) {
+		runPaused = true;
+		return true;
+	}
+
+	if (command == RESUME_COMMAND) {
+		if (runPaused) {
+			runPaused = false;
+			tickPacer.start(std::chrono::steady_clock::now());
+		}
+		return true;
+	}
+
+	if (command == STOP_COMMAND) {
+		ticksRemaining = 0;
+		runPaused = false;
 		return true;
 	}
 
+	if (command == SPEED_COMMAND) {
+		std::string speedString;
+		inStringStream >> speedString;
+		if (speedString == SPEED_UNPACED) {
+			return tickPacer.setSpeed(0);
+		}
+
+		double speedMultiplier;
+		try {
+			speedMultiplier = std::stod(speedString);
+		}
+		catch (std::exception const& exception) {
+			return false;
+		}
+		return speedMultiplier > 0 && tickPacer.setSpeed(speedMultiplier);
+	}
+
+	if (command == STATS_COMMAND) {
+		elevatorControllerPtr->getPassengerTracker().printStatistics(std::cout);
+		printPacing();
+		return true;
+	}
+
+	if (command == SAVE_COMMAND || command == RESTORE_COMMAND) {
+		std::string checkpointPath;
+		inStringStream >> checkpointPath;
+		if (checkpointPath.empty()) {
+			return false;
+		}
+
+		Elevator::SimulationCheckpoint checkpoint;
+		if (command == SAVE_COMMAND) {
+			elevatorControllerPtr->saveCheckpoint(checkpoint);
+			return checkpoint.saveToFile(checkpointPath);
+		}
+		return checkpoint.loadFromFile(checkpointPath) && elevatorControllerPtr->restoreCheckpoint(checkpoint);
+	}
+
+	if (command == PASSENGER_COMMAND) {
+		int originFloorNumber, destinationFloorNumber;
+		if (!parseInt(inStringStream, originFloorNumber) || !parseInt(inStringStream, destinationFloorNumber)) {
+			return false;
+		}
+
+		//Floors are 1 based, as with the other commands. A passenger must be going somewhere.
+		if (elevatorControllerPtr->isValidFloorNumber(originFloorNumber - 1)
+			&& elevatorControllerPtr->isValidFloorNumber(destinationFloorNumber - 1)
+			&& originFloorNumber != destinationFloorNumber) {
+			elevatorControllerPtr->addPassenger(originFloorNumber - 1, destinationFloorNumber - 1);
+			return true;
+		}
+		return false;
+	}
+
 	if (command == CALL_COMMAND) {
 		int floorNumber;
 		std::string direction;
@@ -112,6 +175,7 @@ bool SimulationInput::parseAndExecuteCommand(std::istringstream& inStringStream,
 	return false;
 }
 
+#ifdef _WIN32
 //Based on https://stackoverflow.com/questions/35800020/how-do-i-find-the-coordinates-of-the-cursor-in-a-console-window;
 //Returns the current coordinate of the console cursor
 //Windows only.
@@ -137,70 +201,174 @@ void setCursorCooridinateHeight(SHORT height) {
 		std::cout << "Unable to set cursor position: " << GetLastError() << ". Printing state on new lines." << std::endl;
 	}
 }
+#endif
 
-//Main input loop. Handles commands, parses them, until the user exits.
-void SimulationInput::enterInputLoop() {
-	std::string command;
+#ifdef _WIN32
+//Moves the console cursor to a coordinate.
+//Windows only.
+void setCursorCoordinate(COORD cursorCoordinate) {
+	HANDLE consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
+	SetConsoleCursorPosition(consoleHandle, cursorCoordinate);
+}
+#endif
 
+//Main input loop. Applies the commands from the input thread, and runs the ticks of multi-tick runs, until the user exits.
+void SimulationInput::enterInputLoop() {
+#ifdef _WIN32
 	//The starting coordinate is stored, as this marks the region that all further input should be displayed from
 	startingInputCoordinate = getCursorCoordinate();
+#endif
+
+	std::thread inputThread(&SimulationInput::readInputLines, this);
+	printPrompt();
+
+	bool exitRequested = false;
+	while (!exitRequested) {
+		//Apply every command that has arrived before the next tick
+		std::string* inputPtr = commandQueue.beginRead();
+		while (inputPtr && !exitRequested) {
+			std::string input;
+			input.swap(*inputPtr);
+			commandQueue.endRead();
+
+			exitRequested = !executeInputLine(input);
+			inputPtr = commandQueue.beginRead();
+		}
+		if (exitRequested) {
+			break;
+		}
 
-	while (command != EXIT_COMMAND) {
-		
-		std::cout << "Please input a simulation command: {Call, RequestFloor, Tick, or  Exit}" << std::endl;
-		std::string input;
-		std::getline(std::cin, input); //Get line so that we have multiple args
-		std::istringstream inStringStream(input);
+		std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
+		bool running = ticksRemaining > 0 && !runPaused;
+		if (running) {
+			//Ticks that fell behind their deadlines are run together, and drawn once
+			size_t dueTicks = tickPacer.takeDueTicks(currentTime);
+			if (dueTicks > 0) {
+				runTicks(dueTicks < ticksRemaining ? dueTicks : ticksRemaining);
+				continue;
+			}
+		}
 
+		//The closed flag is read before the queue, so every line the input thread read has been applied
+		if (!running && inputClosed.load() && !commandQueue.beginRead()) {
+			break;
+		}
+
+		//Wait for the next tick, checking for new commands in the meantime
+		std::chrono::steady_clock::time_point wakeTime = currentTime + INPUT_POLL_INTERVAL;
+		if (running && tickPacer.getNextDeadline() < wakeTime) {
+			wakeTime = tickPacer.getNextDeadline();
+		}
+		std::this_thread::sleep_until(wakeTime);
+	}
+
+	//The input thread stops by itself after reading Exit, or at the end of the input
+	inputThread.join();
+}
+
+//Reads lines from stdin into the command queue. This is the only thread that reads stdin, so a long run does not stop commands being typed.
+void SimulationInput::readInputLines() {
+	std::string input;
+	while (std::getline(std::cin, input)) { //Get line so that we have multiple args
+		std::istringstream inStringStream(input);
 		std::string command;
 		inStringStream >> command;
 
+		//Wait for the simulation thread to make room, which it does at least once per tick
+		std::string* queuedInputPtr = commandQueue.beginWrite();
+		while (!queuedInputPtr) {
+			std::this_thread::sleep_for(INPUT_POLL_INTERVAL);
+			queuedInputPtr = commandQueue.beginWrite();
+		}
+		queuedInputPtr->swap(input);
+		commandQueue.endWrite();
+
 		if (command == EXIT_COMMAND) {
 			break;
 		}
+	}
+	inputClosed = true;
+}
 
-		clearInput();
-		if (!parseAndExecuteCommand(inStringStream, input, command)) {
-			invalidCommand(command);
-		}
-		else {
-			std::cout << "Command okay. ";
-		}
+//Parses and executes one line of input on the simulation thread. Returns false if the line was Exit.
+bool SimulationInput::executeInputLine(const std::string& input) {
+	std::string inputLine = input;
+	std::istringstream inStringStream(inputLine);
+	std::string command;
+	inStringStream >> command;
+
+	if (command == EXIT_COMMAND) {
+		return false;
 	}
 
-	
+	clearInput();
+	if (!parseAndExecuteCommand(inStringStream, inputLine, command)) {
+		invalidCommand(command);
+	}
+	else {
+		std::cout << "Command okay. ";
+	}
+	printPrompt();
+	return true;
 }
 
-void SimulationInput::invalidCommand(std::string& command) {
-	std::cout << "Invalid command: " << command << " Please enter again. ";
+//Runs ticks of a multi-tick run. The display is redrawn, then the cursor is put back where it was, so text being typed is not moved.
+void SimulationInput::runTicks(size_t numberOfTicks) {
+#ifdef _WIN32
+	COORD typingCoordinate = getCursorCoordinate();
+#else
+	std::cout << "\x1b" "7"; //Save the cursor position
+	std::cout.flush();
+#endif
+
+	elevatorControllerPtr->simulationTick(numberOfTicks);
+	ticksRemaining -= numberOfTicks;
+
+#ifdef _WIN32
+	setCursorCoordinate(typingCoordinate);
+#else
+	std::cout << "\x1b" "8"; //Restore the cursor position
+	std::cout.flush();
+#endif
 }
 
+//Prints the speed, and how well multi-tick runs have kept to it
+void SimulationInput::printPacing() {
+	std::cout << "Speed: ";
+	if (tickPacer.isPaced()) {
+		std::cout << tickPacer.getSpeed() << "x";
+	}
+	else {
+		std::cout << SPEED_UNPACED;
+	}
+	std::cout << ", overruns: " << tickPacer.getOverrunCount() << ", deadlines skipped: " << tickPacer.getSkippedDeadlineCount()
+		<< ", maximum lag: " << std::chrono::duration_cast<std::chrono::milliseconds>(tickPacer.getMaximumLag()).count() << "ms" << std::endl;
+}
 
-//from https://stackoverflow.com/questions/23369503/get-size-of-terminal-window-rows-columns
-//Returns how wide the console is, in characters. Returns 100 if that fails.
-int getConsoleWidth() {
-	CONSOLE_SCREEN_BUFFER_INFO csbi;
+void SimulationInput::printPrompt() {
+	std::cout << "Please input a simulation command: {Call, RequestFloor, Passenger, Tick, Pause, Resume, Stop, Speed, Stats, Save, Restore, or  Exit}" << std::endl;
+}
 
-	if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi)) {
-		return csbi.srWindow.Right - csbi.srWindow.Left + 1;
-	}
-	//Console always has some width, so return a reasonable number
-	return 100;
+void SimulationInput::invalidCommand(std::string& command) {
+	std::cout << "Invalid command: " << command << " Please enter again. ";
 }
 
+
 //Overwrite the last few lines written with spaces, so that the input region is cleared.
 //This prevents text being printed on top of eachother.
 void SimulationInput::clearInput() {
+#ifdef _WIN32
 	COORD currentCursorCoordinate = getCursorCoordinate();
 	SHORT heightDelta = currentCursorCoordinate.Y - startingInputCoordinate.Y; //How many lines to overwrite with spaces.
 	setCursorCooridinateHeight(startingInputCoordinate.Y);
 	for (SHORT i = 0; i < heightDelta; i++) {
-		printf("%*s", getConsoleWidth(), ""); //based on https://stackoverflow.com/questions/14678948/how-to-repeat-a-char-using-printf
+		printf("%*s", TerminalRenderer::getTerminalWidth(), ""); //based on https://stackoverflow.com/questions/14678948/how-to-repeat-a-char-using-printf
 	}
 	setCursorCooridinateHeight(startingInputCoordinate.Y);
-
+#else
+	//The input region starts on the row below the display. Move there, and clear everything after it.
+	size_t inputRow = elevatorControllerPtr->simulationStateDisplay.getDisplayRowCount() + 1;
+	std::cout << "\x1b[" << inputRow << ";1H\x1b[J";
+	std::cout.flush();
+#endif
 }
-
-
-
-
@@ -2,24 +2,46 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include "ElevatorState.h"
 #include "ElevatorController.h"
+#include "SimulationCommands.h"
+#include "SnapshotRing.h"
+#include "TickPacer.h"
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
+//Reads commands from stdin on its own thread, and passes each line to the simulation thread through a lock-free queue.
+//The simulation thread applies the commands between ticks, so they take effect within one tick, even in the middle of a multi-tick run.
 class SimulationInput
 {
 	public:
 		SimulationInput(Elevator::ElevatorController* elevatorControllerPtr);
 		~SimulationInput();
 
-		void enterInputLoop();
+		void enterInputLoop();								//Runs the simulation until Exit, or until the input ends and there are no ticks left to run
 		static bool parseInt(std::istringstream& inStringStream, int& value);
 	private:
 		bool parseAndExecuteCommand(std::istringstream& inStringStream, std::string& input, std::string& command);
+		bool executeInputLine(const std::string& input);	//Returns false if the line was Exit
+		void readInputLines();								//The input thread. Reads lines into the command queue until Exit or the end of the input.
+		void runTicks(size_t numberOfTicks);				//Runs ticks of a multi-tick run, leaving the cursor where the user is typing
+		void printPacing();
 		void invalidCommand(std::string& command);
+		void printPrompt();
 		Elevator::ElevatorController* elevatorControllerPtr;
 		void clearInput();
+		Elevator::SnapshotRing<std::string> commandQueue;	//Lines read by the input thread, waiting for the simulation thread
+		std::atomic<bool> inputClosed;						//Set by the input thread once it has read its last line
+		size_t ticksRemaining;								//Ticks left in the current multi-tick run
+		bool runPaused;
+		Elevator::TickPacer tickPacer;						//Paces multi-tick runs in real time
+#ifdef _WIN32
 		COORD startingInputCoordinate;
+#endif
 };
 
 
@@ -1,5 +1,7 @@
 #include "stdafx.h"
 #include "SimulationStateDisplay.h"
+#include "Tracing.h"
+#include <algorithm>
 
 
 #define SHAFT_DISPLAY_WIDTH 12
@@ -12,6 +14,7 @@
 #define STATUS_LABEL "Status: "
 #define EMPTY_ROW_LARGE "           "
 #define NON_SHAFT_HEIGHT 4
+#define CELL_BUFFER_SIZE 64 //Longer than any cell: a floor number, its calls and the shaft, or a shaft name
 
 
 //Produces output for a given elevator shaft
@@ -31,14 +34,21 @@ u = call for going up
 */
 
 
-SimulationStateDisplay::SimulationStateDisplay(Elevator::SimulationSettings settings) : simulationSettings(settings)
+SimulationStateDisplay::SimulationStateDisplay(Elevator::SimulationSettings settings, std::ostream& outStream) : 
+	simulationSettings(settings),
+	outStream(outStream),
+	lastDisplayRowCount(0),
+	displayedShaftCount(0),
+	shaftDisplayLength(0),
+	builtConsoleWidth(0),
+	terminalRenderer(outStream)
 {
 }
 
 
 //Converts enum to a string nicely..
-std::string getStatusDisplayString(Elevator::ElevatorState& elevatorState) {
-	switch (elevatorState.movementStatus) {
+const char* getStatusDisplayString(Elevator::MovementStatus movementStatus) {
+	switch (movementStatus) {
 	case Elevator::MovementStatus::Disabled:
 		return "Disabled";
 	case Elevator::MovementStatus::MovingDown:
@@ -51,175 +61,307 @@ std::string getStatusDisplayString(Elevator::ElevatorState& elevatorState) {
 	return "ERROR";
 }
 
-
-//Pads the current string on the right side so that its length matches the target length
-std::string padRight(const std::string& currentString, const size_t targetLength) {
-	if (currentString.length() == targetLength)
-	{
-		return currentString;
+//Returns how many digits a number has, e.g. the width of the highest floor's number
+size_t getDigitCount(size_t number) {
+	size_t digitCount = 1;
+	while (number >= 10) {
+		number /= 10;
+		digitCount++;
 	}
-
-	assert(targetLength > currentString.length());
-	std::string paddedString = currentString + std::string(targetLength - currentString.length(), ' ');
-	assert(paddedString.length() == targetLength);
-	return paddedString;
+	return digitCount;
 }
 
-//Pads the current string on the left side so that its length matches the target length
-std::string padLeft(const std::string& currentString, const size_t targetLength) {
-	if (currentString.length() == targetLength)
-	{
-		return currentString;
+//Appends a string to a cell being formatted in a buffer of CELL_BUFFER_SIZE characters
+void appendToCell(char* cellBuffer, size_t& cellLength, const char* appendString) {
+	while (*appendString != '\0' && cellLength < CELL_BUFFER_SIZE) {
+		cellBuffer[cellLength++] = *appendString++;
 	}
-	assert(targetLength > currentString.length());
-	std::string paddedString = std::string(targetLength - currentString.length(), ' ') + currentString;
-	assert(paddedString.length() == targetLength);
-
-	return paddedString;
 }
 
-//Centers a string, padding them with spaces on both sides. Currrent string length must be less than the targetWidth
-std::string centerString(const std::string& currentString, const size_t targetLength){
-	
-	//If the string is already the correct length, it does not need to be padded
-	if (currentString.length() == targetLength)
-	{
-		return currentString;
+//Appends a number to a cell being formatted, padded on the right to a minimum width
+void appendNumberToCell(char* cellBuffer, size_t& cellLength, size_t number, size_t minimumWidth) {
+	size_t digitCount = getDigitCount(number);
+	for (size_t i = digitCount; i > 0 && cellLength + i - 1 < CELL_BUFFER_SIZE; i--) {
+		cellBuffer[cellLength + i - 1] = static_cast<char>('0' + number % 10);
+		number /= 10;
 	}
-
-	//The currrentString should be less than the targetWidth, (no logical way to shorten the string)
-	assert(currentString.length() < targetLength);
-
-	//Pad the left and right sides of the current string
-	size_t totalPadding = targetLength - currentString.length();
-	size_t halfPaddingLength = static_cast<size_t>(std::floor(totalPadding / 2));
-	std::string halfPad(halfPaddingLength, ' ');
-	std::string paddedString = halfPad + currentString + halfPad;
-
-	//If the lengths are not equal, then the rounding from std::floor means that we have to have non equal padding on both sides.
-	//Aka need to pad five characters, so pad 2 in the front and three after.
-	if (paddedString.length() != targetLength) {
-		paddedString += " ";
+	cellLength = std::min<size_t>(cellLength + digitCount, CELL_BUFFER_SIZE);
+	for (size_t i = digitCount; i < minimumWidth && cellLength < CELL_BUFFER_SIZE; i++) {
+		cellBuffer[cellLength++] = ' ';
 	}
-
-	assert(paddedString.length() == targetLength);
-	return paddedString;
 }
 
+//Overwrites a cell of a row with a string centered in it, padding with spaces on both sides.
+//If the padding is odd, the extra space goes on the right. Aka need to pad five characters, so pad 2 in the front and three after.
+//The string must fit in the cell (no logical way to shorten the string)
+void writeCenteredCell(std::string& row, size_t cellPosition, size_t cellWidth, const char* cellString, size_t cellLength) {
+	assert(cellLength <= cellWidth);
+	assert(cellPosition + cellWidth <= row.length());
+	size_t leftPadding = (cellWidth - cellLength) / 2;
+	std::fill(row.begin() + cellPosition, row.begin() + cellPosition + cellWidth, ' ');
+	std::copy(cellString, cellString + cellLength, row.begin() + cellPosition + leftPadding);
+}
 
+//Appends a cell to the end of a row, with the string centered in it
+void appendCenteredCell(std::string& row, size_t cellWidth, const char* cellString, size_t cellLength) {
+	size_t cellPosition = row.length();
+	row.append(cellWidth, ' ');
+	writeCenteredCell(row, cellPosition, cellWidth, cellString, cellLength);
+}
 
-//Produces a string for a row.
+//Formats a floor's part of a row into a buffer of CELL_BUFFER_SIZE characters, and returns its length.
 //For an example, floor 6 with with a down call, with the elevator is the following 
 //6:  d | [] |
-std::string getFloorDisplayString(Elevator::Floor& floor, const size_t totalFloorCount, size_t& minimumLength, bool displayElevator = false) {
-	std::string floorString = std::to_string(floor.floorNumber + 1); //Marks which floor
-	floorString = padRight(floorString, std::to_string(totalFloorCount).length()) + ": ";
+size_t formatFloorCell(char* cellBuffer, int floorNumber, uint8_t floorCalls, size_t floorNumberWidth, bool displayElevator) {
+	size_t cellLength = 0;
+	appendNumberToCell(cellBuffer, cellLength, static_cast<size_t>(floorNumber + 1), floorNumberWidth); //Marks which floor
+	appendToCell(cellBuffer, cellLength, ": ");
 
 	//status string for the elevator being called for up and down
-	floorString += floor.isCallingForDown() ? CALLING_DOWN_STR : " ";
-	floorString += floor.isCallingForUp() ? CALLING_UP_STR : " ";
+	appendToCell(cellBuffer, cellLength, (floorCalls & DisplaySnapshot::CALLING_DOWN) ? CALLING_DOWN_STR : " ");
+	appendToCell(cellBuffer, cellLength, (floorCalls & DisplaySnapshot::CALLING_UP) ? CALLING_UP_STR : " ");
 
 	//Show the shaft and the elevator if needed
-	floorString += ELEVATOR_WALL_STR;
-	floorString += displayElevator ? ELEVATOR_SYMBOL_STR : "  ";
-	floorString += ELEVATOR_WALL_STR;
-	floorString += "  "; //default padding to aid in alignment
-	
-	return floorString;
+	appendToCell(cellBuffer, cellLength, ELEVATOR_WALL_STR);
+	appendToCell(cellBuffer, cellLength, displayElevator ? ELEVATOR_SYMBOL_STR : "  ");
+	appendToCell(cellBuffer, cellLength, ELEVATOR_WALL_STR);
+	appendToCell(cellBuffer, cellLength, "  "); //default padding to aid in alignment
+	return cellLength;
+}
 
+//Formats the cell for one of a shaft's rows, and returns its length. Row 0 is the shaft's name, followed by the floors from the top floor down,
+//then the status label, the status, and an empty row.
+size_t formatShaftCell(char* cellBuffer, const DisplaySnapshot& displaySnapshot, size_t shaft, size_t row) {
+	size_t numberOfFloors = displaySnapshot.floorCalls.size();
+	size_t cellLength = 0;
+	if (row == 0) {
+		appendToCell(cellBuffer, cellLength, SHAFT_NAME);
+		appendNumberToCell(cellBuffer, cellLength, shaft, 0);
+	}
+	else if (row <= numberOfFloors) {
+		int floorNumber = static_cast<int>(numberOfFloors - row);
+		cellLength = formatFloorCell(cellBuffer, floorNumber, displaySnapshot.floorCalls[floorNumber], getDigitCount(numberOfFloors),
+			floorNumber == displaySnapshot.shaftPositions[shaft]);
+	}
+	else if (row == numberOfFloors + 1) {
+		appendToCell(cellBuffer, cellLength, STATUS_LABEL);
+	}
+	else if (row == numberOfFloors + 2) {
+		appendToCell(cellBuffer, cellLength, getStatusDisplayString(displaySnapshot.shaftStatuses[shaft]));
+	}
+	else {
+		appendToCell(cellBuffer, cellLength, EMPTY_ROW_LARGE);
+	}
+	return cellLength;
 }
 
 
-//Returns an uncentered vector of strings representing an elevator shaft
-//Updates the rowLength, so that padding is consistent across all rows
-std::vector<std::string> getShaftDisplayRows(Elevator::ElevatorShaft& elevatorShaft, std::vector<Elevator::Floor> floorsVector, size_t& rowLength) {
-	std::string shaftName = SHAFT_NAME + std::to_string(elevatorShaft.shaftNumber);
 
-	//Handle the case that there are many shafts, and have longer names
-	if (shaftName.length() > rowLength) {
-		rowLength = shaftName.length();
-	}
 
-	std::vector<std::string> displayRows;
-	displayRows.push_back(shaftName);
 
-	assert(floorsVector.size() >= 2); //There must be at least two elevator rows
-	
-	//Build the elevator floor strings
-	for (int i = floorsVector.size() -1; i >= 0; i--) {
-		std::string floorString = getFloorDisplayString(floorsVector[i], floorsVector.size(), rowLength, i == elevatorShaft.getCurrentElevatorState().currentPosition);
-		displayRows.push_back(floorString);
-		
+//Copies what the display shows out of the simulation state. The vectors keep their size between captures, so capturing the same building again does not allocate.
+void DisplaySnapshot::capture(const Elevator::SimulationState& simulationState) {
+	const std::vector<Elevator::ElevatorShaft>& elevatorShafts = simulationState.elevatorShaftVector;
+	const std::vector<Elevator::Floor>& floorsVector = simulationState.floorsVector;
+	tick = 0;
+	shaftPositions.resize(elevatorShafts.size());
+	shaftStatuses.resize(elevatorShafts.size());
+	for (size_t i = 0; i < elevatorShafts.size(); i++) {
+		shaftPositions[i] = elevatorShafts[i].getCurrentPosition();
+		shaftStatuses[i] = elevatorShafts[i].getCurrentMovementStatus();
+	}
+	floorCalls.resize(floorsVector.size());
+	for (size_t i = 0; i < floorsVector.size(); i++) {
+		floorCalls[i] = getFloorCalls(simulationState.hallCalls, static_cast<int>(i));
 	}
-	displayRows.push_back(STATUS_LABEL);
-	displayRows.push_back(getStatusDisplayString(elevatorShaft.getCurrentElevatorState()));
-	displayRows.push_back(EMPTY_ROW_LARGE);
-	return displayRows;
 }
 
+//Builds the display rows for the simulation state
+void SimulationStateDisplay::buildDisplayRows(const Elevator::SimulationState& simulationState) {
+	stateSnapshot.capture(simulationState);
+	buildDisplayRows(stateSnapshot);
+}
 
-
-
-
-//Displays the simulation state.
-void SimulationStateDisplay::displayState(Elevator::SimulationState simulationState){
-	std::vector<Elevator::ElevatorShaft> elevatorShafts = simulationState.elevatorShaftVector;
+//Builds the display rows for a snapshot, with the shafts side by side.
+//Each cell is formatted in a buffer and centered straight into its row. The rows keep their storage between builds, so drawing the same building again does not allocate.
+void SimulationStateDisplay::buildDisplayRows(const DisplaySnapshot& displaySnapshot){
+	TRACE_SCOPE("buildDisplayRows");
+	size_t numberOfShafts = displaySnapshot.shaftPositions.size();
+	size_t numberOfFloors = displaySnapshot.floorCalls.size();
+	assert(numberOfFloors >= 2); //There must be at least two elevator rows
 	
-	//We accumulate the each shaft display vector into one master vector
-	std::vector<std::string> cumulativeDisplayRows(NON_SHAFT_HEIGHT + simulationState.simulationSettings.numberOfFloors);
-	std::fill(cumulativeDisplayRows.begin(), cumulativeDisplayRows.end(), "");
+	//We accumulate each shaft's cells into one master vector
+	cumulativeDisplayRows.resize(NON_SHAFT_HEIGHT + numberOfFloors);
+	for (size_t i = 0; i < cumulativeDisplayRows.size(); i++) {
+		cumulativeDisplayRows[i].clear();
+	}
 
 	size_t totalRowLength = 0;
-	size_t totalCharacterOutput = 0;
 
 	//Get the console size, to ensure that formatting is not completely broken by odd dimensions.
-	CONSOLE_SCREEN_BUFFER_INFO consoleScreenBufferInfo;
-	GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &consoleScreenBufferInfo); //Used to get console dimensions
+	size_t consoleWidth = static_cast<size_t>(TerminalRenderer::getTerminalWidth() - 1);
+	builtConsoleWidth = consoleWidth;
+	displayedShaftCount = 0;
 	
 	//For each elevator shaft
-	for (size_t i = 0; i < elevatorShafts.size(); i++) {
+	char cellBuffer[CELL_BUFFER_SIZE];
+	for (size_t i = 0; i < numberOfShafts; i++) {
 		
-		size_t shaftDisplayLength = std::to_string(simulationState.simulationSettings.numberOfFloors).length() + SHAFT_DISPLAY_WIDTH;
+		shaftDisplayLength = getDigitCount(numberOfFloors) + SHAFT_DISPLAY_WIDTH;
 
 		//Ensure that we do not attempt to display more shafts than what will fit on the console window
-		if ((totalRowLength + (2 * shaftDisplayLength)) > static_cast<size_t>(consoleScreenBufferInfo.srWindow.Right - consoleScreenBufferInfo.srWindow.Left)) {
-			std::string notificationString = " and " + std::to_string(elevatorShafts.size() - i + 1) + " more.";
-			cumulativeDisplayRows[0] += notificationString;
-			totalCharacterOutput += notificationString.length();
+		if ((totalRowLength + (2 * shaftDisplayLength)) > consoleWidth) {
+			size_t cellLength = 0;
+			appendToCell(cellBuffer, cellLength, " and ");
+			appendNumberToCell(cellBuffer, cellLength, numberOfShafts - i + 1, 0);
+			appendToCell(cellBuffer, cellLength, " more.");
+			cumulativeDisplayRows[0].append(cellBuffer, cellLength);
 			break; 
 		}
 
+		//Handle the case that there are many shafts, and have longer names
+		size_t shaftNameLength = formatShaftCell(cellBuffer, displaySnapshot, i, 0);
+		if (shaftNameLength > shaftDisplayLength) {
+			shaftDisplayLength = shaftNameLength;
+		}
 
-		//Get the display vector for a given shaft
-		std::vector<std::string> elevatorShaftRows = getShaftDisplayRows(elevatorShafts[i], simulationState.floorsVector, shaftDisplayLength);
-
-		assert(cumulativeDisplayRows.size() == elevatorShaftRows.size());
-
-		//Add the diplay vector onto the cumulative vector
+		//Add the shaft's cells onto the rows
 		for (size_t j = 0; j < cumulativeDisplayRows.size(); j++) {
-			std::string centerShaftRow = centerString(elevatorShaftRows[j], shaftDisplayLength);
-			
-			cumulativeDisplayRows[j] += centerShaftRow;
-
-			totalCharacterOutput += centerShaftRow.length();
-			assert(centerShaftRow.length() == shaftDisplayLength);
+			size_t cellLength = formatShaftCell(cellBuffer, displaySnapshot, i, j);
+			appendCenteredCell(cumulativeDisplayRows[j], shaftDisplayLength, cellBuffer, cellLength);
 		}
 		totalRowLength += shaftDisplayLength;
+		displayedShaftCount++;
 	}
 
+	lastDisplayRowCount = cumulativeDisplayRows.size();
+}
 
-	//Output the cumulative vector
+//Output the cumulative vector, as one write rather than flushing each row
+void SimulationStateDisplay::writeDisplayRows() {
+	frameBuffer.clear();
 	for (size_t i = 0; i < cumulativeDisplayRows.size(); i++) {
-		
-		std::cout << cumulativeDisplayRows[i] << std::endl;
+		frameBuffer += cumulativeDisplayRows[i];
+		frameBuffer += '\n';
 	}
+	outStream.write(frameBuffer.data(), frameBuffer.size());
+	outStream.flush();
+}
 
-	lastDisplayRowCount = cumulativeDisplayRows.size();
-	
+//Displays the simulation state.
+void SimulationStateDisplay::displayState(const Elevator::SimulationState& simulationState){
+	TRACE_SCOPE("displayState");
+	buildDisplayRows(simulationState);
+
+#ifdef _WIN32
+	writeDisplayRows();
+#else
+	//Draw everything, as whatever is on the terminal is unknown
+	terminalRenderer.invalidate();
+	terminalRenderer.presentFrame(cumulativeDisplayRows);
+#endif
 }	
 
 //Move the cursor back to the top left, and overwrite the current display
-void SimulationStateDisplay::refreshDisplay(Elevator::SimulationState simulationState) {
+//Terminals that understand ANSI escape sequences only redraw what changed since the last display.
+void SimulationStateDisplay::refreshDisplay(const Elevator::SimulationState& simulationState) {
+	TRACE_SCOPE("refreshDisplay");
+	buildDisplayRows(simulationState);
+	presentDisplayRows();
+}
+
+//Overwrites the current display with a snapshot, e.g. one captured on another thread
+void SimulationStateDisplay::refreshDisplay(const DisplaySnapshot& displaySnapshot) {
+	TRACE_SCOPE("refreshDisplay");
+	buildDisplayRows(displaySnapshot);
+	presentDisplayRows();
+}
+
+//Updates the display from a batch of changes. Only the cells of the shafts and floors that changed are rebuilt,
+//unless the whole state was replaced or the console was resized, when every row is built again.
+void SimulationStateDisplay::simulationEventsPublished(const Elevator::SimulationEventBatch& eventBatch, const Elevator::SimulationState& simulationState) {
+	TRACE_SCOPE("simulationEventsPublished");
+	if (!patchDisplayRows(eventBatch, simulationState)) {
+		buildDisplayRows(simulationState);
+	}
+	presentDisplayRows();
+}
+
+//Patches the rows built for the last display with a batch of changes
+bool SimulationStateDisplay::patchDisplayRows(const Elevator::SimulationEventBatch& eventBatch, const Elevator::SimulationState& simulationState) {
+	size_t numberOfFloors = simulationState.floorsVector.size();
+	if (builtConsoleWidth == 0 || builtConsoleWidth != static_cast<size_t>(TerminalRenderer::getTerminalWidth() - 1)
+		|| cumulativeDisplayRows.size() != NON_SHAFT_HEIGHT + numberOfFloors) {
+		return false;
+	}
+
+	const std::vector<Elevator::SimulationEvent>& simulationEvents = eventBatch.simulationEvents;
+	for (size_t i = 0; i < simulationEvents.size(); i++) {
+		const Elevator::SimulationEvent& simulationEvent = simulationEvents[i];
+		switch (simulationEvent.eventType) {
+		case Elevator::SimulationEventType::StateReplaced:
+			return false;
+		case Elevator::SimulationEventType::ShaftMoved:
+			//The elevator leaves one floor's row and enters another
+			if (simulationEvent.shaft < displayedShaftCount) {
+				if (simulationEvent.value >= 0 && static_cast<size_t>(simulationEvent.value) < numberOfFloors) {
+					patchShaftCell(simulationState, simulationEvent.shaft, numberOfFloors - simulationEvent.value);
+				}
+				if (simulationEvent.floor >= 0 && static_cast<size_t>(simulationEvent.floor) < numberOfFloors) {
+					patchShaftCell(simulationState, simulationEvent.shaft, numberOfFloors - simulationEvent.floor);
+				}
+			}
+			break;
+		case Elevator::SimulationEventType::StatusChanged:
+			if (simulationEvent.shaft < displayedShaftCount) {
+				patchShaftCell(simulationState, simulationEvent.shaft, numberOfFloors + 2);
+			}
+			break;
+		case Elevator::SimulationEventType::CallSet:
+		case Elevator::SimulationEventType::CallCleared:
+			//Every shaft shows the floor's calls
+			for (size_t shaft = 0; shaft < displayedShaftCount; shaft++) {
+				patchShaftCell(simulationState, shaft, numberOfFloors - simulationEvent.floor);
+			}
+			break;
+		default:
+			//The display does not show the stops
+			break;
+		}
+	}
+
+#ifndef NDEBUG
+	//The patched rows must be the same as building them again
+	std::vector<std::string> patchedRows = cumulativeDisplayRows;
+	buildDisplayRows(simulationState);
+	assert(patchedRows == cumulativeDisplayRows);
+#endif
+	return true;
+}
+
+//Rebuilds one shaft's part of a row, in place. Row 0 is the shaft's name, followed by the floors from the top floor down, then the status label and the status.
+void SimulationStateDisplay::patchShaftCell(const Elevator::SimulationState& simulationState, size_t shaft, size_t row) {
+	const Elevator::ElevatorShaft& elevatorShaft = simulationState.elevatorShaftVector[shaft];
+	size_t numberOfFloors = simulationState.floorsVector.size();
+	char cellBuffer[CELL_BUFFER_SIZE];
+	size_t cellLength = 0;
+	if (row >= 1 && row <= numberOfFloors) {
+		int floorNumber = static_cast<int>(numberOfFloors - row);
+		cellLength = formatFloorCell(cellBuffer, floorNumber, DisplaySnapshot::getFloorCalls(simulationState.hallCalls, floorNumber), getDigitCount(numberOfFloors),
+			floorNumber == elevatorShaft.getCurrentPosition());
+	}
+	else if (row == numberOfFloors + 2) {
+		appendToCell(cellBuffer, cellLength, getStatusDisplayString(elevatorShaft.getCurrentMovementStatus()));
+	}
+	else {
+		return;
+	}
+	writeCenteredCell(cumulativeDisplayRows[row], shaft * shaftDisplayLength, shaftDisplayLength, cellBuffer, cellLength);
+}
+
+//Overwrites the current display with the rows. Terminals that understand ANSI escape sequences only redraw the cells that changed.
+void SimulationStateDisplay::presentDisplayRows() {
+#ifdef _WIN32
 	COORD cursorCoordinate;
 	cursorCoordinate.X = 0;
 	cursorCoordinate.Y = 0;
@@ -229,13 +371,8 @@ void SimulationStateDisplay::refreshDisplay(Elevator::SimulationState simulation
 		std::cout << "Unable to set cursor position: " << GetLastError() << ". Printing state on new lines." << std::endl;
 	}
 
-	displayState(simulationState);
+	writeDisplayRows();
+#else
+	terminalRenderer.presentFrame(cumulativeDisplayRows);
+#endif
 }
-
-
-
-
-
-
-
-
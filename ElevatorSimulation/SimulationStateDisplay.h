@@ -1,23 +1,70 @@
 #pragma once
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 #include <string>
+#include <vector>
+#include <cstdint>
 #include <iostream>
 #include "ElevatorState.h"
 #include "SimState.h"
 #include "ElevatorShaft.h"
 #include <cmath>
+#include "TerminalRenderer.h"
+#include "SimulationEvents.h"
 
-class SimulationStateDisplay
+//What the display shows of the simulation state, so it can be drawn without the state, e.g. on another thread
+struct DisplaySnapshot {
+	size_t tick;
+	std::vector<int> shaftPositions;
+	std::vector<Elevator::MovementStatus> shaftStatuses;
+	std::vector<uint8_t> floorCalls;			//CALLING_UP and CALLING_DOWN flags for each floor
+
+	static const uint8_t CALLING_UP = 1;
+	static const uint8_t CALLING_DOWN = 2;
+
+	void capture(const Elevator::SimulationState& simulationState);	//The tick is left at 0, the state does not know it
+	static uint8_t getFloorCalls(const Elevator::HallCallSet& hallCalls, int floorNumber);
+};
+
+class SimulationStateDisplay : public Elevator::SimulationEventListener
 {
 	public:
-		SimulationStateDisplay(Elevator::SimulationSettings settings);
-		void displayState(Elevator::SimulationState simulationState);
-		void refreshDisplay(Elevator::SimulationState simulationState);
+		SimulationStateDisplay(Elevator::SimulationSettings settings, std::ostream& outStream = std::cout);	//The display is written to outStream
+		void displayState(const Elevator::SimulationState& simulationState);
+		void refreshDisplay(const Elevator::SimulationState& simulationState);
+		void refreshDisplay(const DisplaySnapshot& displaySnapshot);
+		void simulationEventsPublished(const Elevator::SimulationEventBatch& eventBatch, const Elevator::SimulationState& simulationState) override;	//Only redraws the cells the changes touched
+		size_t getDisplayRowCount() const;			//How many rows the last display used. Input is shown below these rows.
 
 
 	private: 
+		void buildDisplayRows(const Elevator::SimulationState& simulationState);	//Builds the rows of the display into cumulativeDisplayRows
+		void buildDisplayRows(const DisplaySnapshot& displaySnapshot);
+		void writeDisplayRows();											//Writes the rows to the console in one write
+		void presentDisplayRows();											//Overwrites the current display with the rows
+		bool patchDisplayRows(const Elevator::SimulationEventBatch& eventBatch, const Elevator::SimulationState& simulationState);	//Returns false if the rows have to be built again
+		void patchShaftCell(const Elevator::SimulationState& simulationState, size_t shaft, size_t row);	//Rebuilds one shaft's part of a row from the state
+
 		const Elevator::SimulationSettings simulationSettings;
+		std::ostream& outStream;
 		size_t lastDisplayRowCount;
+		std::vector<std::string> cumulativeDisplayRows;	//Cleared and refilled for each build, keeping each row's storage
+		std::string frameBuffer;					//The rows joined into one write, reused between frames
+		DisplaySnapshot stateSnapshot;				//Reused to build the rows for a state
+		size_t displayedShaftCount;					//How many shafts fitted on the console when the rows were built
+		size_t shaftDisplayLength;					//The width of each shaft's part of a row
+		size_t builtConsoleWidth;					//The console width the rows were built for, 0 before they are built
+		TerminalRenderer terminalRenderer;			//Only draws the cells that changed, used on terminals that understand ANSI escape sequences
 	
 };
 
+//Inline member functions
+inline uint8_t DisplaySnapshot::getFloorCalls(const Elevator::HallCallSet& hallCalls, int floorNumber) {
+	return (hallCalls.isCallingForUp(floorNumber) ? CALLING_UP : 0) | (hallCalls.isCallingForDown(floorNumber) ? CALLING_DOWN : 0);
+}
+
+inline size_t SimulationStateDisplay::getDisplayRowCount() const {
+	return lastDisplayRowCount;
+}
+
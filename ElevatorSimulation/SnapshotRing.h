@@ -0,0 +1,109 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+namespace Elevator {
+
+	//A fixed size ring of slots, passed from one producer thread to one consumer thread without locks.
+	//The slots are created up front and written in place, so once they have grown to size, passing a value along does not allocate.
+	//The producer fills the slot from beginWrite and publishes it with endWrite. The consumer reads the slot from beginRead and frees it with endRead.
+	//Each index is only written by one thread. Each side keeps a copy of the other side's index, and only reloads it when the ring looks full or empty,
+	//so the two threads rarely touch the same cache line.
+	template <class T>
+	class SnapshotRing {
+		public:
+			SnapshotRing(size_t capacity);		//The capacity is rounded up to a power of two
+
+			T* beginWrite();					//The next free slot, or nullptr if the consumer has not freed one yet
+			void endWrite();					//Publishes the slot from beginWrite
+			T* beginRead();						//The oldest published slot, or nullptr if there is none
+			void endRead();						//Frees the slot from beginRead
+			size_t skipToNewest();				//Frees every published slot except the newest, returning how many were freed. Consumer only.
+			size_t getCapacity() const;
+
+		private:
+			static const size_t CACHE_LINE_SIZE = 64;
+
+			std::vector<T> slots;
+			const size_t indexMask;
+
+			alignas(CACHE_LINE_SIZE) std::atomic<size_t> writeIndex;	//How many slots have been published. Written by the producer.
+			size_t cachedReadIndex;										//The producer's copy of readIndex
+
+			alignas(CACHE_LINE_SIZE) std::atomic<size_t> readIndex;	//How many slots have been freed. Written by the consumer.
+			size_t cachedWriteIndex;									//The consumer's copy of writeIndex
+	};
+
+	//Rounds up to the next power of two, so the index can be masked rather than divided
+	inline size_t roundUpToPowerOfTwo(size_t value) {
+		size_t powerOfTwo = 1;
+		while (powerOfTwo < value) {
+			powerOfTwo <<= 1;
+		}
+		return powerOfTwo;
+	}
+
+	//Inline member functions
+
+	template <class T>
+	SnapshotRing<T>::SnapshotRing(size_t capacity) :
+		slots(roundUpToPowerOfTwo(capacity)),
+		indexMask(roundUpToPowerOfTwo(capacity) - 1),
+		writeIndex(0),
+		cachedReadIndex(0),
+		readIndex(0),
+		cachedWriteIndex(0)
+	{
+	}
+
+	template <class T>
+	inline T* SnapshotRing<T>::beginWrite() {
+		size_t currentWriteIndex = writeIndex.load(std::memory_order_relaxed);
+		if (currentWriteIndex - cachedReadIndex == slots.size()) {
+			cachedReadIndex = readIndex.load(std::memory_order_acquire);
+			if (currentWriteIndex - cachedReadIndex == slots.size()) {
+				return nullptr;
+			}
+		}
+		return &slots[currentWriteIndex & indexMask];
+	}
+
+	template <class T>
+	inline void SnapshotRing<T>::endWrite() {
+		writeIndex.store(writeIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	template <class T>
+	inline T* SnapshotRing<T>::beginRead() {
+		size_t currentReadIndex = readIndex.load(std::memory_order_relaxed);
+		if (currentReadIndex == cachedWriteIndex) {
+			cachedWriteIndex = writeIndex.load(std::memory_order_acquire);
+			if (currentReadIndex == cachedWriteIndex) {
+				return nullptr;
+			}
+		}
+		return &slots[currentReadIndex & indexMask];
+	}
+
+	template <class T>
+	inline void SnapshotRing<T>::endRead() {
+		readIndex.store(readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	template <class T>
+	inline size_t SnapshotRing<T>::skipToNewest() {
+		cachedWriteIndex = writeIndex.load(std::memory_order_acquire);
+		size_t currentReadIndex = readIndex.load(std::memory_order_relaxed);
+		if (cachedWriteIndex - currentReadIndex <= 1) {
+			return 0;
+		}
+		readIndex.store(cachedWriteIndex - 1, std::memory_order_release);
+		return cachedWriteIndex - 1 - currentReadIndex;
+	}
+
+	template <class T>
+	inline size_t SnapshotRing<T>::getCapacity() const {
+		return slots.size();
+	}
+}
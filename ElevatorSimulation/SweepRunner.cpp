@@ -0,0 +1,121 @@
+#include "stdafx.h"
+#include "SweepRunner.h"
+
+#define SWEEP_BASE_SEED 20170403		//Seed n of every configuration is SWEEP_BASE_SEED + n, so configurations are compared on the same traffic
+#define PASSENGER_ATTEMPTS_SHAFT_DIVISOR 4	//Each tick makes one passenger attempt, plus one per this many shafts
+#define PASSENGER_CHANCE_DIVISOR 8			//Each attempt adds a passenger with a chance of 1 in this many
+
+
+//Lists every configuration in the ranges, floors first
+Elevator::SweepRunner::SweepRunner(SweepRange floorRange, SweepRange shaftRange, size_t seedCount, size_t numberOfTicks, DispatchPolicyType dispatchPolicy) :
+	seedCount(seedCount),
+	numberOfTicks(numberOfTicks),
+	threadsUsed(0),
+	jobsStolen(0),
+	elapsedTime(0)
+{
+	for (int floors = floorRange.minimum; floors <= floorRange.maximum; floors += floorRange.step) {
+		for (int shafts = shaftRange.minimum; shafts <= shaftRange.maximum; shafts += shaftRange.step) {
+			SimulationSettings simulationSettings;
+			simulationSettings.numberOfFloors = floors;
+			simulationSettings.numberOfShafts = shafts;
+			simulationSettings.dispatchPolicy = dispatchPolicy;
+			configurations.push_back(simulationSettings);
+		}
+	}
+}
+
+//Runs every configuration and seed as its own job
+void Elevator::SweepRunner::run(size_t threadCount) {
+	if (threadCount == 0) {
+		threadCount = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+	}
+
+	jobResults.assign(configurations.size() * seedCount, SweepJobResult());
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	WorkStealingPool workStealingPool(threadCount);
+	workStealingPool.run(jobResults.size(), [this](size_t jobNumber) {
+		jobResults[jobNumber] = runJob(jobNumber);
+	});
+
+	elapsedTime = std::chrono::steady_clock::now() - startTime;
+	threadsUsed = workStealingPool.getWorkerCount();
+	jobsStolen = workStealingPool.getStolenJobCount();
+}
+
+//Runs one configuration with one seed. Everything it uses is local, so jobs can run on any thread.
+Elevator::SweepJobResult Elevator::SweepRunner::runJob(size_t jobNumber) const {
+	const SimulationSettings& simulationSettings = configurations[jobNumber / seedCount];
+	ElevatorController controller(simulationSettings);
+	controller.setDisplayEnabled(false);
+
+	std::mt19937 randomGenerator(static_cast<std::mt19937::result_type>(SWEEP_BASE_SEED + jobNumber % seedCount));
+	std::uniform_int_distribution<int> floorDistribution(0, simulationSettings.numberOfFloors - 1);
+	std::uniform_int_distribution<int> chanceDistribution(0, PASSENGER_CHANCE_DIVISOR - 1);
+	std::uniform_int_distribution<int> directionDistribution(0, 1);
+	int passengerAttempts = 1 + simulationSettings.numberOfShafts / PASSENGER_ATTEMPTS_SHAFT_DIVISOR;
+	int topFloor = simulationSettings.numberOfFloors - 1;
+
+	SweepJobResult result = SweepJobResult();
+	for (size_t tick = 0; tick < numberOfTicks; tick++) {
+		for (int i = 0; i < passengerAttempts; i++) {
+			if (chanceDistribution(randomGenerator) != 0) {
+				continue;
+			}
+
+			//The bottom floor can only go up, and the top floor can only go down
+			int originFloor = floorDistribution(randomGenerator);
+			bool goingUp = originFloor == 0 || (originFloor != topFloor && directionDistribution(randomGenerator) == 0);
+			std::uniform_int_distribution<int> destinationDistribution(goingUp ? originFloor + 1 : 0, goingUp ? topFloor : originFloor - 1);
+			controller.addPassenger(originFloor, destinationDistribution(randomGenerator));
+			result.passengersAdded++;
+		}
+
+		controller.simulationTick();
+	}
+
+	const PassengerTracker& passengerTracker = controller.getPassengerTracker();
+	const LatencyHistogram& waitHistogram = passengerTracker.getBuildingWaitHistogram();
+	const LatencyHistogram& journeyHistogram = passengerTracker.getBuildingJourneyHistogram();
+	result.passengersBoarded = waitHistogram.getCount();
+	result.passengersArrived = journeyHistogram.getCount();
+	result.passengersWaiting = passengerTracker.getWaitingPassengerCount();
+	result.passengersRiding = passengerTracker.getRidingPassengerCount();
+	result.totalWaitTicks = waitHistogram.getMean() * waitHistogram.getCount();
+	result.longestWaitTicks = waitHistogram.getMaximum();
+	result.totalJourneyTicks = journeyHistogram.getMean() * journeyHistogram.getCount();
+	return result;
+}
+
+//Prints one line per configuration, combining the results of its seeds in seed order
+void Elevator::SweepRunner::printResults(std::ostream& outStream) const {
+	outStream << "Floors,Shafts,Seeds,Ticks,Passengers,Boarded,Arrived,StillWaiting,StillRiding,MeanWaitTicks,LongestWaitTicks,MeanJourneyTicks" << std::endl;
+	for (size_t i = 0; i < configurations.size() && !jobResults.empty(); i++) {
+		SweepJobResult combinedResult = SweepJobResult();
+		for (size_t seed = 0; seed < seedCount; seed++) {
+			const SweepJobResult& jobResult = jobResults[i * seedCount + seed];
+			combinedResult.passengersAdded += jobResult.passengersAdded;
+			combinedResult.passengersBoarded += jobResult.passengersBoarded;
+			combinedResult.passengersArrived += jobResult.passengersArrived;
+			combinedResult.passengersWaiting += jobResult.passengersWaiting;
+			combinedResult.passengersRiding += jobResult.passengersRiding;
+			combinedResult.totalWaitTicks += jobResult.totalWaitTicks;
+			combinedResult.longestWaitTicks = std::max(combinedResult.longestWaitTicks, jobResult.longestWaitTicks);
+			combinedResult.totalJourneyTicks += jobResult.totalJourneyTicks;
+		}
+
+		double meanWaitTicks = combinedResult.passengersBoarded > 0 ? combinedResult.totalWaitTicks / combinedResult.passengersBoarded : 0;
+		double meanJourneyTicks = combinedResult.passengersArrived > 0 ? combinedResult.totalJourneyTicks / combinedResult.passengersArrived : 0;
+		outStream << configurations[i].numberOfFloors << "," << configurations[i].numberOfShafts << "," << seedCount << "," << numberOfTicks << ","
+			<< combinedResult.passengersAdded << "," << combinedResult.passengersBoarded << "," << combinedResult.passengersArrived << ","
+			<< combinedResult.passengersWaiting << "," << combinedResult.passengersRiding << ","
+			<< meanWaitTicks << "," << combinedResult.longestWaitTicks << "," << meanJourneyTicks << std::endl;
+	}
+}
+
+//Prints how long the sweep took. Kept apart from the results, as it is the only part that changes between runs.
+void Elevator::SweepRunner::printTiming(std::ostream& outStream) const {
+	outStream << "Simulations: " << jobResults.size() << " on " << threadsUsed << " threads (" << jobsStolen << " stolen)" << std::endl;
+	outStream << "Elapsed seconds: " << elapsedTime.count() << std::endl;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <random>
+#include <iostream>
+#include <chrono>
+#include "ElevatorState.h"
+#include "ElevatorController.h"
+#include "WorkStealingPool.h"
+
+namespace Elevator {
+
+	//An inclusive range of values, visited in steps
+	struct SweepRange {
+		int minimum;
+		int maximum;
+		int step;
+	};
+
+	//The results of one simulation in the sweep, taken from its controller's PassengerTracker
+	struct SweepJobResult {
+		size_t passengersAdded;
+		size_t passengersBoarded;
+		size_t passengersArrived;
+		size_t passengersWaiting;			//Still waiting when the simulation ended
+		size_t passengersRiding;			//Still riding when the simulation ended
+		double totalWaitTicks;				//Sum of the ticks between each boarded passenger's call and their boarding
+		size_t longestWaitTicks;
+		double totalJourneyTicks;			//Sum of the ticks between each arrived passenger's call and their arrival
+	};
+
+	//Runs an independent simulation for every combination of floor count, shaft count and seed, spread over a work stealing pool.
+	//Each simulation adds random passengers through ElevatorController::addPassenger, so they are boarded and delivered by the same model as a traffic run.
+	//Results are stored by job number and combined in configuration order, so they do not depend on the number of threads.
+	class SweepRunner
+	{
+		public:
+			SweepRunner(SweepRange floorRange, SweepRange shaftRange, size_t seedCount, size_t numberOfTicks, DispatchPolicyType dispatchPolicy);
+
+			void run(size_t threadCount);						//Runs every simulation. 0 threads uses every core.
+			void printResults(std::ostream& outStream) const;	//Prints one line per configuration, combining its seeds, as comma separated values
+			void printTiming(std::ostream& outStream) const;
+
+		private:
+			SweepJobResult runJob(size_t jobNumber) const;		//Runs a single simulation, only touching its own controller
+
+			std::vector<SimulationSettings> configurations;
+			const size_t seedCount;
+			const size_t numberOfTicks;
+			std::vector<SweepJobResult> jobResults;				//Indexed by configuration, then seed
+			size_t threadsUsed;
+			size_t jobsStolen;
+			std::chrono::duration<double> elapsedTime;
+	};
+}
@@ -0,0 +1,133 @@
+#include "stdafx.h"
+#include "TerminalRenderer.h"
+#include "Tracing.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#define ESCAPE_SEQUENCE_START "\x1b["
+#define CLEAR_SCREEN_SEQUENCE "\x1b[2J"
+#define CLEAR_TO_END_OF_LINE_SEQUENCE "\x1b[K"
+#define CLEAR_TO_END_OF_SCREEN_SEQUENCE "\x1b[J"
+#define DEFAULT_TERMINAL_WIDTH 100
+
+//Unchanged gaps shorter than this are rewritten rather than skipped, as a cursor move would cost more bytes than the gap itself.
+#define MIN_SKIPPED_GAP 8
+
+
+TerminalRenderer::TerminalRenderer(std::ostream& outStream) :
+	outStream(outStream),
+	hasPreviousFrame(false),
+	lastFrameByteCount(0)
+{
+}
+
+//Moves the cursor to a given row and column. Rows and columns start at 0, but the terminal starts them at 1.
+void TerminalRenderer::appendCursorMove(size_t row, size_t column) {
+	outputBuffer += ESCAPE_SEQUENCE_START;
+	outputBuffer += std::to_string(row + 1);
+	outputBuffer += ';';
+	outputBuffer += std::to_string(column + 1);
+	outputBuffer += 'H';
+}
+
+//Compares a row against the previous frame, and writes only the runs of cells that differ.
+void TerminalRenderer::appendChangedCells(size_t row, const std::string& previousRow, const std::string& currentRow) {
+	size_t column = 0;
+	while (column < currentRow.length()) {
+
+		//Skip the cells that have not changed
+		if (column < previousRow.length() && previousRow[column] == currentRow[column]) {
+			column++;
+			continue;
+		}
+
+		//Find the end of the changed run, merging across short unchanged gaps
+		size_t runStart = column;
+		size_t runEnd = column + 1;
+		size_t unchangedCount = 0;
+		for (size_t i = runEnd; i < currentRow.length() && unchangedCount < MIN_SKIPPED_GAP; i++) {
+			if (i < previousRow.length() && previousRow[i] == currentRow[i]) {
+				unchangedCount++;
+			}
+			else {
+				unchangedCount = 0;
+				runEnd = i + 1;
+			}
+		}
+
+		appendCursorMove(row, runStart);
+		outputBuffer.append(currentRow, runStart, runEnd - runStart);
+		column = runEnd;
+	}
+
+	//The row got shorter, remove what is left of the previous row
+	if (previousRow.length() > currentRow.length()) {
+		appendCursorMove(row, currentRow.length());
+		outputBuffer += CLEAR_TO_END_OF_LINE_SEQUENCE;
+	}
+}
+
+//Draws the frame, only sending what differs from the previous frame.
+//The cursor is left on the row below the frame, so that other output continues from there.
+void TerminalRenderer::presentFrame(const std::vector<std::string>& frameRows) {
+	TRACE_SCOPE("presentFrame");
+	outputBuffer.clear();
+
+	//Start from a blank screen, everything is drawn. The previous frame's rows are kept, so their storage is reused.
+	size_t previousRowCount = hasPreviousFrame ? previousFrame.size() : 0;
+	if (!hasPreviousFrame) {
+		outputBuffer += CLEAR_SCREEN_SEQUENCE;
+	}
+
+	const std::string emptyRow;
+	for (size_t row = 0; row < frameRows.size(); row++) {
+		if (row < previousRowCount) {
+			appendChangedCells(row, previousFrame[row], frameRows[row]);
+		}
+		else {
+			appendChangedCells(row, emptyRow, frameRows[row]);
+		}
+	}
+
+	//The frame got shorter, remove the rows that are no longer used
+	if (previousRowCount > frameRows.size()) {
+		appendCursorMove(frameRows.size(), 0);
+		outputBuffer += CLEAR_TO_END_OF_SCREEN_SEQUENCE;
+	}
+
+	appendCursorMove(frameRows.size(), 0);
+
+	outStream.write(outputBuffer.data(), outputBuffer.size());
+	outStream.flush();
+	lastFrameByteCount = outputBuffer.size();
+
+	//Keep the frame for the next comparison, reusing the existing row buffers
+	previousFrame.resize(frameRows.size());
+	for (size_t row = 0; row < frameRows.size(); row++) {
+		previousFrame[row].assign(frameRows[row]);
+	}
+	hasPreviousFrame = true;
+}
+
+//from https://stackoverflow.com/questions/23369503/get-size-of-terminal-window-rows-columns
+//Returns how wide the terminal is, in characters. Returns 100 if that fails.
+int TerminalRenderer::getTerminalWidth() {
+#ifdef _WIN32
+	CONSOLE_SCREEN_BUFFER_INFO csbi;
+	if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi)) {
+		return csbi.srWindow.Right - csbi.srWindow.Left + 1;
+	}
+#else
+	struct winsize windowSize;
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &windowSize) == 0 && windowSize.ws_col > 0) {
+		return windowSize.ws_col;
+	}
+#endif
+	//Console always has some width, so return a reasonable number
+	return DEFAULT_TERMINAL_WIDTH;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <iostream>
+
+//Draws frames of text rows onto an ANSI (VT100) terminal.
+//The previous frame is kept, so that each new frame only sends the cursor moves and characters for the cells that changed.
+//The whole frame is written to the output stream in one buffered write.
+class TerminalRenderer
+{
+	public:
+		TerminalRenderer(std::ostream& outStream = std::cout);
+
+		void presentFrame(const std::vector<std::string>& frameRows);	//Draws the frame, only sending what differs from the previous frame
+		void invalidate();												//Forgets the previous frame, so the next frame clears the screen and is drawn in full
+		size_t getLastFrameByteCount() const;							//How many bytes the last frame wrote to the output stream
+
+		static int getTerminalWidth();									//Returns how wide the terminal is, in characters. Returns 100 if that fails.
+
+	private:
+		void appendCursorMove(size_t row, size_t column);
+		void appendChangedCells(size_t row, const std::string& previousRow, const std::string& currentRow);
+
+		std::ostream& outStream;
+		std::vector<std::string> previousFrame;
+		std::string outputBuffer;				//Reused between frames, so that drawing does not reallocate
+		bool hasPreviousFrame;
+		size_t lastFrameByteCount;
+};
+
+//Inline member functions
+inline size_t TerminalRenderer::getLastFrameByteCount() const {
+	return lastFrameByteCount;
+}
+
+inline void TerminalRenderer::invalidate() {
+	hasPreviousFrame = false;
+}
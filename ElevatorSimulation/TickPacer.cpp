@@ -0,0 +1,88 @@
+#include "stdafx.h"
+#include "TickPacer.h"
+#include <thread>
+
+#define DEFAULT_MAXIMUM_CATCH_UP_TICKS 64	//Ticks run back to back before the rest of the missed deadlines are skipped. Unpaced runs take this many at a time.
+
+const double Elevator::TickPacer::MINIMUM_SPEED = 0.1;
+const double Elevator::TickPacer::MAXIMUM_SPEED = 1000;
+
+
+Elevator::TickPacer::TickPacer(Clock::duration baseTickInterval) :
+	baseTickInterval(baseTickInterval),
+	speedMultiplier(1),
+	maximumCatchUpTicks(DEFAULT_MAXIMUM_CATCH_UP_TICKS),
+	runStartTime(Clock::now()),
+	ticksTaken(0),
+	overrunCount(0),
+	skippedDeadlineCount(0),
+	maximumLag(Clock::duration::zero())
+{
+}
+
+void Elevator::TickPacer::start(Clock::time_point startTime) {
+	runStartTime = startTime;
+	ticksTaken = 0;
+}
+
+//The deadline is computed from the start of the run each time, rather than adding the interval to the last deadline, so rounding does not build up
+Elevator::TickPacer::Clock::time_point Elevator::TickPacer::getDeadline(size_t tickNumber) const {
+	if (!isPaced()) {
+		return runStartTime;
+	}
+	std::chrono::duration<double, Clock::period> tickInterval = std::chrono::duration<double, Clock::period>(baseTickInterval) / speedMultiplier;
+	return runStartTime + std::chrono::duration_cast<Clock::duration>(tickInterval * static_cast<double>(tickNumber));
+}
+
+//Counts the ticks whose deadline has passed. If there are more than the maximum catch up, the rest of the deadlines are skipped and the run is rebased,
+//so the next tick is due one interval from now.
+size_t Elevator::TickPacer::takeDueTicks(Clock::time_point currentTime) {
+	if (!isPaced()) {
+		return maximumCatchUpTicks;
+	}
+
+	Clock::time_point nextDeadline = getDeadline(ticksTaken);
+	if (currentTime < nextDeadline) {
+		return 0;
+	}
+
+	Clock::duration lag = currentTime - nextDeadline;
+	if (lag > maximumLag) {
+		maximumLag = lag;
+	}
+
+	std::chrono::duration<double, Clock::period> tickInterval = std::chrono::duration<double, Clock::period>(baseTickInterval) / speedMultiplier;
+	size_t dueTicks = static_cast<size_t>((currentTime - runStartTime) / tickInterval) + 1 - ticksTaken;
+	if (dueTicks > 1) {
+		overrunCount++;
+	}
+	if (dueTicks > maximumCatchUpTicks) {
+		skippedDeadlineCount += dueTicks - maximumCatchUpTicks;
+		dueTicks = maximumCatchUpTicks;
+		start(currentTime + std::chrono::duration_cast<Clock::duration>(tickInterval));
+		return dueTicks;
+	}
+
+	ticksTaken += dueTicks;
+	return dueTicks;
+}
+
+void Elevator::TickPacer::waitForNextTick() const {
+	if (isPaced()) {
+		std::this_thread::sleep_until(getNextDeadline());
+	}
+}
+
+//Changing the speed rebases the run, so the next tick is one new interval from now
+bool Elevator::TickPacer::setSpeed(double newSpeedMultiplier) {
+	if (newSpeedMultiplier != 0 && (newSpeedMultiplier < MINIMUM_SPEED || newSpeedMultiplier > MAXIMUM_SPEED)) {
+		return false;
+	}
+
+	speedMultiplier = newSpeedMultiplier;
+	start(Clock::now());
+	if (isPaced()) {
+		ticksTaken = 1;
+	}
+	return true;
+}
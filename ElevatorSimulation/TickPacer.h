@@ -0,0 +1,76 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+
+namespace Elevator {
+
+	//Schedules ticks against absolute deadlines on the steady clock, so the time spent ticking and drawing does not add to each interval and the run does not drift.
+	//Tick k of a run is due at the start of the run plus k intervals. The interval is the base interval divided by the speed, and a speed of 0 runs unpaced.
+	//When the caller falls behind, the ticks that are overdue are returned together so they can be run back to back, and drawn once.
+	//A run that falls more than the maximum catch up behind skips the deadlines it missed rather than racing to catch up, e.g. after the machine was suspended.
+	class TickPacer {
+		public:
+			typedef std::chrono::steady_clock Clock;
+
+			TickPacer(Clock::duration baseTickInterval);				//The interval between ticks at a speed of 1
+
+			void start(Clock::time_point startTime);					//Starts a run, with its first tick due at startTime
+			size_t takeDueTicks(Clock::time_point currentTime);			//How many ticks to run now, between 0 and the maximum catch up. They are counted as run.
+			void waitForNextTick() const;								//Sleeps until the next tick is due. Returns at once when unpaced.
+
+			bool setSpeed(double speedMultiplier);						//Returns false, and keeps the speed, if it is not 0 or between MINIMUM_SPEED and MAXIMUM_SPEED
+			double getSpeed() const;
+			bool isPaced() const;
+			void setMaximumCatchUpTicks(size_t maximumTicks);			//1 never batches ticks, so the deadline of every late tick is skipped
+			Clock::time_point getNextDeadline() const;
+
+			size_t getOverrunCount() const;								//How many times ticks were taken late enough that more than one was due
+			size_t getSkippedDeadlineCount() const;						//Deadlines given up on, as they were more than the maximum catch up behind. Their ticks still run, later.
+			Clock::duration getMaximumLag() const;						//The latest a tick has been taken after its deadline
+
+			static const double MINIMUM_SPEED;
+			static const double MAXIMUM_SPEED;
+
+		private:
+			Clock::time_point getDeadline(size_t tickNumber) const;
+
+			const Clock::duration baseTickInterval;
+			double speedMultiplier;
+			size_t maximumCatchUpTicks;
+			Clock::time_point runStartTime;		//Rebased when the speed changes or deadlines are skipped, so deadlines are never accumulated from rounded intervals
+			size_t ticksTaken;					//Ticks taken since runStartTime
+
+			size_t overrunCount;
+			size_t skippedDeadlineCount;
+			Clock::duration maximumLag;
+	};
+
+	//Inline member functions
+	inline double TickPacer::getSpeed() const {
+		return speedMultiplier;
+	}
+
+	inline bool TickPacer::isPaced() const {
+		return speedMultiplier > 0;
+	}
+
+	inline void TickPacer::setMaximumCatchUpTicks(size_t maximumTicks) {
+		maximumCatchUpTicks = maximumTicks > 0 ? maximumTicks : 1;
+	}
+
+	inline TickPacer::Clock::time_point TickPacer::getNextDeadline() const {
+		return getDeadline(ticksTaken);
+	}
+
+	inline size_t TickPacer::getOverrunCount() const {
+		return overrunCount;
+	}
+
+	inline size_t TickPacer::getSkippedDeadlineCount() const {
+		return skippedDeadlineCount;
+	}
+
+	inline TickPacer::Clock::duration TickPacer::getMaximumLag() const {
+		return maximumLag;
+	}
+}
@@ -0,0 +1,69 @@
+#include "stdafx.h"
+#include "TickWorkerPool.h"
+
+
+//Starts the worker threads. The calling thread counts as one of the workers.
+Elevator::TickWorkerPool::TickWorkerPool(size_t workerCount) :
+	currentTask(nullptr),
+	generation(0),
+	runningWorkers(0),
+	stopping(false),
+	workerCount(workerCount < 1 ? 1 : workerCount)
+{
+	for (size_t i = 1; i < this->workerCount; i++) {
+		workerThreads.push_back(std::thread(&TickWorkerPool::workerLoop, this, i));
+	}
+}
+
+//Stops and joins the worker threads
+Elevator::TickWorkerPool::~TickWorkerPool() {
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+	for (size_t i = 0; i < workerThreads.size(); i++) {
+		workerThreads[i].join();
+	}
+}
+
+//Waits for each run, and executes this worker's task number
+void Elevator::TickWorkerPool::workerLoop(size_t taskNumber) {
+	size_t lastGeneration = 0;
+	while (true) {
+		const std::function<void(size_t)>* task;
+		{
+			std::unique_lock<std::mutex> lock(poolMutex);
+			workAvailable.wait(lock, [&]() { return stopping || generation != lastGeneration; });
+			if (stopping) {
+				return;
+			}
+			lastGeneration = generation;
+			task = currentTask;
+		}
+
+		(*task)(taskNumber);
+
+		{
+			std::lock_guard<std::mutex> lock(poolMutex);
+			runningWorkers--;
+		}
+		workFinished.notify_one();
+	}
+}
+
+//Runs task(0) to task(workerCount - 1) in parallel, and waits for all of them to finish.
+void Elevator::TickWorkerPool::run(const std::function<void(size_t)>& task) {
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		currentTask = &task;
+		runningWorkers = workerThreads.size();
+		generation++;
+	}
+	workAvailable.notify_all();
+
+	task(0);
+
+	std::unique_lock<std::mutex> lock(poolMutex);
+	workFinished.wait(lock, [&]() { return runningWorkers == 0; });
+}
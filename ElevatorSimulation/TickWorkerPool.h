@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace Elevator {
+
+	//A fixed set of threads that are kept between ticks, so that a tick does not pay for creating threads.
+	//Each run gives every worker one task number, and returns once all of the tasks are finished.
+	class TickWorkerPool {
+		public:
+			TickWorkerPool(size_t workerCount);
+			~TickWorkerPool();
+
+			void run(const std::function<void(size_t)>& task);	//Runs task(0) to task(workerCount - 1) in parallel. The calling thread runs task 0.
+			size_t getWorkerCount() const;
+
+		private:
+			void workerLoop(size_t taskNumber);
+
+			std::vector<std::thread> workerThreads;
+			std::mutex poolMutex;
+			std::condition_variable workAvailable;
+			std::condition_variable workFinished;
+			const std::function<void(size_t)>* currentTask;
+			size_t generation;										//Increases with each run, so workers know when there is new work
+			size_t runningWorkers;
+			bool stopping;
+			const size_t workerCount;
+	};
+
+	//Inline member functions
+	inline size_t TickWorkerPool::getWorkerCount() const {
+		return workerCount;
+	}
+}
@@ -0,0 +1,77 @@
+#include "stdafx.h"
+#include "Tracing.h"
+
+#ifdef ELEVATOR_TRACING
+#include <fstream>
+#include <iomanip>
+
+#define TRACE_BUFFER_EVENTS 65536				//Events kept per thread
+#define TRACE_FILE_NAME "ElevatorTrace.json"
+
+//The calling thread's buffer, owned by the recorder
+static thread_local Elevator::TraceBuffer* threadTraceBuffer = nullptr;
+
+
+Elevator::TraceBuffer::TraceBuffer(size_t threadNumber) :
+	events(TRACE_BUFFER_EVENTS),
+	nextEvent(0),
+	eventCount(0),
+	threadNumber(threadNumber)
+{
+}
+
+//Writes the buffer's events as Chrome complete events, oldest first. Times are in microseconds, with three decimal places so no nanoseconds are lost.
+//With the default six significant digits, start times past the first second lose their sub-microsecond part and switch to exponent notation.
+void Elevator::TraceBuffer::writeEvents(std::ostream& outStream, bool& firstEvent) const {
+	outStream << std::fixed << std::setprecision(3);
+	size_t firstIndex = eventCount < events.size() ? 0 : nextEvent;
+	for (size_t i = 0; i < eventCount; i++) {
+		const TraceEvent& traceEvent = events[(firstIndex + i) % events.size()];
+		outStream << (firstEvent ? "\n" : ",\n");
+		outStream << "{\"name\":\"" << traceEvent.name << "\",\"cat\":\"elevator\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadNumber
+			<< ",\"ts\":" << traceEvent.startNanoseconds / 1000.0 << ",\"dur\":" << traceEvent.durationNanoseconds / 1000.0 << "}";
+		firstEvent = false;
+	}
+}
+
+Elevator::TraceRecorder::TraceRecorder() :
+	startTime(std::chrono::steady_clock::now())
+{
+}
+
+//Created on first use, and destroyed on exit, after main has returned and the worker threads have been joined
+Elevator::TraceRecorder& Elevator::TraceRecorder::instance() {
+	static TraceRecorder traceRecorder;
+	return traceRecorder;
+}
+
+Elevator::TraceRecorder::~TraceRecorder() {
+	std::ofstream traceFile(TRACE_FILE_NAME);
+	if (!traceFile.is_open()) {
+		std::cerr << "Unable to write the trace file: " << TRACE_FILE_NAME << std::endl;
+		return;
+	}
+	writeChromeTrace(traceFile);
+}
+
+Elevator::TraceBuffer& Elevator::TraceRecorder::getThreadBuffer() {
+	if (threadTraceBuffer == nullptr) {
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		traceBuffers.push_back(std::unique_ptr<TraceBuffer>(new TraceBuffer(traceBuffers.size() + 1)));
+		threadTraceBuffer = traceBuffers.back().get();
+	}
+	return *threadTraceBuffer;
+}
+
+//Writes every thread's events in the Chrome trace event format
+void Elevator::TraceRecorder::writeChromeTrace(std::ostream& outStream) {
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	bool firstEvent = true;
+	outStream << "{\"traceEvents\":[";
+	for (size_t i = 0; i < traceBuffers.size(); i++) {
+		traceBuffers[i]->writeEvents(outStream, firstEvent);
+	}
+	outStream << "\n],\"displayTimeUnit\":\"ns\"}" << std::endl;
+}
+
+#endif
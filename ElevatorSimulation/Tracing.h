@@ -0,0 +1,103 @@
+#pragma once
+
+//Scoped timers for finding where the time in a tick goes.
+//TRACE_SCOPE("name") times the rest of the enclosing scope. Each thread records into its own ring buffer, so recording never waits on a lock,
+//and only the most recent events are kept. The events of every thread are written as Chrome trace event JSON (chrome://tracing) on exit.
+//Tracing is only compiled in when ELEVATOR_TRACING is defined. Otherwise TRACE_SCOPE expands to nothing, and costs nothing.
+#ifdef ELEVATOR_TRACING
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#define TRACE_CONCATENATE_INNER(first, second) first##second
+#define TRACE_CONCATENATE(first, second) TRACE_CONCATENATE_INNER(first, second)
+#define TRACE_SCOPE(name) Elevator::TraceScope TRACE_CONCATENATE(traceScope, __LINE__)(name)
+
+namespace Elevator {
+
+	//A completed scope. The name must be a string literal, as only the pointer is kept.
+	struct TraceEvent {
+		const char* name;
+		int64_t startNanoseconds;
+		int64_t durationNanoseconds;
+	};
+
+	//The most recent events of one thread. Only the owning thread writes to it.
+	class TraceBuffer {
+		public:
+			TraceBuffer(size_t threadNumber);
+
+			void record(const char* name, int64_t startNanoseconds, int64_t durationNanoseconds);
+			void writeEvents(std::ostream& outStream, bool& firstEvent) const;
+
+		private:
+			std::vector<TraceEvent> events;
+			size_t nextEvent;							//Where the next event is written, overwriting the oldest once the buffer is full
+			size_t eventCount;
+			const size_t threadNumber;
+	};
+
+	//Owns every thread's buffer, so events outlive the threads that recorded them, and writes them all out on exit
+	class TraceRecorder {
+		public:
+			static TraceRecorder& instance();
+			~TraceRecorder();							//Writes the trace file
+
+			TraceBuffer& getThreadBuffer();				//Returns the calling thread's buffer, creating it on first use
+			int64_t nanosecondsSinceStart() const;
+			void writeChromeTrace(std::ostream& outStream);
+
+		private:
+			TraceRecorder();
+
+			std::mutex buffersMutex;					//Only held when a thread first records, and when writing the trace
+			std::vector<std::unique_ptr<TraceBuffer>> traceBuffers;
+			const std::chrono::steady_clock::time_point startTime;
+	};
+
+	//Times the scope it is declared in
+	class TraceScope {
+		public:
+			TraceScope(const char* name);
+			~TraceScope();
+
+		private:
+			const char* name;
+			int64_t startNanoseconds;
+	};
+
+	//Inline member functions
+
+	inline int64_t TraceRecorder::nanosecondsSinceStart() const {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+	}
+
+	inline void TraceBuffer::record(const char* name, int64_t startNanoseconds, int64_t durationNanoseconds) {
+		TraceEvent& traceEvent = events[nextEvent];
+		traceEvent.name = name;
+		traceEvent.startNanoseconds = startNanoseconds;
+		traceEvent.durationNanoseconds = durationNanoseconds;
+		nextEvent = nextEvent + 1 == events.size() ? 0 : nextEvent + 1;
+		eventCount = eventCount < events.size() ? eventCount + 1 : eventCount;
+	}
+
+	inline TraceScope::TraceScope(const char* name) :
+		name(name),
+		startNanoseconds(TraceRecorder::instance().nanosecondsSinceStart())
+	{}
+
+	inline TraceScope::~TraceScope() {
+		TraceRecorder& traceRecorder = TraceRecorder::instance();
+		traceRecorder.getThreadBuffer().record(name, startNanoseconds, traceRecorder.nanosecondsSinceStart() - startNanoseconds);
+	}
+}
+
+#else
+
+#define TRACE_SCOPE(name)
+
+#endif
@@ -0,0 +1,162 @@
+#include "stdafx.h"
+#include "TrafficGenerator.h"
+#include <cmath>
+#include <algorithm>
+
+#define LOBBY_FLOOR 0
+
+
+Elevator::TrafficGenerator::TrafficGenerator(int numberOfFloors, const TrafficProfile& trafficProfile, double peakArrivalsPerTick, uint64_t seed) :
+	numberOfFloors(numberOfFloors),
+	trafficProfile(trafficProfile),
+	peakArrivalsPerTick(peakArrivalsPerTick),
+	maximumRate(0),
+	cycleTicks(0),
+	currentTime(0),
+	randomGenerator(seed),
+	unitDistribution(0.0, 1.0)
+{
+	for (size_t i = 0; i < trafficProfile.size(); i++) {
+		maximumRate = std::max(maximumRate, std::max(trafficProfile[i].startArrivalRate, trafficProfile[i].endArrivalRate));
+		cycleTicks += trafficProfile[i].durationTicks;
+	}
+}
+
+//Generates the next arrival, by thinning candidates that arrive at the maximum rate.
+//Returns false if the profile never has any arrivals.
+bool Elevator::TrafficGenerator::next(PassengerArrival& passengerArrival) {
+	double candidateRate = maximumRate * peakArrivalsPerTick;
+	if (cycleTicks == 0 || candidateRate <= 0) {
+		return false;
+	}
+
+	while (true) {
+		//Gaps between arrivals in a Poisson process are exponentially distributed
+		currentTime -= std::log(1.0 - unitDistribution(randomGenerator)) / candidateRate;
+
+		size_t segmentIndex;
+		double arrivalRate = arrivalRateAt(currentTime, segmentIndex);
+		if (unitDistribution(randomGenerator) * maximumRate < arrivalRate) {
+			passengerArrival.tick = static_cast<size_t>(currentTime);
+			chooseFloors(trafficProfile[segmentIndex], passengerArrival);
+			return true;
+		}
+	}
+}
+
+//The arrival rate at a time, as a fraction of the peak rate. The profile repeats, so any time is valid.
+double Elevator::TrafficGenerator::arrivalRateAt(double time, size_t& segmentIndex) const {
+	double cycleTime = std::fmod(time, static_cast<double>(cycleTicks));
+	for (segmentIndex = 0; segmentIndex + 1 < trafficProfile.size(); segmentIndex++) {
+		if (cycleTime < trafficProfile[segmentIndex].durationTicks) {
+			break;
+		}
+		cycleTime -= trafficProfile[segmentIndex].durationTicks;
+	}
+
+	const TrafficSegment& trafficSegment = trafficProfile[segmentIndex];
+	double segmentProgress = trafficSegment.durationTicks > 0 ? std::min(cycleTime / trafficSegment.durationTicks, 1.0) : 0;
+	return trafficSegment.startArrivalRate + (trafficSegment.endArrivalRate - trafficSegment.startArrivalRate) * segmentProgress;
+}
+
+//Chooses where a passenger is travelling from and to, based on the segment's weights.
+//Inter floor trips need two floors above the lobby, so smaller buildings use the lobby instead.
+void Elevator::TrafficGenerator::chooseFloors(const TrafficSegment& trafficSegment, PassengerArrival& passengerArrival) {
+	int upperFloors = numberOfFloors - 1;
+	std::uniform_int_distribution<int> upperFloorDistribution(LOBBY_FLOOR + 1, numberOfFloors - 1);
+
+	double totalWeight = trafficSegment.fromLobbyWeight + trafficSegment.toLobbyWeight + trafficSegment.interFloorWeight;
+	double choice = unitDistribution(randomGenerator) * totalWeight;
+
+	if (choice >= trafficSegment.fromLobbyWeight + trafficSegment.toLobbyWeight && upperFloors >= 2) {
+		passengerArrival.originFloor = upperFloorDistribution(randomGenerator);
+		do {
+			passengerArrival.destinationFloor = upperFloorDistribution(randomGenerator);
+		} while (passengerArrival.destinationFloor == passengerArrival.originFloor);
+		return;
+	}
+
+	if (choice < trafficSegment.fromLobbyWeight) {
+		passengerArrival.originFloor = LOBBY_FLOOR;
+		passengerArrival.destinationFloor = upperFloorDistribution(randomGenerator);
+	}
+	else {
+		passengerArrival.originFloor = upperFloorDistribution(randomGenerator);
+		passengerArrival.destinationFloor = LOBBY_FLOOR;
+	}
+}
+
+//Most passengers travel from the lobby up, building to a peak and tailing off
+Elevator::TrafficProfile Elevator::TrafficGenerator::upPeakProfile() {
+	TrafficProfile trafficProfile = {
+		{ 1000, 0.2, 1.0, 0.85, 0.05, 0.10 },
+		{ 1000, 1.0, 0.2, 0.85, 0.05, 0.10 },
+	};
+	return trafficProfile;
+}
+
+//Passengers travel to and from the lobby in equal numbers
+Elevator::TrafficProfile Elevator::TrafficGenerator::lunchProfile() {
+	TrafficProfile trafficProfile = {
+		{ 1000, 0.3, 0.6, 0.45, 0.45, 0.10 },
+		{ 1000, 0.6, 0.3, 0.45, 0.45, 0.10 },
+	};
+	return trafficProfile;
+}
+
+//Most passengers travel down to the lobby, building to a peak and tailing off
+Elevator::TrafficProfile Elevator::TrafficGenerator::downPeakProfile() {
+	TrafficProfile trafficProfile = {
+		{ 1000, 0.2, 1.0, 0.05, 0.85, 0.10 },
+		{ 1000, 1.0, 0.2, 0.05, 0.85, 0.10 },
+	};
+	return trafficProfile;
+}
+
+//Passengers travel between the upper floors, at a steady rate
+Elevator::TrafficProfile Elevator::TrafficGenerator::interFloorProfile() {
+	TrafficProfile trafficProfile = {
+		{ 2000, 0.4, 0.4, 0.10, 0.10, 0.80 },
+	};
+	return trafficProfile;
+}
+
+//A whole day, which repeats for multi day runs
+Elevator::TrafficProfile Elevator::TrafficGenerator::dayProfile() {
+	TrafficProfile trafficProfile = {
+		{ 6000, 0.02, 0.02, 0.30, 0.30, 0.40 },		//Night
+		{ 1000, 0.02, 1.00, 0.85, 0.05, 0.10 },		//Morning up peak
+		{ 1000, 1.00, 0.30, 0.85, 0.05, 0.10 },
+		{ 2000, 0.30, 0.30, 0.10, 0.10, 0.80 },		//Morning inter floor traffic
+		{ 1000, 0.30, 0.60, 0.45, 0.45, 0.10 },		//Lunch
+		{ 1000, 0.60, 0.30, 0.45, 0.45, 0.10 },
+		{ 2000, 0.30, 0.30, 0.10, 0.10, 0.80 },		//Afternoon inter floor traffic
+		{ 1000, 0.30, 1.00, 0.05, 0.85, 0.10 },		//Evening down peak
+		{ 1000, 1.00, 0.02, 0.05, 0.85, 0.10 },
+		{ 4000, 0.02, 0.02, 0.30, 0.30, 0.40 },		//Night
+	};
+	return trafficProfile;
+}
+
+//Looks up one of the built in profiles by name. Returns false if there is no profile with that name.
+bool Elevator::TrafficGenerator::profileFromName(const std::string& profileName, TrafficProfile& trafficProfile) {
+	if (profileName == "UpPeak") {
+		trafficProfile = upPeakProfile();
+	}
+	else if (profileName == "Lunch") {
+		trafficProfile = lunchProfile();
+	}
+	else if (profileName == "DownPeak") {
+		trafficProfile = downPeakProfile();
+	}
+	else if (profileName == "InterFloor") {
+		trafficProfile = interFloorProfile();
+	}
+	else if (profileName == "Day") {
+		trafficProfile = dayProfile();
+	}
+	else {
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+#include <random>
+#include <string>
+#include <cstdint>
+
+namespace Elevator {
+
+	//A passenger arriving at a floor, wanting to travel to another floor
+	struct PassengerArrival {
+		size_t tick;				//The tick before which the passenger arrives
+		int originFloor;
+		int destinationFloor;
+	};
+
+	//A period of the traffic profile. The arrival rate changes linearly from the start rate to the end rate over the segment.
+	//Each passenger is travelling from the lobby, to the lobby, or between two other floors, chosen with the given weights.
+	struct TrafficSegment {
+		size_t durationTicks;
+		double startArrivalRate;	//Passengers per tick, as a fraction of the generator's peak rate
+		double endArrivalRate;
+		double fromLobbyWeight;
+		double toLobbyWeight;
+		double interFloorWeight;
+	};
+
+	//The segments of a traffic profile, which repeat once the last segment ends
+	typedef std::vector<TrafficSegment> TrafficProfile;
+
+	//Generates passenger arrivals as a Poisson process with a rate that changes over time.
+	//Arrivals are made by thinning: candidates are generated at the peak rate, and each is kept with a chance of the current rate over the peak rate.
+	//Arrivals are generated one at a time when asked for, so a run of any length uses the same amount of memory.
+	class TrafficGenerator {
+		public:
+			TrafficGenerator(int numberOfFloors, const TrafficProfile& trafficProfile, double peakArrivalsPerTick, uint64_t seed);
+
+			bool next(PassengerArrival& passengerArrival);		//Generates the next arrival. Returns false if the profile never has any arrivals.
+
+			static TrafficProfile upPeakProfile();				//Most passengers travel from the lobby up, as in the morning
+			static TrafficProfile lunchProfile();				//Passengers travel to and from the lobby in equal numbers
+			static TrafficProfile downPeakProfile();			//Most passengers travel down to the lobby, as in the evening
+			static TrafficProfile interFloorProfile();			//Passengers travel between the upper floors
+			static TrafficProfile dayProfile();					//A whole day: a quiet night, the up peak, lunch, and the down peak
+			static bool profileFromName(const std::string& profileName, TrafficProfile& trafficProfile);	//Returns false if there is no profile with that name
+
+		private:
+			double arrivalRateAt(double time, size_t& segmentIndex) const;	//The arrival rate at a time, as a fraction of the peak rate
+			void chooseFloors(const TrafficSegment& trafficSegment, PassengerArrival& passengerArrival);
+
+			const int numberOfFloors;
+			const TrafficProfile trafficProfile;
+			const double peakArrivalsPerTick;
+			double maximumRate;									//The highest rate in the profile, as a fraction of the peak rate
+			size_t cycleTicks;									//Length of the whole profile
+			double currentTime;									//Time of the last candidate arrival, in ticks
+
+			std::mt19937_64 randomGenerator;
+			std::uniform_real_distribution<double> unitDistribution;
+	};
+}
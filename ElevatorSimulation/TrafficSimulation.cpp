@@ -0,0 +1,75 @@
+#include "stdafx.h"
+#include "TrafficSimulation.h"
+#include <algorithm>
+
+#define PEAK_ARRIVALS_PER_SHAFT 0.05	//Passengers per tick for each shaft, at the busiest point of a profile
+
+
+TrafficSimulation::TrafficSimulation(Elevator::ElevatorController* elevatorControllerPtr, const Elevator::TrafficProfile& trafficProfile, uint64_t seed) :
+	elevatorControllerPtr(elevatorControllerPtr),
+	trafficGenerator(elevatorControllerPtr->getCurrentState().simulationSettings.numberOfFloors, trafficProfile,
+		elevatorControllerPtr->getCurrentState().simulationSettings.numberOfShafts * PEAK_ARRIVALS_PER_SHAFT, seed),
+	ticksRun(0),
+	passengersArrived(0),
+	mostPassengersWaiting(0),
+	elapsedTime(0)
+{
+	//Nobody is watching a generated run, so skip the display and the wait between ticks
+	elevatorControllerPtr->setDisplayEnabled(false);
+}
+
+//Runs the generated traffic for a number of ticks. Passengers arriving on a tick are added before that tick is simulated.
+//A pacer holds each tick until it is due. Ticks that fell behind are run back to back until the run has caught up.
+void TrafficSimulation::run(size_t numberOfTicks, Elevator::TickPacer* tickPacerPtr) {
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	size_t dueTicks = 0;
+	if (tickPacerPtr) {
+		tickPacerPtr->start(startTime);
+	}
+
+	Elevator::PassengerArrival passengerArrival;
+	bool hasArrival = trafficGenerator.next(passengerArrival);
+	for (size_t tick = 0; tick < numberOfTicks; tick++) {
+		while (hasArrival && passengerArrival.tick <= tick) {
+			elevatorControllerPtr->addPassenger(passengerArrival.originFloor, passengerArrival.destinationFloor);
+			passengersArrived++;
+			hasArrival = trafficGenerator.next(passengerArrival);
+		}
+		mostPassengersWaiting = std::max(mostPassengersWaiting, elevatorControllerPtr->getPassengerTracker().getWaitingPassengerCount());
+
+		while (tickPacerPtr && dueTicks == 0) {
+			tickPacerPtr->waitForNextTick();
+			dueTicks = tickPacerPtr->takeDueTicks(std::chrono::steady_clock::now());
+		}
+		dueTicks = dueTicks > 0 ? dueTicks - 1 : 0;
+
+		elevatorControllerPtr->simulationTick();
+		ticksRun++;
+	}
+
+	elapsedTime = std::chrono::steady_clock::now() - startTime;
+}
+
+void TrafficSimulation::printLatencyRow(std::ostream& outStream, const char* label, const Elevator::LatencyHistogram& latencyHistogram) {
+	outStream << label << " ticks p50/p90/p99/max: " << latencyHistogram.getPercentile(50) << "/" << latencyHistogram.getPercentile(90) << "/"
+		<< latencyHistogram.getPercentile(99) << "/" << latencyHistogram.getMaximum() << " (mean " << latencyHistogram.getMean() << ")" << std::endl;
+}
+
+//Prints the results of the last run
+void TrafficSimulation::printSummary(std::ostream& outStream) const {
+	const Elevator::SimulationSettings& simulationSettings = elevatorControllerPtr->getCurrentState().simulationSettings;
+	double elapsedSeconds = elapsedTime.count();
+
+	outStream << "Traffic run complete." << std::endl;
+	outStream << "Floors: " << simulationSettings.numberOfFloors << ", Shafts: " << simulationSettings.numberOfShafts
+		<< ", Dispatch: " << Elevator::getDispatchPolicyName(simulationSettings.dispatchPolicy) << std::endl;
+	outStream << "Ticks: " << ticksRun << std::endl;
+	const Elevator::PassengerTracker& passengerTracker = elevatorControllerPtr->getPassengerTracker();
+	outStream << "Passengers arrived: " << passengersArrived << " (" << passengerTracker.getWaitingPassengerCount() << " still waiting, "
+		<< passengerTracker.getRidingPassengerCount() << " still riding)" << std::endl;
+	outStream << "Most passengers waiting at once: " << mostPassengersWaiting << std::endl;
+	printLatencyRow(outStream, "Wait", passengerTracker.getBuildingWaitHistogram());
+	printLatencyRow(outStream, "Journey", passengerTracker.getBuildingJourneyHistogram());
+	outStream << "Elapsed seconds: " << elapsedSeconds << std::endl;
+	outStream << "Ticks per second: " << (elapsedSeconds > 0 ? ticksRun / elapsedSeconds : 0) << std::endl;
+}
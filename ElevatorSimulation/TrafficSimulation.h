@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <iostream>
+#include <chrono>
+#include "ElevatorState.h"
+#include "ElevatorController.h"
+#include "TrafficGenerator.h"
+#include "TickPacer.h"
+
+//Drives the controller with passengers from a traffic generator, headless and as fast as possible, or paced in real time.
+//Each arriving passenger is added to the controller, which calls an elevator for them and tracks them to their destination.
+//Only the passengers currently travelling are stored, so memory does not grow with the length of the run.
+class TrafficSimulation
+{
+	public:
+		TrafficSimulation(Elevator::ElevatorController* elevatorControllerPtr, const Elevator::TrafficProfile& trafficProfile, uint64_t seed);
+
+		void run(size_t numberOfTicks, Elevator::TickPacer* tickPacerPtr = nullptr);	//Without a pacer, the ticks run as fast as possible
+		void printSummary(std::ostream& outStream) const;
+
+	private:
+		static void printLatencyRow(std::ostream& outStream, const char* label, const Elevator::LatencyHistogram& latencyHistogram);
+
+		Elevator::ElevatorController* elevatorControllerPtr;
+		Elevator::TrafficGenerator trafficGenerator;
+
+		//Results of the last run
+		size_t ticksRun;
+		size_t passengersArrived;
+		size_t mostPassengersWaiting;
+		std::chrono::duration<double> elapsedTime;
+};
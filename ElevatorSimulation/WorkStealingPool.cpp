@@ -0,0 +1,66 @@
+#include "stdafx.h"
+#include "WorkStealingPool.h"
+
+
+Elevator::WorkStealingPool::WorkStealingPool(size_t workerCount) :
+	stolenJobCount(0),
+	workerCount(workerCount < 1 ? 1 : workerCount)
+{
+	for (size_t i = 0; i < this->workerCount; i++) {
+		workerQueues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+	}
+}
+
+//Deals the jobs out to the workers, and runs them. The calling thread is worker 0.
+//No new jobs are added during a run, so a worker can stop as soon as it finds every queue empty.
+void Elevator::WorkStealingPool::run(size_t jobCount, const std::function<void(size_t)>& job) {
+	stolenJobCount = 0;
+	for (size_t i = 0; i < jobCount; i++) {
+		workerQueues[i % workerCount]->jobs.push_back(i);
+	}
+
+	std::vector<std::thread> workerThreads;
+	for (size_t i = 1; i < workerCount; i++) {
+		workerThreads.push_back(std::thread(&WorkStealingPool::workerLoop, this, i, std::cref(job)));
+	}
+
+	workerLoop(0, job);
+	for (size_t i = 0; i < workerThreads.size(); i++) {
+		workerThreads[i].join();
+	}
+}
+
+//Runs this worker's own jobs, then steals from the others until there is nothing left
+void Elevator::WorkStealingPool::workerLoop(size_t worker, const std::function<void(size_t)>& job) {
+	size_t jobNumber;
+	while (takeOwnJob(worker, jobNumber) || stealJob(worker, jobNumber)) {
+		job(jobNumber);
+	}
+}
+
+//Takes the most recently dealt job from the worker's own queue
+bool Elevator::WorkStealingPool::takeOwnJob(size_t worker, size_t& jobNumber) {
+	WorkerQueue& workerQueue = *workerQueues[worker];
+	std::lock_guard<std::mutex> lock(workerQueue.queueMutex);
+	if (workerQueue.jobs.empty()) {
+		return false;
+	}
+	jobNumber = workerQueue.jobs.back();
+	workerQueue.jobs.pop_back();
+	return true;
+}
+
+//Takes the oldest job from another worker's queue, starting with the next worker along so that thieves spread out
+bool Elevator::WorkStealingPool::stealJob(size_t worker, size_t& jobNumber) {
+	for (size_t i = 1; i < workerCount; i++) {
+		WorkerQueue& victimQueue = *workerQueues[(worker + i) % workerCount];
+		std::lock_guard<std::mutex> lock(victimQueue.queueMutex);
+		if (!victimQueue.jobs.empty()) {
+			jobNumber = victimQueue.jobs.front();
+			victimQueue.jobs.pop_front();
+			stolenJobCount++;
+			return true;
+		}
+	}
+	return false;
+}
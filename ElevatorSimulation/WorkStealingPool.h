@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+namespace Elevator {
+
+	//Runs a fixed number of independent jobs across a set of threads.
+	//The jobs are dealt out to one queue per worker up front. Each worker takes jobs from the back of its own queue,
+	//and once it is empty, steals from the front of the other workers' queues, so workers that were dealt cheap jobs help out with expensive ones.
+	//Jobs can finish in any order, so callers should store results by job number rather than by completion.
+	class WorkStealingPool {
+		public:
+			WorkStealingPool(size_t workerCount);
+
+			void run(size_t jobCount, const std::function<void(size_t)>& job);	//Runs job(0) to job(jobCount - 1), and returns once all of them have finished
+			size_t getWorkerCount() const;
+			size_t getStolenJobCount() const;									//Jobs run by a worker other than the one they were dealt to, in the last run
+
+		private:
+			struct WorkerQueue {
+				std::mutex queueMutex;
+				std::deque<size_t> jobs;
+			};
+
+			void workerLoop(size_t worker, const std::function<void(size_t)>& job);
+			bool takeOwnJob(size_t worker, size_t& jobNumber);
+			bool stealJob(size_t worker, size_t& jobNumber);
+
+			std::vector<std::unique_ptr<WorkerQueue>> workerQueues;
+			std::atomic<size_t> stolenJobCount;
+			const size_t workerCount;
+	};
+
+	//Inline member functions
+
+	inline size_t WorkStealingPool::getWorkerCount() const {
+		return workerCount;
+	}
+
+	inline size_t WorkStealingPool::getStolenJobCount() const {
+		return stolenJobCount;
+	}
+}